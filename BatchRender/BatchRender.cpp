@@ -0,0 +1,389 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __APPLE__
+    // MacOS fix for bug inside USD.
+    #define unary_function __unary_function
+#endif
+
+#include <pxr/pxr.h>
+#include <pxr/base/tf/errorMark.h>
+
+// Hydra Core
+#include <pxr/imaging/hd/engine.h>
+#include <pxr/imaging/hd/renderBuffer.h>
+#include <pxr/imaging/hd/rendererPlugin.h>
+#include <pxr/imaging/hd/rendererPluginRegistry.h>
+
+// HDX (Hydra Utilities)
+#include <pxr/imaging/hdx/renderTask.h>
+#include <pxr/imaging/hdx/taskController.h>
+
+// USD Hydra Scene Delegate Implementation.
+#include <pxr/usdImaging/usdImaging/delegate.h>
+#include <pxr/usd/usdGeom/camera.h>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb/stb_image_write.h>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+// Options
+// ---------------------
+
+struct Options
+{
+    std::string stagePath;
+    std::string cameraPath;
+    std::string outputPattern = "frame.####.png";
+
+    int frameStart = 1;
+    int frameEnd   = 1;
+    int frameStep  = 1;
+
+    int width  = 1920;
+    int height = 1080;
+
+    // Encoder threads, defaults to half the hardware threads (the other half renders).
+    int writerCount = 0;
+};
+
+static void PrintUsage()
+{
+    std::cout << "Usage: BatchRender <stage.usd> [options]"                                                     << std::endl
+              << "  --camera <path>           Camera prim to render from (default: first camera in the stage)." << std::endl
+              << "  --frames <start> <end>    Inclusive frame range (default: 1 1)."                             << std::endl
+              << "  --step <n>                Frame increment (default: 1)."                                     << std::endl
+              << "  --resolution <w> <h>      Image size (default: 1920 1080)."                                  << std::endl
+              << "  --output <pattern>        Output path, #### is replaced by the frame number (default: frame.####.png)." << std::endl
+              << "  --writers <n>             Encoder threads (default: half the hardware threads)."             << std::endl;
+}
+
+static bool ParseOptions(int argc, char** argv, Options* options)
+{
+    if (argc < 2)
+        return false;
+
+    options->stagePath = argv[1];
+
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+
+        // Number of values following the flag.
+        auto HasValues = [&](int count) { return i + count < argc; };
+
+        if (arg == "--camera" && HasValues(1))
+        {
+            options->cameraPath = argv[++i];
+        }
+        else if (arg == "--frames" && HasValues(2))
+        {
+            options->frameStart = std::atoi(argv[++i]);
+            options->frameEnd   = std::atoi(argv[++i]);
+        }
+        else if (arg == "--step" && HasValues(1))
+        {
+            options->frameStep = std::atoi(argv[++i]);
+        }
+        else if (arg == "--resolution" && HasValues(2))
+        {
+            options->width  = std::atoi(argv[++i]);
+            options->height = std::atoi(argv[++i]);
+        }
+        else if (arg == "--output" && HasValues(1))
+        {
+            options->outputPattern = argv[++i];
+        }
+        else if (arg == "--writers" && HasValues(1))
+        {
+            options->writerCount = std::atoi(argv[++i]);
+        }
+        else
+        {
+            std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (options->width <= 0 || options->height <= 0 || options->frameStep <= 0 || options->frameEnd < options->frameStart)
+    {
+        std::cerr << "Invalid resolution or frame range." << std::endl;
+        return false;
+    }
+
+    if (options->writerCount <= 0)
+        options->writerCount = std::max(1, (int)std::thread::hardware_concurrency() / 2);
+
+    return true;
+}
+
+// Replace the run of '#' in the pattern with the zero-padded frame number (appended if there is none).
+static std::string ResolveOutputPath(std::string const& pattern, int frame)
+{
+    size_t first = pattern.find('#');
+
+    if (first == std::string::npos)
+        return pattern + "." + std::to_string(frame);
+
+    size_t last = pattern.find_first_not_of('#', first);
+    size_t padding = (last == std::string::npos ? pattern.size() : last) - first;
+
+    std::string number = std::to_string(frame);
+
+    if (number.size() < padding)
+        number.insert(0, padding - number.size(), '0');
+
+    return pattern.substr(0, first) + number + (last == std::string::npos ? "" : pattern.substr(last));
+}
+
+// Image Writer
+// ---------------------
+
+// Encodes frames on its own threads, so rendering only ever pays for a copy of the pixels.
+// The queue is unbounded: if encoding can't keep up the backlog grows in memory rather than stalling the renderer.
+class ImageWriter
+{
+public:
+    ImageWriter(int threadCount) : m_Stop(false), m_Failures(0u)
+    {
+        for (int i = 0; i < threadCount; ++i)
+            m_Threads.emplace_back([this]() { _Run(); });
+    }
+
+    ~ImageWriter()
+    {
+        Flush();
+    }
+
+    // Queue a frame for encoding, takes ownership of the pixels.
+    void Write(std::string const& path, int width, int height, std::vector<uint8_t>&& pixels)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Jobs.push_back({ path, width, height, std::move(pixels) });
+        }
+
+        m_JobAvailable.notify_one();
+    }
+
+    // Wait for every queued frame to be written and stop the threads.
+    void Flush()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stop = true;
+        }
+
+        m_JobAvailable.notify_all();
+
+        for (auto& thread : m_Threads)
+            thread.join();
+
+        m_Threads.clear();
+    }
+
+    uint32_t GetFailureCount() const { return m_Failures; }
+
+private:
+
+    struct Job
+    {
+        std::string          path;
+        int                  width, height;
+        std::vector<uint8_t> pixels;
+    };
+
+    void _Run()
+    {
+        for (;;)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_JobAvailable.wait(lock, [this]() { return m_Stop || !m_Jobs.empty(); });
+
+                // Drain the queue before stopping.
+                if (m_Jobs.empty())
+                    return;
+
+                job = std::move(m_Jobs.front());
+                m_Jobs.pop_front();
+            }
+
+            if (stbi_write_png(job.path.c_str(), job.width, job.height, 4, job.pixels.data(), 4 * job.width) == 0)
+            {
+                std::cerr << "Failed to write " << job.path << std::endl;
+                m_Failures++;
+            }
+        }
+    }
+
+    std::vector<std::thread> m_Threads;
+
+    std::mutex              m_Mutex;
+    std::condition_variable m_JobAvailable;
+    std::deque<Job>         m_Jobs;
+    bool                    m_Stop;
+
+    std::atomic<uint32_t> m_Failures;
+};
+
+// Implementation
+// ---------------------
+
+int main(int argc, char **argv, char **envp)
+{
+    Options options;
+
+    if (!ParseOptions(argc, argv, &options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    // Favor encode speed over file size, preview sequences are written once and viewed a few times.
+    stbi_write_png_compression_level = 1;
+
+    // AOV rows are bottom-up, PNG rows are top-down.
+    stbi_flip_vertically_on_write(1);
+
+    // Load Render Plugin
+    // ---------------------
+
+    // NOTE: For GetRendererPlugin() to successfully find the token, ensure the PXR_PLUGINPATH_NAME env variable is set.
+    HdRendererPlugin *rendererPlugin = HdRendererPluginRegistry::GetInstance().GetRendererPlugin(TfToken("RendererPlugin"));
+
+    if (rendererPlugin == nullptr)
+    {
+        std::cerr << "Failed to load the render delegate plugin (is PXR_PLUGINPATH_NAME set?)." << std::endl;
+        return 1;
+    }
+
+    HdRenderDelegate *renderDelegate = rendererPlugin->CreateRenderDelegate();
+    TF_VERIFY(renderDelegate != nullptr);
+
+    // No driver is passed, so the delegate creates its own offscreen device and submits to it itself.
+    HdRenderIndex *renderIndex = HdRenderIndex::New(renderDelegate, {});
+    TF_VERIFY(renderIndex != nullptr);
+
+    // Load the USD Stage.
+    // ---------------------
+
+    UsdStageRefPtr usdStage = UsdStage::Open(options.stagePath);
+
+    if (usdStage == nullptr)
+    {
+        std::cerr << "Failed to open stage " << options.stagePath << std::endl;
+        return 1;
+    }
+
+    UsdImagingDelegate *sceneDelegate = new UsdImagingDelegate(renderIndex, SdfPath::AbsoluteRootPath());
+    sceneDelegate->Populate(usdStage->GetPseudoRoot());
+
+    // Resolve the camera.
+    // ---------------------
+
+    SdfPath cameraPath;
+
+    if (!options.cameraPath.empty())
+    {
+        cameraPath = SdfPath(options.cameraPath);
+    }
+    else
+    {
+        for (UsdPrim const& prim : usdStage->Traverse())
+        {
+            if (prim.IsA<UsdGeomCamera>())
+            {
+                cameraPath = prim.GetPath();
+                break;
+            }
+        }
+    }
+
+    if (cameraPath.IsEmpty() || !UsdGeomCamera(usdStage->GetPrimAtPath(cameraPath)))
+    {
+        std::cerr << "No camera to render from, pass one with --camera." << std::endl;
+        return 1;
+    }
+
+    // Create the render tasks.
+    // ---------------------
+
+    // No GPU tasks (present, color correction...), the color AOV is read back directly.
+    HdxTaskController taskController(renderIndex, SdfPath("/taskController"), false);
+    {
+        GfVec4d viewport(0.0, 0.0, (double)options.width, (double)options.height);
+
+        taskController.SetRenderParams(HdxRenderTaskParams());
+        taskController.SetRenderViewport(viewport);
+        taskController.SetRenderBufferSize(GfVec2i(options.width, options.height));
+        taskController.SetCameraPath(sceneDelegate->ConvertCachePathToIndexPath(cameraPath));
+        taskController.SetRenderOutputs({ HdAovTokens->color });
+    }
+
+    HdEngine engine;
+
+    ImageWriter writer(options.writerCount);
+
+    // Render-loop
+    // ---------------------
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    uint32_t frameCount = 0u;
+
+    for (int frame = options.frameStart; frame <= options.frameEnd; frame += options.frameStep)
+    {
+        sceneDelegate->SetTime(UsdTimeCode((double)frame));
+
+        // Invoke Hydra!
+        auto renderTasks = taskController.GetRenderingTasks();
+        engine.Execute(renderIndex, &renderTasks);
+
+        HdRenderBuffer* color = taskController.GetRenderOutput(HdAovTokens->color);
+
+        if (color == nullptr || color->GetFormat() != HdFormatUNorm8Vec4)
+        {
+            std::cerr << "The color output is missing or not 8-bit RGBA." << std::endl;
+            return 1;
+        }
+
+        // Wait for the copy into the AOV, then take the pixels so the next frame can render into it.
+        color->Resolve();
+
+        std::vector<uint8_t> pixels(4u * color->GetWidth() * color->GetHeight());
+
+        memcpy(pixels.data(), color->Map(), pixels.size());
+        color->Unmap();
+
+        writer.Write(ResolveOutputPath(options.outputPattern, frame), (int)color->GetWidth(), (int)color->GetHeight(), std::move(pixels));
+
+        frameCount++;
+    }
+
+    // Throughput counts the frames as written, not just rendered.
+    writer.Flush();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    std::cout << "Wrote " << frameCount << " frames in " << seconds << "s (" << (double)frameCount / std::max(seconds, 1e-6) << " frames/s)." << std::endl;
+
+    delete sceneDelegate;
+    delete renderIndex;
+
+    rendererPlugin->DeleteRenderDelegate(renderDelegate);
+
+    return writer.GetFailureCount() == 0u ? 0 : 1;
+}
@@ -0,0 +1,421 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __APPLE__
+    // MacOS fix for bug inside USD.
+    #define unary_function __unary_function
+#endif
+
+#include <pxr/pxr.h>
+#include <pxr/base/gf/frustum.h>
+#include <pxr/base/gf/matrix4d.h>
+#include <pxr/base/gf/rotation.h>
+#include <pxr/base/tf/stringUtils.h>
+
+// Hydra Core
+#include <pxr/imaging/hd/renderBuffer.h>
+#include <pxr/imaging/hd/renderIndex.h>
+#include <pxr/imaging/hd/rendererPlugin.h>
+#include <pxr/imaging/hd/rendererPluginRegistry.h>
+#include <pxr/imaging/hd/task.h>
+#include <pxr/imaging/hd/unitTestDelegate.h>
+
+// HDX (Hydra Utilities)
+#include <pxr/imaging/hdx/renderTask.h>
+#include <pxr/imaging/hdx/taskController.h>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+using Clock = std::chrono::steady_clock;
+
+// Options
+// ---------------------
+
+struct Options
+{
+    // One synthetic stage is built and measured per entry.
+    std::vector<uint32_t> meshCounts = { 1u, 100u, 10000u };
+
+    uint32_t trianglesPerMesh = 128u;
+
+    uint32_t warmupIterations = 10u;
+    uint32_t iterations       = 100u;
+
+    // Fraction of meshes whose transform is edited every iteration (0 measures the steady state).
+    float dirtyFraction = 0.0f;
+
+    int width  = 1280;
+    int height = 720;
+
+    // Rasterize on the CPU instead of the device.
+    bool software = false;
+
+    // JSON destination, stdout if empty.
+    std::string outputPath;
+};
+
+static void PrintUsage()
+{
+    std::cout << "Usage: Benchmark [options]"                                                                         << std::endl
+              << "  --meshes <n,n,...>     Mesh counts, one synthetic stage each (default: 1,100,10000)."               << std::endl
+              << "  --triangles <n>        Triangles per mesh (default: 128)."                                          << std::endl
+              << "  --iterations <n>       Measured iterations per stage (default: 100)."                               << std::endl
+              << "  --warmup <n>           Unmeasured iterations per stage (default: 10)."                              << std::endl
+              << "  --dirty <fraction>     Fraction of meshes moved every iteration (default: 0)."                      << std::endl
+              << "  --resolution <w> <h>   Render size (default: 1280 720)."                                            << std::endl
+              << "  --software             Use the CPU rasterizer instead of the Vulkan device."                        << std::endl
+              << "  --output <path>        Write the JSON report to a file instead of stdout."                          << std::endl
+              << "Runs on the delegate's offscreen device. To benchmark on a software ICD (e.g. lavapipe),"             << std::endl
+              << "point VK_ICD_FILENAMES at its manifest."                                                               << std::endl;
+}
+
+static bool ParseOptions(int argc, char** argv, Options* options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+
+        // Number of values following the flag.
+        auto HasValues = [&](int count) { return i + count < argc; };
+
+        if (arg == "--meshes" && HasValues(1))
+        {
+            options->meshCounts.clear();
+
+            std::stringstream list(argv[++i]);
+
+            for (std::string count; std::getline(list, count, ',');)
+                options->meshCounts.push_back((uint32_t)std::strtoul(count.c_str(), nullptr, 10));
+        }
+        else if (arg == "--triangles" && HasValues(1))
+        {
+            options->trianglesPerMesh = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--iterations" && HasValues(1))
+        {
+            options->iterations = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--warmup" && HasValues(1))
+        {
+            options->warmupIterations = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--dirty" && HasValues(1))
+        {
+            options->dirtyFraction = std::clamp((float)std::atof(argv[++i]), 0.0f, 1.0f);
+        }
+        else if (arg == "--resolution" && HasValues(2))
+        {
+            options->width  = std::atoi(argv[++i]);
+            options->height = std::atoi(argv[++i]);
+        }
+        else if (arg == "--software")
+        {
+            options->software = true;
+        }
+        else if (arg == "--output" && HasValues(1))
+        {
+            options->outputPath = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (options->meshCounts.empty() || options->iterations == 0u || options->trianglesPerMesh == 0u || options->width <= 0 || options->height <= 0)
+    {
+        std::cerr << "Invalid mesh counts, iterations, triangle count or resolution." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// Synthetic Stage
+// ---------------------
+
+// Triangulated grid in the unit square with (at least) the requested number of triangles.
+struct GridMesh
+{
+    VtVec3fArray points;
+    VtIntArray   faceVertexCounts;
+    VtIntArray   faceVertexIndices;
+};
+
+static GridMesh BuildGridMesh(uint32_t triangleCount)
+{
+    uint32_t cells = (uint32_t)std::ceil(std::sqrt((double)triangleCount / 2.0));
+
+    GridMesh mesh;
+
+    for (uint32_t y = 0u; y <= cells; ++y)
+    {
+        for (uint32_t x = 0u; x <= cells; ++x)
+        {
+            float u = (float)x / (float)cells;
+            float v = (float)y / (float)cells;
+
+            // A little relief so the mesh has real normals.
+            mesh.points.push_back(GfVec3f(u - 0.5f, v - 0.5f, 0.1f * std::sin(6.0f * u) * std::cos(6.0f * v)));
+        }
+    }
+
+    for (uint32_t y = 0u; y < cells; ++y)
+    {
+        for (uint32_t x = 0u; x < cells; ++x)
+        {
+            int i0 = (int)(y * (cells + 1u) + x);
+            int i1 = i0 + 1;
+            int i2 = i0 + (int)(cells + 1u);
+            int i3 = i2 + 1;
+
+            int triangles[6] = { i0, i1, i3, i0, i3, i2 };
+
+            for (int t = 0; t < 2; ++t)
+            {
+                mesh.faceVertexCounts.push_back(3);
+
+                for (int k = 0; k < 3; ++k)
+                    mesh.faceVertexIndices.push_back(triangles[3 * t + k]);
+            }
+        }
+    }
+
+    return mesh;
+}
+
+// Meshes are placed on a cubic lattice (1.5 units apart, leaving gaps between them), centered on the origin.
+static GfMatrix4f GetLatticeTransform(uint32_t index, uint32_t side, float offset)
+{
+    float x = (float)(index % side);
+    float y = (float)((index / side) % side);
+    float z = (float)(index / (side * side));
+
+    float center = 0.5f * (float)(side - 1u);
+
+    return GfMatrix4f(1.0f).SetTranslate(GfVec3f(x - center + offset, y - center, z - center) * 1.5f);
+}
+
+// Statistics
+// ---------------------
+
+struct Phase
+{
+    char const*         name;
+    std::vector<double> samples;
+};
+
+static double Percentile(std::vector<double> sorted, double p)
+{
+    std::sort(sorted.begin(), sorted.end());
+
+    // Nearest-rank percentile.
+    size_t rank = (size_t)std::ceil(p / 100.0 * (double)sorted.size());
+
+    return sorted[std::clamp(rank, (size_t)1u, sorted.size()) - 1u];
+}
+
+static void WritePhaseJSON(std::ostream& out, Phase const& phase)
+{
+    double mean = 0.0;
+
+    for (double sample : phase.samples)
+        mean += sample;
+
+    mean /= (double)phase.samples.size();
+
+    out << "\"" << phase.name << "\": { "
+        << "\"min\": "  << Percentile(phase.samples, 0.0)   << ", "
+        << "\"p50\": "  << Percentile(phase.samples, 50.0)  << ", "
+        << "\"p90\": "  << Percentile(phase.samples, 90.0)  << ", "
+        << "\"p99\": "  << Percentile(phase.samples, 99.0)  << ", "
+        << "\"max\": "  << Percentile(phase.samples, 100.0) << ", "
+        << "\"mean\": " << mean << " }";
+}
+
+// Benchmark
+// ---------------------
+
+// Build a stage with the given mesh count and time every phase of the Hydra frame over many iterations.
+// The phases are the ones HdEngine::Execute runs, issued one at a time so they can be timed separately.
+static std::vector<Phase> RunBenchmark(HdRendererPlugin* rendererPlugin, Options const& options, uint32_t meshCount)
+{
+    HdRenderSettingsMap settings;
+    settings[TfToken("SoftwareRendering")] = VtValue(options.software);
+
+    HdRenderDelegate* renderDelegate = rendererPlugin->CreateRenderDelegate(settings);
+
+    // No driver is passed, so the delegate renders on its own offscreen device.
+    HdRenderIndex* renderIndex = HdRenderIndex::New(renderDelegate, {});
+
+    HdUnitTestDelegate* sceneDelegate = new HdUnitTestDelegate(renderIndex, SdfPath("/Benchmark"));
+
+    GridMesh mesh = BuildGridMesh(options.trianglesPerMesh);
+
+    uint32_t side = std::max(1u, (uint32_t)std::ceil(std::cbrt((double)meshCount)));
+
+    std::vector<SdfPath> meshIds(meshCount);
+
+    for (uint32_t i = 0u; i < meshCount; ++i)
+    {
+        meshIds[i] = SdfPath(TfStringPrintf("/Benchmark/Mesh%u", i));
+
+        sceneDelegate->AddMesh(meshIds[i], GetLatticeTransform(i, side, 0.0f), mesh.points, mesh.faceVertexCounts, mesh.faceVertexIndices);
+    }
+
+    HdxTaskController taskController(renderIndex, SdfPath("/Benchmark/TaskController"), false);
+    {
+        taskController.SetRenderParams(HdxRenderTaskParams());
+        taskController.SetRenderViewport(GfVec4d(0.0, 0.0, (double)options.width, (double)options.height));
+        taskController.SetRenderBufferSize(GfVec2i(options.width, options.height));
+        taskController.SetRenderOutputs({ HdAovTokens->color });
+
+        // Frame the whole lattice from a corner.
+        double extent = 1.5 * (double)side;
+
+        GfFrustum frustum;
+        frustum.SetPerspective(45.0, (double)options.width / (double)options.height, 0.1, 10.0 * extent);
+        frustum.SetPosition(GfVec3d(1.2 * extent, 0.9 * extent, 1.5 * extent));
+        frustum.SetRotation(GfRotation(GfVec3d(0.0, 0.0, -1.0), -frustum.GetPosition()));
+
+        taskController.SetFreeCameraMatrices(frustum.ComputeViewMatrix(), frustum.ComputeProjectionMatrix());
+    }
+
+    std::vector<Phase> phases = { { "sync" }, { "commit" }, { "execute" }, { "readback" }, { "total" } };
+
+    uint32_t dirtyCount = (uint32_t)std::ceil(options.dirtyFraction * (float)meshCount);
+
+    for (uint32_t iteration = 0u; iteration < options.warmupIterations + options.iterations; ++iteration)
+    {
+        // Move a rotating window of meshes back and forth, which dirties their transforms.
+        for (uint32_t i = 0u; i < dirtyCount; ++i)
+        {
+            uint32_t index = (iteration * dirtyCount + i) % meshCount;
+
+            sceneDelegate->UpdateTransform(meshIds[index], GetLatticeTransform(index, side, (iteration & 1u) ? 0.25f : 0.0f));
+        }
+
+        HdTaskSharedPtrVector tasks = taskController.GetRenderingTasks();
+        HdTaskContext         taskContext;
+
+        auto t0 = Clock::now();
+
+        // Rprim sync (ExMesh::Sync) and task sync.
+        renderIndex->SyncAll(&tasks, &taskContext);
+
+        auto t1 = Clock::now();
+
+        renderDelegate->CommitResources(&renderIndex->GetChangeTracker());
+
+        auto t2 = Clock::now();
+
+        // Render task execution (ExRenderPass::_Execute), including the submit.
+        for (auto const& task : tasks)
+            task->Prepare(&taskContext, renderIndex);
+
+        for (auto const& task : tasks)
+            task->Execute(&taskContext);
+
+        auto t3 = Clock::now();
+
+        // Wait for the frame to land in the color AOV.
+        if (HdRenderBuffer* color = taskController.GetRenderOutput(HdAovTokens->color))
+            color->Resolve();
+
+        auto t4 = Clock::now();
+
+        if (iteration < options.warmupIterations)
+            continue;
+
+        auto Milliseconds = [](Clock::time_point a, Clock::time_point b) { return std::chrono::duration<double, std::milli>(b - a).count(); };
+
+        phases[0].samples.push_back(Milliseconds(t0, t1));
+        phases[1].samples.push_back(Milliseconds(t1, t2));
+        phases[2].samples.push_back(Milliseconds(t2, t3));
+        phases[3].samples.push_back(Milliseconds(t3, t4));
+        phases[4].samples.push_back(Milliseconds(t0, t4));
+    }
+
+    delete sceneDelegate;
+    delete renderIndex;
+
+    rendererPlugin->DeleteRenderDelegate(renderDelegate);
+
+    return phases;
+}
+
+// Implementation
+// ---------------------
+
+int main(int argc, char **argv, char **envp)
+{
+    Options options;
+
+    if (!ParseOptions(argc, argv, &options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    // NOTE: For GetRendererPlugin() to successfully find the token, ensure the PXR_PLUGINPATH_NAME env variable is set.
+    HdRendererPlugin* rendererPlugin = HdRendererPluginRegistry::GetInstance().GetRendererPlugin(TfToken("RendererPlugin"));
+
+    if (rendererPlugin == nullptr)
+    {
+        std::cerr << "Failed to load the render delegate plugin (is PXR_PLUGINPATH_NAME set?)." << std::endl;
+        return 1;
+    }
+
+    std::ostringstream json;
+
+    json << "{" << std::endl
+         << "  \"units\": \"ms\"," << std::endl
+         << "  \"trianglesPerMesh\": " << options.trianglesPerMesh << "," << std::endl
+         << "  \"iterations\": " << options.iterations << "," << std::endl
+         << "  \"dirtyFraction\": " << options.dirtyFraction << "," << std::endl
+         << "  \"resolution\": [" << options.width << ", " << options.height << "]," << std::endl
+         << "  \"software\": " << (options.software ? "true" : "false") << "," << std::endl
+         << "  \"stages\": [" << std::endl;
+
+    for (size_t i = 0u; i < options.meshCounts.size(); ++i)
+    {
+        std::cerr << "Benchmarking " << options.meshCounts[i] << " meshes..." << std::endl;
+
+        std::vector<Phase> phases = RunBenchmark(rendererPlugin, options, std::max(options.meshCounts[i], 1u));
+
+        json << "    { \"meshes\": " << options.meshCounts[i] << ", \"phases\": {" << std::endl;
+
+        for (size_t p = 0u; p < phases.size(); ++p)
+        {
+            json << "      ";
+            WritePhaseJSON(json, phases[p]);
+            json << (p + 1u < phases.size() ? "," : "") << std::endl;
+        }
+
+        json << "    } }" << (i + 1u < options.meshCounts.size() ? "," : "") << std::endl;
+    }
+
+    json << "  ]" << std::endl << "}" << std::endl;
+
+    if (options.outputPath.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream file(options.outputPath);
+        file << json.str();
+    }
+
+    HdRendererPluginRegistry::GetInstance().ReleasePlugin(rendererPlugin);
+
+    return 0;
+}
@@ -0,0 +1,308 @@
+#include <ExampleDelegate/ExBoundsHierarchy.h>
+#include <ExampleDelegate/ExDrawTable.h>
+
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <functional>
+
+// Maximum number of slots held by a leaf.
+static constexpr uint32_t kMaxLeafItems = 4u;
+
+// Subtrees handed to the parallel traversal. Enough to keep every worker busy, few enough to gather serially.
+static constexpr size_t kCullTaskCount = 64u;
+
+ExFrustum ExFrustum::FromViewProjection(GfMatrix4f const& viewProjection)
+{
+    // Row-vector convention (clip = p * M), so each clip component is a column of the matrix.
+    auto Column = [&](int i)
+    {
+        return GfVec4f(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    };
+
+    GfVec4f x = Column(0), y = Column(1), z = Column(2), w = Column(3);
+
+    ExFrustum frustum;
+    frustum.planes[0] = w + x;
+    frustum.planes[1] = w - x;
+    frustum.planes[2] = w + y;
+    frustum.planes[3] = w - y;
+    frustum.planes[4] = z;
+    frustum.planes[5] = w - z;
+
+    return frustum;
+}
+
+ExFrustum::Containment ExFrustum::Classify(GfRange3f const& bounds) const
+{
+    if (bounds.IsEmpty())
+        return Outside;
+
+    GfVec3f const& min = bounds.GetMin();
+    GfVec3f const& max = bounds.GetMax();
+
+    Containment result = Inside;
+
+    for (GfVec4f const& plane : planes)
+    {
+        // Corner furthest along the plane normal, and the one furthest against it.
+        GfVec3f positive(plane[0] >= 0.0f ? max[0] : min[0], plane[1] >= 0.0f ? max[1] : min[1], plane[2] >= 0.0f ? max[2] : min[2]);
+        GfVec3f negative(plane[0] >= 0.0f ? min[0] : max[0], plane[1] >= 0.0f ? min[1] : max[1], plane[2] >= 0.0f ? min[2] : max[2]);
+
+        if (plane[0] * positive[0] + plane[1] * positive[1] + plane[2] * positive[2] + plane[3] < 0.0f)
+            return Outside;
+
+        if (plane[0] * negative[0] + plane[1] * negative[1] + plane[2] * negative[2] + plane[3] < 0.0f)
+            result = Intersecting;
+    }
+
+    return result;
+}
+
+ExBoundsHierarchy::ExBoundsHierarchy() : m_SlotCount(0u), m_RefitCount(0u)
+{
+}
+
+void ExBoundsHierarchy::Update(ExDrawTable const& drawTable, std::vector<uint32_t> const& dirtySlots)
+{
+    // New slots have no leaf to refit into, and after enough refits the median splits no longer
+    // reflect where things are (i.e. animated scenes), so start over in either case.
+    if (drawTable.GetSlotCount() != m_SlotCount || m_RefitCount + dirtySlots.size() > m_SlotCount / 2u)
+        _Build(drawTable);
+    else if (!dirtySlots.empty())
+        _Refit(drawTable, dirtySlots);
+}
+
+void ExBoundsHierarchy::_Build(ExDrawTable const& drawTable)
+{
+    m_SlotCount  = drawTable.GetSlotCount();
+    m_RefitCount = 0u;
+
+    m_Nodes     .clear();
+    m_Parents   .clear();
+    m_Items     .resize(m_SlotCount);
+    m_LeafOfSlot.resize(m_SlotCount);
+    m_SlotBounds.resize(m_SlotCount);
+
+    if (m_SlotCount == 0u)
+        return;
+
+    std::vector<GfVec3f> centroids(m_SlotCount);
+
+    for (uint32_t slot = 0u; slot < m_SlotCount; ++slot)
+    {
+        m_Items[slot]      = slot;
+        m_SlotBounds[slot] = drawTable.GetBounds(slot);
+
+        // Empty slots cluster at the origin, they are never visible and rarely stay empty for long.
+        centroids[slot] = m_SlotBounds[slot].IsEmpty() ? GfVec3f(0.0f) : m_SlotBounds[slot].GetMidpoint();
+    }
+
+    m_Nodes  .reserve(2u * m_SlotCount / kMaxLeafItems + 1u);
+    m_Parents.reserve(m_Nodes.capacity());
+
+    m_Nodes  .push_back(Node());
+    m_Parents.push_back(UINT32_MAX);
+
+    _BuildRecursive(0u, 0u, m_SlotCount, centroids);
+}
+
+uint32_t ExBoundsHierarchy::_BuildRecursive(uint32_t nodeIndex, uint32_t begin, uint32_t end, std::vector<GfVec3f> const& centroids)
+{
+    GfRange3f bounds, centroidBounds;
+
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        bounds.UnionWith(m_SlotBounds[m_Items[i]]);
+        centroidBounds.UnionWith(centroids[m_Items[i]]);
+    }
+
+    if (end - begin <= kMaxLeafItems)
+    {
+        m_Nodes[nodeIndex] = { bounds, begin, end - begin };
+
+        for (uint32_t i = begin; i < end; ++i)
+            m_LeafOfSlot[m_Items[i]] = nodeIndex;
+
+        return nodeIndex;
+    }
+
+    // Median split along the axis the centroids spread the most.
+    GfVec3f extent = centroidBounds.GetSize();
+
+    int axis = extent[0] > extent[1] ? (extent[0] > extent[2] ? 0 : 2) : (extent[1] > extent[2] ? 1 : 2);
+
+    uint32_t middle = begin + (end - begin) / 2u;
+
+    std::nth_element(m_Items.begin() + begin, m_Items.begin() + middle, m_Items.begin() + end,
+                     [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+
+    // Children are allocated as a pair after the parent, so every child index is greater than its parent's.
+    uint32_t left = (uint32_t)m_Nodes.size();
+
+    m_Nodes  .resize(left + 2u);
+    m_Parents.resize(left + 2u, nodeIndex);
+
+    m_Nodes[nodeIndex] = { bounds, left, 0u };
+
+    _BuildRecursive(left,      begin,  middle, centroids);
+    _BuildRecursive(left + 1u, middle, end,    centroids);
+
+    return nodeIndex;
+}
+
+void ExBoundsHierarchy::_Refit(ExDrawTable const& drawTable, std::vector<uint32_t> const& dirtySlots)
+{
+    m_RefitCount += (uint32_t)dirtySlots.size();
+
+    // Gather the leaves and their ancestors, stopping at the first ancestor already gathered.
+    std::vector<uint8_t>  visited(m_Nodes.size(), 0u);
+    std::vector<uint32_t> refitNodes;
+
+    for (uint32_t slot : dirtySlots)
+    {
+        m_SlotBounds[slot] = drawTable.GetBounds(slot);
+
+        for (uint32_t node = m_LeafOfSlot[slot]; node != UINT32_MAX && !visited[node]; node = m_Parents[node])
+        {
+            visited[node] = 1u;
+            refitNodes.push_back(node);
+        }
+    }
+
+    // Children come after their parents, so refitting in descending order finishes every child first.
+    std::sort(refitNodes.begin(), refitNodes.end(), std::greater<uint32_t>());
+
+    for (uint32_t nodeIndex : refitNodes)
+    {
+        Node& node = m_Nodes[nodeIndex];
+
+        node.bounds = GfRange3f();
+
+        if (node.count > 0u)
+        {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i)
+                node.bounds.UnionWith(m_SlotBounds[m_Items[i]]);
+        }
+        else
+        {
+            node.bounds.UnionWith(m_Nodes[node.first     ].bounds);
+            node.bounds.UnionWith(m_Nodes[node.first + 1u].bounds);
+        }
+    }
+}
+
+void ExBoundsHierarchy::Cull(ExFrustum const& frustum, std::vector<uint32_t>* visible) const
+{
+    visible->clear();
+
+    if (m_Nodes.empty())
+        return;
+
+    struct Task
+    {
+        uint32_t node;
+        bool     inside;
+    };
+
+    // Expand the top of the tree breadth-first (culling as we go) until there are enough subtrees to go wide.
+    std::vector<Task> tasks = { { 0u, false } };
+
+    for (bool expanded = true; expanded && tasks.size() < kCullTaskCount;)
+    {
+        std::vector<Task> next;
+        expanded = false;
+
+        for (Task const& task : tasks)
+        {
+            Node const& node = m_Nodes[task.node];
+
+            ExFrustum::Containment containment = task.inside ? ExFrustum::Inside : frustum.Classify(node.bounds);
+
+            if (containment == ExFrustum::Outside)
+                continue;
+
+            if (containment == ExFrustum::Inside || node.count > 0u)
+            {
+                next.push_back({ task.node, containment == ExFrustum::Inside });
+                continue;
+            }
+
+            next.push_back({ node.first,      false });
+            next.push_back({ node.first + 1u, false });
+            expanded = true;
+        }
+
+        tasks.swap(next);
+    }
+
+    std::vector<std::vector<uint32_t>> taskVisible(tasks.size());
+
+    WorkParallelForN(tasks.size(), [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            _CullSubtree(frustum, tasks[i].node, tasks[i].inside, &taskVisible[i]);
+    });
+
+    for (auto const& slots : taskVisible)
+        visible->insert(visible->end(), slots.begin(), slots.end());
+
+    // Draw in slot order, which keeps the indirect commands (and the GPU's walk over the heap) stable frame to frame.
+    std::sort(visible->begin(), visible->end());
+}
+
+void ExBoundsHierarchy::_CullSubtree(ExFrustum const& frustum, uint32_t nodeIndex, bool inside, std::vector<uint32_t>* visible) const
+{
+    if (inside)
+    {
+        _CollectSubtree(nodeIndex, visible);
+        return;
+    }
+
+    Node const& node = m_Nodes[nodeIndex];
+
+    ExFrustum::Containment containment = frustum.Classify(node.bounds);
+
+    if (containment == ExFrustum::Outside)
+        return;
+
+    if (containment == ExFrustum::Inside)
+    {
+        _CollectSubtree(nodeIndex, visible);
+        return;
+    }
+
+    if (node.count > 0u)
+    {
+        for (uint32_t i = node.first; i < node.first + node.count; ++i)
+        {
+            if (frustum.Classify(m_SlotBounds[m_Items[i]]) != ExFrustum::Outside)
+                visible->push_back(m_Items[i]);
+        }
+
+        return;
+    }
+
+    _CullSubtree(frustum, node.first,      false, visible);
+    _CullSubtree(frustum, node.first + 1u, false, visible);
+}
+
+void ExBoundsHierarchy::_CollectSubtree(uint32_t nodeIndex, std::vector<uint32_t>* visible) const
+{
+    Node const& node = m_Nodes[nodeIndex];
+
+    if (node.count > 0u)
+    {
+        // Empty slots can sit inside a visible node without being drawable themselves.
+        for (uint32_t i = node.first; i < node.first + node.count; ++i)
+        {
+            if (!m_SlotBounds[m_Items[i]].IsEmpty())
+                visible->push_back(m_Items[i]);
+        }
+
+        return;
+    }
+
+    _CollectSubtree(node.first,      visible);
+    _CollectSubtree(node.first + 1u, visible);
+}
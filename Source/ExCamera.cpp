@@ -0,0 +1,50 @@
+#include <ExampleDelegate/ExCamera.h>
+
+ExCamera::ExCamera(SdfPath const& id) : HdCamera(id), m_WorldToView(1.0), m_Projection(1.0), m_Version(0u)
+{
+}
+
+void ExCamera::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam, HdDirtyBits* dirtyBits)
+{
+    HdDirtyBits bits = *dirtyBits;
+
+    HdCamera::Sync(sceneDelegate, renderParam, dirtyBits);
+
+    if ((bits & HdCamera::AllDirty) == HdCamera::Clean)
+        return;
+
+    m_WorldToView = GetTransform().GetInverse();
+    m_Projection  = ComputeProjectionMatrix();
+
+    m_Version++;
+}
+
+static float RadicalInverse(uint32_t index, uint32_t base)
+{
+    float result   = 0.0f;
+    float fraction = 1.0f / (float)base;
+
+    for (; index > 0u; index /= base, fraction /= (float)base)
+        result += (float)(index % base) * fraction;
+
+    return result;
+}
+
+GfVec2f ExComputeJitter(uint32_t sampleIndex)
+{
+    // Index zero of the sequence is the origin, skip it so that every sample is offset.
+    return GfVec2f(RadicalInverse(sampleIndex + 1u, 2u) - 0.5f, RadicalInverse(sampleIndex + 1u, 3u) - 0.5f);
+}
+
+GfMatrix4d ExApplyJitter(GfMatrix4d const& projection, GfVec2f const& jitter, uint32_t width, uint32_t height)
+{
+    if (width == 0u || height == 0u)
+        return projection;
+
+    // Shifts clip x / y by w times the offset in NDC, i.e. a constant offset in pixels after the divide.
+    GfMatrix4d offset(1.0);
+    offset[3][0] = 2.0 * (double)jitter[0] / (double)width;
+    offset[3][1] = 2.0 * (double)jitter[1] / (double)height;
+
+    return projection * offset;
+}
@@ -0,0 +1,244 @@
+#include <ExampleDelegate/ExCuller.h>
+#include <ExampleDelegate/ExDrawTable.h>
+#include <ExampleDelegate/ExMesh.h>
+
+#include <pxr/base/work/loops.h>
+#include <pxr/base/trace/trace.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+
+// Width of the coarse depth buffer, the height follows the viewport aspect ratio.
+static constexpr uint32_t kOcclusionWidth = 256u;
+
+// Only meshes covering at least this fraction of the screen are worth rasterizing as occluders.
+static constexpr float kMinOccluderCoverage = 0.02f;
+
+// Upper bound on occluder triangles rasterized per cull.
+static constexpr size_t kOccluderTriangleBudget = 1u << 16u;
+
+// Clip w below which a point is considered behind the eye.
+static constexpr float kNearW = 1e-5f;
+
+static inline float Edge(GfVec3f const& a, GfVec3f const& b, float x, float y)
+{
+    return (b[0] - a[0]) * (y - a[1]) - (b[1] - a[1]) * (x - a[0]);
+}
+
+ExCuller::ExCuller() : m_Width(0u), m_Height(0u)
+{
+}
+
+void ExCuller::Cull(ExBoundsHierarchy const& hierarchy,
+                    ExDrawTable const&       drawTable,
+                    GfMatrix4f const&        viewProjection,
+                    float                    aspectRatio,
+                    bool                     occlusion,
+                    std::vector<uint32_t>*   visible)
+{
+    TRACE_FUNCTION();
+
+    ExFrustum frustum = ExFrustum::FromViewProjection(viewProjection);
+
+    if (!occlusion)
+    {
+        hierarchy.Cull(frustum, visible);
+        return;
+    }
+
+    hierarchy.Cull(frustum, &m_FrustumVisible);
+
+    m_Width  = kOcclusionWidth;
+    m_Height = (uint32_t)std::clamp((float)kOcclusionWidth / std::max(aspectRatio, 1e-3f), 1.0f, (float)kOcclusionWidth);
+
+    m_Depth.assign(m_Width * m_Height, 1.0f);
+
+    m_ScreenBounds.resize(m_FrustumVisible.size());
+
+    WorkParallelForN(m_FrustumVisible.size(), [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            m_ScreenBounds[i] = _ProjectBounds(drawTable.GetBounds(m_FrustumVisible[i]), viewProjection);
+    });
+
+    // Pick occluders by screen coverage of their bounds, largest first.
+    std::vector<std::pair<float, uint32_t>> occluders;
+
+    const float minOccluderArea = kMinOccluderCoverage * (float)(m_Width * m_Height);
+
+    for (size_t i = 0u; i < m_FrustumVisible.size(); ++i)
+    {
+        ScreenBounds const& screenBounds = m_ScreenBounds[i];
+
+        if (screenBounds.clipped)
+            continue;
+
+        float area = (screenBounds.maxX - screenBounds.minX) * (screenBounds.maxY - screenBounds.minY);
+
+        if (area >= minOccluderArea)
+            occluders.push_back({ area, m_FrustumVisible[i] });
+    }
+
+    std::sort(occluders.begin(), occluders.end(), std::greater<std::pair<float, uint32_t>>());
+
+    size_t triangleCount = 0u;
+
+    for (auto const& occluder : occluders)
+    {
+        ExMesh const* mesh = drawTable.GetMesh(occluder.second);
+
+        // The bounds of an instanced mesh span all of its instances, which says nothing about what it occludes.
+        if (mesh->IsInstanced())
+            continue;
+
+        triangleCount += mesh->GetGeometry().indices.size();
+
+        if (triangleCount > kOccluderTriangleBudget)
+            break;
+
+        _RasterizeOccluder(mesh, drawTable.GetTransform(occluder.second) * viewProjection);
+    }
+
+    // The depth buffer is read-only from here on, so the tests can run wide.
+    std::vector<uint8_t> survived(m_FrustumVisible.size());
+
+    WorkParallelForN(m_FrustumVisible.size(), [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            survived[i] = !_IsOccluded(m_ScreenBounds[i]);
+    });
+
+    visible->clear();
+
+    for (size_t i = 0u; i < m_FrustumVisible.size(); ++i)
+    {
+        if (survived[i])
+            visible->push_back(m_FrustumVisible[i]);
+    }
+}
+
+ExCuller::ScreenBounds ExCuller::_ProjectBounds(GfRange3f const& bounds, GfMatrix4f const& viewProjection) const
+{
+    ScreenBounds screenBounds = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX, FLT_MAX, false };
+
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        GfVec4f clip = GfVec4f(bounds.GetCorner(corner)[0], bounds.GetCorner(corner)[1], bounds.GetCorner(corner)[2], 1.0f) * viewProjection;
+
+        if (clip[3] < kNearW)
+        {
+            screenBounds.clipped = true;
+            return screenBounds;
+        }
+
+        float x = (clip[0] / clip[3] * 0.5f + 0.5f) * (float)m_Width;
+        float y = (clip[1] / clip[3] * 0.5f + 0.5f) * (float)m_Height;
+
+        screenBounds.minX     = std::min(screenBounds.minX, x);
+        screenBounds.minY     = std::min(screenBounds.minY, y);
+        screenBounds.maxX     = std::max(screenBounds.maxX, x);
+        screenBounds.maxY     = std::max(screenBounds.maxY, y);
+        screenBounds.minDepth = std::min(screenBounds.minDepth, clip[2] / clip[3]);
+    }
+
+    return screenBounds;
+}
+
+void ExCuller::_RasterizeOccluder(ExMesh const* mesh, GfMatrix4f const& objectToClip)
+{
+    ExMeshGeometry const& geometry = mesh->GetGeometry();
+
+    // Project every vertex once, z < 0 flags a vertex behind the eye.
+    std::vector<GfVec3f> vertices(geometry.positions.size());
+
+    for (size_t i = 0u; i < geometry.positions.size(); ++i)
+    {
+        GfVec4f clip = GfVec4f(geometry.positions[i][0], geometry.positions[i][1], geometry.positions[i][2], 1.0f) * objectToClip;
+
+        if (clip[3] < kNearW)
+        {
+            vertices[i] = GfVec3f(0.0f, 0.0f, -1.0f);
+            continue;
+        }
+
+        vertices[i] = GfVec3f((clip[0] / clip[3] * 0.5f + 0.5f) * (float)m_Width,
+                              (clip[1] / clip[3] * 0.5f + 0.5f) * (float)m_Height,
+                              clip[2] / clip[3]);
+    }
+
+    for (GfVec3i const& triangle : geometry.indices)
+    {
+        GfVec3f v0 = vertices[triangle[0]], v1 = vertices[triangle[1]], v2 = vertices[triangle[2]];
+
+        // Triangles crossing the near plane are skipped rather than clipped, which only ever loses occlusion.
+        if (v0[2] < 0.0f || v1[2] < 0.0f || v2[2] < 0.0f)
+            continue;
+
+        float area = Edge(v0, v1, v2[0], v2[1]);
+
+        if (std::abs(area) < 1e-8f)
+            continue;
+
+        // Occluders are double-sided, normalize the winding.
+        if (area < 0.0f)
+        {
+            std::swap(v1, v2);
+            area = -area;
+        }
+
+        int minX = std::max((int)std::floor(std::min({ v0[0], v1[0], v2[0] })), 0);
+        int minY = std::max((int)std::floor(std::min({ v0[1], v1[1], v2[1] })), 0);
+        int maxX = std::min((int)std::ceil (std::max({ v0[0], v1[0], v2[0] })), (int)m_Width  - 1);
+        int maxY = std::min((int)std::ceil (std::max({ v0[1], v1[1], v2[1] })), (int)m_Height - 1);
+
+        for (int y = minY; y <= maxY; ++y)
+        {
+            for (int x = minX; x <= maxX; ++x)
+            {
+                float px = (float)x + 0.5f;
+                float py = (float)y + 0.5f;
+
+                float w0 = Edge(v1, v2, px, py);
+                float w1 = Edge(v2, v0, px, py);
+                float w2 = Edge(v0, v1, px, py);
+
+                if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                    continue;
+
+                float depth = (w0 * v0[2] + w1 * v1[2] + w2 * v2[2]) / area;
+
+                float& texel = m_Depth[y * m_Width + x];
+                texel = std::min(texel, depth);
+            }
+        }
+    }
+}
+
+bool ExCuller::_IsOccluded(ScreenBounds const& screenBounds) const
+{
+    if (screenBounds.clipped)
+        return false;
+
+    int minX = std::max((int)std::floor(screenBounds.minX), 0);
+    int minY = std::max((int)std::floor(screenBounds.minY), 0);
+    int maxX = std::min((int)std::floor(screenBounds.maxX), (int)m_Width  - 1);
+    int maxY = std::min((int)std::floor(screenBounds.maxY), (int)m_Height - 1);
+
+    // Passed the frustum test, so keep it if the rectangle somehow falls off the buffer.
+    if (minX > maxX || minY > maxY)
+        return false;
+
+    // Hidden only if every covered texel has something nearer than the closest point of the box.
+    for (int y = minY; y <= maxY; ++y)
+    {
+        for (int x = minX; x <= maxX; ++x)
+        {
+            if (m_Depth[y * m_Width + x] >= screenBounds.minDepth)
+                return false;
+        }
+    }
+
+    return true;
+}
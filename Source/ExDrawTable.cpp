@@ -0,0 +1,244 @@
+#include <ExampleDelegate/ExDrawTable.h>
+#include <ExampleDelegate/ExMesh.h>
+#include <ExampleDelegate/ExInstancer.h>
+
+#include <algorithm>
+#include <iterator>
+
+ExDrawTable::ExDrawTable(VulkanWrappers::Device* device) :
+    m_RecordBuffer    (device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT),
+    m_TransformBuffer (device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT),
+    m_HostOnly        (device == nullptr)
+{
+}
+
+uint32_t ExDrawTable::AcquireSlot(ExMesh* mesh)
+{
+    std::lock_guard<std::mutex> lock(m_SlotMutex);
+
+    uint32_t slot;
+
+    if (!m_FreeSlots.empty())
+    {
+        slot = m_FreeSlots.back();
+        m_FreeSlots.pop_back();
+    }
+    else
+    {
+        slot = (uint32_t)m_Meshes.size();
+
+        m_Meshes.push_back(nullptr);
+        m_Records.push_back({ kInvalidDrawOffset, kInvalidDrawOffset, kInvalidDrawOffset, 0u, 0u, -1, 0u, 0u });
+        m_Features.push_back(0u);
+        m_Lods.push_back({});
+        m_Transforms.push_back(GfMatrix4f(1.0f));
+        m_Bounds.push_back(GfRange3f());
+    }
+
+    m_Meshes[slot] = mesh;
+
+    return slot;
+}
+
+void ExDrawTable::ReleaseSlot(uint32_t slot)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_SlotMutex);
+
+        m_Meshes[slot] = nullptr;
+        m_FreeSlots.push_back(slot);
+    }
+
+    // Clears the GPU record on the next commit.
+    MarkDirty(slot);
+}
+
+void ExDrawTable::MarkDirty(uint32_t slot)
+{
+    m_DirtySlots.push(slot);
+}
+
+void ExDrawTable::MarkTransformDirty(uint32_t slot)
+{
+    m_DirtyTransforms.push(slot);
+}
+
+// Drain a queue into a sorted list without duplicates.
+static void DrainSorted(tbb::concurrent_queue<uint32_t>* queue, std::vector<uint32_t>* slots)
+{
+    slots->clear();
+
+    uint32_t slot;
+    while (queue->try_pop(slot))
+        slots->push_back(slot);
+
+    std::sort(slots->begin(), slots->end());
+    slots->erase(std::unique(slots->begin(), slots->end()), slots->end());
+}
+
+void ExDrawTable::Resolve(std::vector<uint32_t>* dirtySlots, std::vector<uint32_t>* dirtyRecords)
+{
+    std::vector<uint32_t>& dirtyTransforms = m_TransformScratch;
+
+    DrainSorted(&m_DirtySlots,      dirtyRecords);
+    DrainSorted(&m_DirtyTransforms, &dirtyTransforms);
+
+    dirtySlots->clear();
+    std::set_union(dirtyRecords->begin(), dirtyRecords->end(), dirtyTransforms.begin(), dirtyTransforms.end(), std::back_inserter(*dirtySlots));
+
+    // Transform-only slots keep their record, so there are no heap offsets to resolve.
+    for (uint32_t dirtySlot : dirtyTransforms)
+    {
+        ExMesh* mesh = m_Meshes[dirtySlot];
+
+        // Fully re-resolved below.
+        if (mesh == nullptr || std::binary_search(dirtyRecords->begin(), dirtyRecords->end(), dirtySlot))
+            continue;
+
+        m_Transforms[dirtySlot] = mesh->GetTransform();
+
+        if (m_Records[dirtySlot].indexCount != 0u && m_Records[dirtySlot].instanceCount != 0u)
+            _ResolveBounds(dirtySlot, mesh);
+    }
+
+    for (uint32_t dirtySlot : *dirtyRecords)
+    {
+        ExMesh*       mesh   = m_Meshes[dirtySlot];
+        ExDrawRecord& record = m_Records[dirtySlot];
+
+        record = { kInvalidDrawOffset, kInvalidDrawOffset, kInvalidDrawOffset, 0u, 0u, -1, 0u, 0u };
+
+        m_Features[dirtySlot]   = 0u;
+        m_Lods[dirtySlot].count = 0u;
+        m_Bounds[dirtySlot]     = GfRange3f();
+
+        if (mesh == nullptr)
+            continue;
+
+        m_Transforms[dirtySlot] = mesh->GetTransform();
+        record.primId           = mesh->GetPrimId();
+
+        if (m_HostOnly)
+            _ResolveHostRecord(mesh, &record);
+        else
+        {
+            _ResolveDeviceRecord(mesh, &record);
+            _ResolveLods(mesh, record, &m_Lods[dirtySlot]);
+        }
+
+        m_Features[dirtySlot] = _ResolveFeatures(mesh, record);
+
+        // Only drawable slots get bounds, so culling never has to look at the record.
+        if (record.indexCount != 0u && record.instanceCount != 0u)
+            _ResolveBounds(dirtySlot, mesh);
+    }
+
+    if (m_HostOnly)
+        return;
+
+    m_RecordBuffer   .Reserve(m_Records.size()    * sizeof(ExDrawRecord));
+    m_TransformBuffer.Reserve(m_Transforms.size() * sizeof(GfMatrix4f));
+}
+
+void ExDrawTable::_ResolveBounds(uint32_t slot, ExMesh const* mesh)
+{
+    m_Bounds[slot] = GfRange3f();
+
+    if (mesh->IsInstanced())
+    {
+        m_Bounds[slot] = mesh->GetInstanceBounds();
+    }
+    else if (!mesh->GetLocalBounds().IsEmpty())
+    {
+        GfBBox3d bounds(GfRange3d(mesh->GetLocalBounds()), GfMatrix4d(m_Transforms[slot]));
+        m_Bounds[slot] = GfRange3f(bounds.ComputeAlignedRange());
+    }
+}
+
+void ExDrawTable::_ResolveDeviceRecord(ExMesh const* mesh, ExDrawRecord* record) const
+{
+    auto const& positionRange = mesh->GetPositionRange();
+    auto const& normalRange   = mesh->GetNormalRange();
+    auto const& colorRange    = mesh->GetColorRange();
+    auto const& indexRange    = mesh->GetIndexRange();
+    auto const& instanceRange = mesh->GetInstanceRange();
+
+    // Nothing to draw until the vertices, triangles and instances are all in the heap.
+    if (positionRange == nullptr || !positionRange->IsResident() || indexRange == nullptr || !indexRange->IsResident() ||
+        instanceRange == nullptr || !instanceRange->IsResident())
+        return;
+
+    record->positionOffset = (uint32_t)(positionRange->GetAllocation().offset / sizeof(float));
+    record->firstIndex     = (uint32_t)(indexRange->GetAllocation().offset / sizeof(uint32_t));
+    record->firstInstance  = (uint32_t)(instanceRange->GetAllocation().offset / sizeof(ExInstance));
+    record->instanceCount  = (uint32_t)(instanceRange->GetSize() / sizeof(ExInstance));
+
+    if (normalRange != nullptr && normalRange->IsResident())
+        record->normalOffset = (uint32_t)(normalRange->GetAllocation().offset / sizeof(float));
+
+    if (colorRange != nullptr && colorRange->IsResident())
+        record->colorOffset = (uint32_t)(colorRange->GetAllocation().offset / sizeof(float));
+
+    if (mesh->IsVisible())
+        record->indexCount = (uint32_t)(indexRange->GetSize() / sizeof(uint32_t));
+}
+
+void ExDrawTable::_ResolveLods(ExMesh const* mesh, ExDrawRecord const& record, ExDrawLods* lods) const
+{
+    lods->count = 0u;
+
+    if (record.indexCount == 0u)
+        return;
+
+    lods->firstIndex[0] = record.firstIndex;
+    lods->indexCount[0] = record.indexCount;
+    lods->error[0]      = 0.0f;
+    lods->count         = 1u;
+
+    auto const& lodChain  = mesh->GetLodChain();
+    auto const& lodRanges = mesh->GetLodIndexRanges();
+
+    if (lodChain == nullptr)
+        return;
+
+    // Levels are coarser and coarser, so the chain stops at the first one that isn't resident yet.
+    for (size_t i = 0u; i < lodRanges.size() && lods->count < kMaxDrawLods; ++i)
+    {
+        if (lodRanges[i] == nullptr || !lodRanges[i]->IsResident())
+            break;
+
+        lods->firstIndex[lods->count] = (uint32_t)(lodRanges[i]->GetAllocation().offset / sizeof(uint32_t));
+        lods->indexCount[lods->count] = (uint32_t)(lodRanges[i]->GetSize() / sizeof(uint32_t));
+        lods->error[lods->count]      = (*lodChain)[i].error;
+        lods->count++;
+    }
+}
+
+uint32_t ExDrawTable::_ResolveFeatures(ExMesh const* mesh, ExDrawRecord const& record)
+{
+    uint32_t features = 0u;
+
+    if (record.normalOffset != kInvalidDrawOffset)
+        features |= kMeshFeatureNormals;
+
+    if (record.colorOffset != kInvalidDrawOffset)
+        features |= kMeshFeatureVertexColors;
+
+    // Non-instanced meshes still have their one identity instance, it just never has to be decoded.
+    if (mesh->IsInstanced())
+        features |= kMeshFeatureInstanced;
+
+    if (mesh->HasQuantizedVertices())
+        features |= kMeshFeatureQuantized;
+
+    return features;
+}
+
+void ExDrawTable::_ResolveHostRecord(ExMesh const* mesh, ExDrawRecord* record) const
+{
+    // Host draws are rasterized straight from the mesh cache, so only the counts matter.
+    if (mesh->IsVisible())
+        record->indexCount = (uint32_t)(3u * mesh->GetGeometry().indices.size());
+
+    record->instanceCount = mesh->GetInstanceCount();
+}
@@ -0,0 +1,845 @@
+#include <ExampleDelegate/ExFrameContext.h>
+#include <ExampleDelegate/ExPipelineCache.h>
+#include <ExampleDelegate/ExRenderTargetPool.h>
+#include <ExampleDelegate/ExRenderStats.h>
+#include <ExampleDelegate/ExTimeline.h>
+
+#include <VulkanWrappers/Device.h>
+#include <VulkanWrappers/Window.h>
+#include <VulkanWrappers/Buffer.h>
+using namespace VulkanWrappers;
+
+#include <pxr/base/gf/matrix4f.h>
+#include <pxr/base/tf/hash.h>
+#include <pxr/base/trace/trace.h>
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstring>
+
+// Implementation
+// ---------------------
+
+ExFrameContext::ExFrameContext(Device* device, ExRenderTargetPool* pool, ExTimeline* timeline, ExPipelineCache* pipelineCache, bool multiDrawIndirect)
+    : m_Device(device), m_Pool(pool), m_Timeline(timeline), m_PipelineCache(pipelineCache), m_PipelinesReady(false), m_GraphicsQueueFamily(0u), m_ReadbackFrameCount(0u), m_DrawFrameCount(0u),
+      m_HostFrame(kNoHostFrame), m_TimestampPeriod(0.0),
+      m_GLCreated(false), m_GLBackbufferImage(0u), m_GLBackbufferObject(0u), m_GLBackbufferExtent({ 0u, 0u }),
+      m_GLPixelUnpackBuffers(), m_GLPixelUnpackIndex(0u), m_GLStorageExtent({ 0u, 0u })
+{
+    VkFormat colorFormat;
+    {
+        if (m_Device->GetWindow() != nullptr)
+            colorFormat = m_Device->GetWindow()->GetColorSurfaceFormat();
+        else
+            colorFormat = VK_FORMAT_R8G8B8A8_SRGB;
+    }
+
+    // Layouts are cheap and needed up front, the pipelines themselves compile in the background while the
+    // application is still syncing the scene.
+    _CreateMeshPipeline(colorFormat, multiDrawIndirect);
+    _CreateAccumulationPipeline();
+
+    // Every variant is known up front, so all of them are ready by the first frame.
+    for (uint32_t features = 0u; features < kMeshVariantCount; ++features)
+        m_PipelineCache->Precompile([this, colorFormat, features]() { _CompileMeshPipeline(colorFormat, features); });
+
+    m_PipelineCache->Precompile([this]() { _CompileAccumulationPipeline(); });
+}
+
+ExFrameContext::~ExFrameContext()
+{
+    // Every frame in flight references the resources below. Only our own submissions are waited on,
+    // work the application submitted to the shared device is none of our business.
+    m_Timeline->WaitIdle();
+
+    // Compilation may still be in flight if nothing was ever rendered.
+    m_PipelineCache->Wait();
+
+    _DestroyRetiredDescriptorPools(true);
+
+    for (auto& recorder : m_ThreadRecorders)
+    {
+        for (auto& framePool : recorder.framePools)
+        {
+            if (framePool.pool != VK_NULL_HANDLE)
+                vkDestroyCommandPool(m_Device->GetLogical(), framePool.pool, nullptr);
+        }
+    }
+
+    for (auto& drawFrame : m_DrawFrames)
+    {
+        if (drawFrame.indirect != nullptr)
+            m_Pool->Release(drawFrame.indirect);
+
+        if (drawFrame.timestampPool != VK_NULL_HANDLE)
+            vkDestroyQueryPool(m_Device->GetLogical(), drawFrame.timestampPool, nullptr);
+
+        vkDestroyDescriptorPool(m_Device->GetLogical(), drawFrame.descriptorPool, nullptr);
+    }
+
+    for (auto& readback : m_ReadbackRing)
+    {
+        if (readback.staging != nullptr)
+            m_Pool->Release(readback.staging);
+    }
+
+    // The pipelines and shader modules belong to the cache.
+    vkDestroyPipelineLayout(m_Device->GetLogical(), m_AccumulationPipeline.pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(m_Device->GetLogical(), m_AccumulationPipeline.descriptorSetLayout, nullptr);
+    vkDestroySampler(m_Device->GetLogical(), m_AccumulationPipeline.sampler, nullptr);
+
+    vkDestroyPipelineLayout(m_Device->GetLogical(), m_MeshPipeline.pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(m_Device->GetLogical(), m_MeshPipeline.descriptorSetLayout, nullptr);
+
+    // Expects the application's GL context to be current, as it is when rendering.
+    if (m_GLCreated)
+    {
+        glDeleteTextures(1, &m_GLBackbufferImage);
+        glDeleteFramebuffers(1, &m_GLBackbufferObject);
+        glDeleteBuffers(kPixelUnpackRingSize, m_GLPixelUnpackBuffers);
+    }
+}
+
+// Pipelines
+// ---------------------
+
+ExFrameContext::MeshPipeline const& ExFrameContext::GetMeshPipeline()
+{
+    _WaitForPipelines();
+    return m_MeshPipeline;
+}
+
+ExFrameContext::AccumulationPipeline const& ExFrameContext::GetAccumulationPipeline()
+{
+    _WaitForPipelines();
+    return m_AccumulationPipeline;
+}
+
+// Only the first frame can find the compilation still in flight (and then only without a warm cache).
+void ExFrameContext::_WaitForPipelines()
+{
+    if (m_PipelinesReady.load(std::memory_order_acquire))
+        return;
+
+    TRACE_FUNCTION();
+
+    m_PipelineCache->Wait();
+    m_PipelinesReady.store(true, std::memory_order_release);
+}
+
+void ExFrameContext::_CreateMeshPipeline(VkFormat colorFormat, bool multiDrawIndirect)
+{
+    // What the physical device supports doesn't matter for the feature, only whether the device enabled it.
+    {
+        VmaAllocatorInfo allocatorInfo;
+        vmaGetAllocatorInfo(m_Device->GetAllocator(), &allocatorInfo);
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(allocatorInfo.physicalDevice, &properties);
+
+        m_MeshPipeline.multiDrawIndirect    = multiDrawIndirect;
+        m_MeshPipeline.maxDrawIndirectCount = m_MeshPipeline.multiDrawIndirect ? properties.limits.maxDrawIndirectCount : 1u;
+
+        uint32_t queueFamilyCount = 0u;
+        vkGetPhysicalDeviceQueueFamilyProperties(allocatorInfo.physicalDevice, &queueFamilyCount, nullptr);
+
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(allocatorInfo.physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+        for (uint32_t i = 0u; i < queueFamilyCount; ++i)
+        {
+            if (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+            {
+                m_GraphicsQueueFamily = i;
+                break;
+            }
+        }
+
+        // Frames only create their queries when the graphics queue supports timestamps.
+        if (queueFamilies[m_GraphicsQueueFamily].timestampValidBits != 0u && properties.limits.timestampPeriod > 0.0f)
+            m_TimestampPeriod = (double)properties.limits.timestampPeriod;
+    }
+
+    m_MeshPipeline.colorFormat = colorFormat;
+
+    // Set 0: geometry heap, draw records, transforms, and the heap again viewed as instances.
+    VkDescriptorSetLayoutBinding bindings[4] = {};
+    for (uint32_t i = 0u; i < 4u; ++i)
+    {
+        bindings[i].binding         = i;
+        bindings[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1u;
+        bindings[i].stageFlags      = VK_SHADER_STAGE_VERTEX_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+    setLayoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.bindingCount = 4u;
+    setLayoutInfo.pBindings    = bindings;
+
+    vkCreateDescriptorSetLayout(m_Device->GetLogical(), &setLayoutInfo, nullptr, &m_MeshPipeline.descriptorSetLayout);
+
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.offset     = 0u;
+    pushConstantRange.size       = sizeof(GfMatrix4f);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount         = 1u;
+    pipelineLayoutInfo.pSetLayouts            = &m_MeshPipeline.descriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1u;
+    pipelineLayoutInfo.pPushConstantRanges    = &pushConstantRange;
+
+    vkCreatePipelineLayout(m_Device->GetLogical(), &pipelineLayoutInfo, nullptr, &m_MeshPipeline.pipelineLayout);
+}
+
+void ExFrameContext::_CompileMeshPipeline(VkFormat colorFormat, uint32_t features)
+{
+    TRACE_FUNCTION();
+
+    // One boolean constant per feature bit, constant IDs match the bit indices.
+    VkBool32                 featureValues[kMeshFeatureCount];
+    VkSpecializationMapEntry featureEntries[kMeshFeatureCount];
+
+    for (uint32_t i = 0u; i < kMeshFeatureCount; ++i)
+    {
+        featureValues[i] = (features >> i) & 1u;
+
+        featureEntries[i].constantID = i;
+        featureEntries[i].offset     = i * sizeof(VkBool32);
+        featureEntries[i].size       = sizeof(VkBool32);
+    }
+
+    VkSpecializationInfo specialization = {};
+    specialization.mapEntryCount = kMeshFeatureCount;
+    specialization.pMapEntries   = featureEntries;
+    specialization.dataSize      = sizeof(featureValues);
+    specialization.pData         = featureValues;
+
+    // Both stages see every constant, each declares the ones it uses.
+    VkPipelineShaderStageCreateInfo stages[2] = {};
+    stages[0].sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage               = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module              = m_PipelineCache->GetShaderModule("shaders/MeshVert.spv");
+    stages[0].pName               = "main";
+    stages[0].pSpecializationInfo = &specialization;
+    stages[1].sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage               = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module              = m_PipelineCache->GetShaderModule("shaders/UnlitFrag.spv");
+    stages[1].pName               = "main";
+    stages[1].pSpecializationInfo = &specialization;
+
+    // Vertices are pulled from the heap, there is no fixed-function vertex input.
+    VkPipelineVertexInputStateCreateInfo vertexInput = {};
+    vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+    inputAssembly.sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    // Counts are provided with the dynamic viewport / scissor.
+    VkPipelineViewportStateCreateInfo viewportState = {};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+
+    VkPipelineRasterizationStateCreateInfo rasterization = {};
+    rasterization.sType       = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterization.cullMode    = VK_CULL_MODE_NONE;
+    rasterization.frontFace   = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterization.lineWidth   = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisample = {};
+    multisample.sType                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+    depthStencil.sType            = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable  = VK_TRUE;
+    depthStencil.depthWriteEnable = VK_TRUE;
+    depthStencil.depthCompareOp   = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+    // Color and prim id, neither blended.
+    VkPipelineColorBlendAttachmentState blendAttachments[2] = {};
+    blendAttachments[0].colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    blendAttachments[1].colorWriteMask = VK_COLOR_COMPONENT_R_BIT;
+
+    VkPipelineColorBlendStateCreateInfo colorBlend = {};
+    colorBlend.sType           = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlend.attachmentCount = 2u;
+    colorBlend.pAttachments    = blendAttachments;
+
+    VkDynamicState dynamicStates[] = 
+    { 
+        VK_DYNAMIC_STATE_VIEWPORT_WITH_COUNT_EXT, 
+        VK_DYNAMIC_STATE_SCISSOR_WITH_COUNT_EXT 
+    };
+
+    VkPipelineDynamicStateCreateInfo dynamicState = {};
+    dynamicState.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 2u;
+    dynamicState.pDynamicStates    = dynamicStates;
+
+    VkFormat colorFormats[2] = { colorFormat, kPrimIdFormat };
+
+    VkPipelineRenderingCreateInfoKHR renderingInfo = {};
+    renderingInfo.sType                   = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+    renderingInfo.colorAttachmentCount    = 2u;
+    renderingInfo.pColorAttachmentFormats = colorFormats;
+    renderingInfo.depthAttachmentFormat   = kDepthFormat;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext               = &renderingInfo;
+    pipelineInfo.stageCount          = 2u;
+    pipelineInfo.pStages             = stages;
+    pipelineInfo.pVertexInputState   = &vertexInput;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState      = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterization;
+    pipelineInfo.pMultisampleState   = &multisample;
+    pipelineInfo.pDepthStencilState  = &depthStencil;
+    pipelineInfo.pColorBlendState    = &colorBlend;
+    pipelineInfo.pDynamicState       = &dynamicState;
+    pipelineInfo.layout              = m_MeshPipeline.pipelineLayout;
+
+    // The fixed-function state only varies with the attachment formats, the shaders with the specialization.
+    m_MeshPipeline.variants[features] = m_PipelineCache->GetGraphicsPipeline(pipelineInfo, TfHash::Combine(colorFormat, kPrimIdFormat, kDepthFormat, features));
+}
+
+void ExFrameContext::_CreateAccumulationPipeline()
+{
+    // Samples are fetched texel for texel, the sampler only has to exist.
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter    = VK_FILTER_NEAREST;
+    samplerInfo.minFilter    = VK_FILTER_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+    vkCreateSampler(m_Device->GetLogical(), &samplerInfo, nullptr, &m_AccumulationPipeline.sampler);
+
+    // Set 0: the color target holding the new sample.
+    VkDescriptorSetLayoutBinding binding = {};
+    binding.binding         = 0u;
+    binding.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = 1u;
+    binding.stageFlags      = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+    setLayoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.bindingCount = 1u;
+    setLayoutInfo.pBindings    = &binding;
+
+    vkCreateDescriptorSetLayout(m_Device->GetLogical(), &setLayoutInfo, nullptr, &m_AccumulationPipeline.descriptorSetLayout);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType          = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1u;
+    pipelineLayoutInfo.pSetLayouts    = &m_AccumulationPipeline.descriptorSetLayout;
+
+    vkCreatePipelineLayout(m_Device->GetLogical(), &pipelineLayoutInfo, nullptr, &m_AccumulationPipeline.pipelineLayout);
+}
+
+void ExFrameContext::_CompileAccumulationPipeline()
+{
+    TRACE_FUNCTION();
+
+    VkPipelineShaderStageCreateInfo stages[2] = {};
+    stages[0].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage  = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = m_PipelineCache->GetShaderModule("shaders/FullscreenVert.spv");
+    stages[0].pName  = "main";
+    stages[1].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage  = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = m_PipelineCache->GetShaderModule("shaders/AccumulateFrag.spv");
+    stages[1].pName  = "main";
+
+    VkPipelineVertexInputStateCreateInfo vertexInput = {};
+    vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+    inputAssembly.sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPipelineViewportStateCreateInfo viewportState = {};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+
+    VkPipelineRasterizationStateCreateInfo rasterization = {};
+    rasterization.sType       = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterization.cullMode    = VK_CULL_MODE_NONE;
+    rasterization.frontFace   = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterization.lineWidth   = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisample = {};
+    multisample.sType                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+
+    VkPipelineColorBlendAttachmentState blendAttachment = {};
+    blendAttachment.blendEnable         = VK_TRUE;
+    blendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_CONSTANT_COLOR;
+    blendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_CONSTANT_COLOR;
+    blendAttachment.colorBlendOp        = VK_BLEND_OP_ADD;
+    blendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_CONSTANT_ALPHA;
+    blendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_CONSTANT_ALPHA;
+    blendAttachment.alphaBlendOp        = VK_BLEND_OP_ADD;
+    blendAttachment.colorWriteMask      = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+    VkPipelineColorBlendStateCreateInfo colorBlend = {};
+    colorBlend.sType           = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlend.attachmentCount = 1u;
+    colorBlend.pAttachments    = &blendAttachment;
+
+    VkDynamicState dynamicStates[] = 
+    { 
+        VK_DYNAMIC_STATE_VIEWPORT_WITH_COUNT_EXT, 
+        VK_DYNAMIC_STATE_SCISSOR_WITH_COUNT_EXT,
+        VK_DYNAMIC_STATE_BLEND_CONSTANTS
+    };
+
+    VkPipelineDynamicStateCreateInfo dynamicState = {};
+    dynamicState.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 3u;
+    dynamicState.pDynamicStates    = dynamicStates;
+
+    VkPipelineRenderingCreateInfoKHR renderingInfo = {};
+    renderingInfo.sType                   = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+    renderingInfo.colorAttachmentCount    = 1u;
+    renderingInfo.pColorAttachmentFormats = &kAccumulationFormat;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext               = &renderingInfo;
+    pipelineInfo.stageCount          = 2u;
+    pipelineInfo.pStages             = stages;
+    pipelineInfo.pVertexInputState   = &vertexInput;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState      = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterization;
+    pipelineInfo.pMultisampleState   = &multisample;
+    pipelineInfo.pDepthStencilState  = &depthStencil;
+    pipelineInfo.pColorBlendState    = &colorBlend;
+    pipelineInfo.pDynamicState       = &dynamicState;
+    pipelineInfo.layout              = m_AccumulationPipeline.pipelineLayout;
+
+    m_AccumulationPipeline.pipeline = m_PipelineCache->GetGraphicsPipeline(pipelineInfo, TfHash::Combine(kAccumulationFormat));
+}
+
+// Frames
+// ---------------------
+
+ExFrameContext::ReadbackFrame* ExFrameContext::AcquireReadbackFrame()
+{
+    // Only the manual-submit path reads back, so the ring is created on first use.
+    if (m_ReadbackRing[0].cmd == VK_NULL_HANDLE)
+    {
+        for (auto& readback : m_ReadbackRing)
+            m_Device->CreateCommandBuffer(&readback.cmd);
+    }
+
+    ReadbackFrame* readback = GetReadbackFrame(m_ReadbackFrameCount);
+
+    // Wait for the last submission that used this slot (and nothing after it). With a ring of N this is
+    // the frame from N invocations ago, so in steady state the GPU is already done with it.
+    m_Timeline->Wait(readback->timelineValue);
+
+    // A slot that was never presented (i.e. the latency setting was lowered) is simply dropped.
+    readback->pending = false;
+
+    return readback;
+}
+
+void ExFrameContext::SubmitReadbackFrame(ReadbackFrame* readback, uint64_t timelineValue, bool pending)
+{
+    readback->frameID       = m_ReadbackFrameCount++;
+    readback->timelineValue = timelineValue;
+    readback->pending       = pending;
+}
+
+// Take a draw frame no submission uses anymore. Our own submissions are waited on, so the manual-submit path
+// never has more than kFrameCount frames. Frames recorded into the application's command buffers can't be
+// waited on, so those are added to until the application is far enough ahead (several passes may record
+// into one application frame).
+ExFrameContext::DrawFrame* ExFrameContext::AcquireDrawFrame(uint64_t hostFrame)
+{
+    if (hostFrame != kNoHostFrame)
+        m_HostFrame = hostFrame;
+
+    _DestroyRetiredDescriptorPools(false);
+
+    DrawFrame* drawFrame = nullptr;
+
+    for (auto& candidate : m_DrawFrames)
+    {
+        if (_IsDrawFrameIdle(candidate))
+        {
+            drawFrame = &candidate;
+            break;
+        }
+    }
+
+    if (drawFrame == nullptr && hostFrame == kNoHostFrame && m_DrawFrames.size() >= kFrameCount)
+    {
+        drawFrame = &*std::min_element(m_DrawFrames.begin(), m_DrawFrames.end(), [](DrawFrame const& a, DrawFrame const& b)
+        {
+            return a.timelineValue < b.timelineValue;
+        });
+
+        m_Timeline->Wait(drawFrame->timelineValue);
+    }
+
+    if (drawFrame == nullptr)
+        drawFrame = _CreateDrawFrame();
+
+    drawFrame->frameID   = m_DrawFrameCount++;
+    drawFrame->hostFrame = hostFrame;
+
+    return drawFrame;
+}
+
+void ExFrameContext::SubmitDrawFrame(DrawFrame* drawFrame, uint64_t timelineValue)
+{
+    drawFrame->timelineValue = timelineValue;
+}
+
+// A frame recorded into the application's frame N is complete once the application hands over frame N + kFrameCount.
+bool ExFrameContext::_IsDrawFrameIdle(DrawFrame const& drawFrame) const
+{
+    if (drawFrame.hostFrame != kNoHostFrame)
+        return m_HostFrame != kNoHostFrame && m_HostFrame >= drawFrame.hostFrame + kFrameCount;
+
+    return m_Timeline->IsComplete(drawFrame.timelineValue);
+}
+
+ExFrameContext::DrawFrame* ExFrameContext::_CreateDrawFrame()
+{
+    m_DrawFrames.emplace_back();
+
+    DrawFrame& drawFrame = m_DrawFrames.back();
+    drawFrame.slot = (uint32_t)m_DrawFrames.size() - 1u;
+
+    // A single set: geometry heap, draw records, transforms, and the heap again viewed as instances.
+    VkDescriptorPoolSize poolSize = {};
+    poolSize.type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = 4u;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets       = 1u;
+    poolInfo.poolSizeCount = 1u;
+    poolInfo.pPoolSizes    = &poolSize;
+
+    vkCreateDescriptorPool(m_Device->GetLogical(), &poolInfo, nullptr, &drawFrame.descriptorPool);
+
+    VkDescriptorSetAllocateInfo setInfo = {};
+    setInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setInfo.descriptorPool     = drawFrame.descriptorPool;
+    setInfo.descriptorSetCount = 1u;
+    setInfo.pSetLayouts        = &m_MeshPipeline.descriptorSetLayout;
+
+    vkAllocateDescriptorSets(m_Device->GetLogical(), &setInfo, &drawFrame.descriptorSet);
+
+    if (m_TimestampPeriod > 0.0)
+    {
+        VkQueryPoolCreateInfo queryInfo = {};
+        queryInfo.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryInfo.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+        queryInfo.queryCount = kTimestampsPerFrame;
+
+        if (vkCreateQueryPool(m_Device->GetLogical(), &queryInfo, nullptr, &drawFrame.timestampPool) != VK_SUCCESS)
+        {
+            TF_WARN("Failed to create the timestamp query pool, GPU times will not be reported for this frame.");
+            drawFrame.timestampPool = VK_NULL_HANDLE;
+        }
+    }
+
+    return &drawFrame;
+}
+
+void ExFrameContext::RetireDescriptorPool(VkDescriptorPool descriptorPool)
+{
+    if (descriptorPool != VK_NULL_HANDLE)
+        m_RetiredDescriptorPools.push_back({ descriptorPool, m_Timeline->GetSubmittedValue(), m_HostFrame });
+}
+
+// Destroy the retired pools no frame can be using anymore. Frames submitted by the application aren't on
+// our timeline, those are complete once the application is kFrameCount frames past them.
+void ExFrameContext::_DestroyRetiredDescriptorPools(bool all)
+{
+    auto it = std::remove_if(m_RetiredDescriptorPools.begin(), m_RetiredDescriptorPools.end(), [&](RetiredDescriptorPool const& retired)
+    {
+        bool hostComplete = retired.hostFrame == kNoHostFrame || m_HostFrame >= retired.hostFrame + kFrameCount;
+
+        if (!all && (!hostComplete || !m_Timeline->IsComplete(retired.timelineValue)))
+            return false;
+
+        vkDestroyDescriptorPool(m_Device->GetLogical(), retired.descriptorPool, nullptr);
+        return true;
+    });
+
+    m_RetiredDescriptorPools.erase(it, m_RetiredDescriptorPools.end());
+}
+
+// Ensure the slot's staging memory can hold a frame of the provided extent. The pool allocates it
+// by size bucket, so a resize within the bucket gets the same memory back.
+// Note: Only called once the slot's submission has been waited on, so the old buffer is no longer in use.
+void ExFrameContext::ResizeReadbackStaging(ReadbackFrame* readback, VkExtent2D extent)
+{
+    if (readback->extent.width == extent.width && readback->extent.height == extent.height)
+        return;
+
+    if (readback->staging != nullptr)
+        m_Pool->Release(readback->staging);
+
+    VkExtent2D bucket = ExRenderTargetPool::GetBucketExtent(extent);
+
+    readback->staging = m_Pool->AcquireBuffer(4 * bucket.width * bucket.height, 
+                                              VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT, 
+                                              VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+
+    // Keep the mapping around rather than copying the allocation out every frame.
+    VmaAllocationInfo allocInfo;
+    vmaGetAllocationInfo(m_Device->GetAllocator(), readback->staging->GetData()->allocation, &allocInfo);
+
+    readback->mapped = allocInfo.pMappedData;
+    readback->extent = extent;
+}
+
+VkCommandBuffer ExFrameContext::AcquireSecondaryCommandBuffer(DrawFrame const* drawFrame)
+{
+    ThreadRecorder& recorder = m_ThreadRecorders.local();
+
+    if (recorder.framePools.size() <= drawFrame->slot)
+        recorder.framePools.resize(drawFrame->slot + 1u);
+
+    ThreadRecorder::FramePool& framePool = recorder.framePools[drawFrame->slot];
+
+    if (framePool.pool == VK_NULL_HANDLE)
+    {
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolInfo.queueFamilyIndex = m_GraphicsQueueFamily;
+
+        vkCreateCommandPool(m_Device->GetLogical(), &poolInfo, nullptr, &framePool.pool);
+    }
+
+    // First use of the frame since it was acquired (so its last submission has completed), recycle everything recorded on it last time.
+    if (framePool.frameID != drawFrame->frameID)
+    {
+        vkResetCommandPool(m_Device->GetLogical(), framePool.pool, 0x0);
+
+        framePool.frameID   = drawFrame->frameID;
+        framePool.usedCount = 0u;
+    }
+
+    if (framePool.usedCount == framePool.buffers.size())
+    {
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool        = framePool.pool;
+        allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1u;
+
+        VkCommandBuffer secondary;
+        vkAllocateCommandBuffers(m_Device->GetLogical(), &allocInfo, &secondary);
+
+        framePool.buffers.push_back(secondary);
+    }
+
+    return framePool.buffers[framePool.usedCount++];
+}
+
+// GPU Timing
+// ---------------------
+
+void ExFrameContext::ResetTimestamps(VkCommandBuffer cmd, DrawFrame* drawFrame)
+{
+    if (drawFrame->timestampPool != VK_NULL_HANDLE)
+        vkCmdResetQueryPool(cmd, drawFrame->timestampPool, 0u, kTimestampsPerFrame);
+}
+
+void ExFrameContext::WriteTimestamp(VkCommandBuffer cmd, DrawFrame const* drawFrame, uint32_t index, VkPipelineStageFlagBits stage)
+{
+    if (drawFrame->timestampPool != VK_NULL_HANDLE)
+        vkCmdWriteTimestamp(cmd, stage, drawFrame->timestampPool, index);
+}
+
+void ExFrameContext::SubmitTimestamps(DrawFrame* drawFrame)
+{
+    drawFrame->timestampsWritten = drawFrame->timestampPool != VK_NULL_HANDLE;
+}
+
+// Publish the GPU times of the last submission that used the frame, if they are available. A frame is only
+// acquired again once that submission has completed (see AcquireDrawFrame), so this never stalls.
+void ExFrameContext::ReadTimestamps(DrawFrame* drawFrame, ExRenderStats* stats)
+{
+    if (drawFrame->timestampPool == VK_NULL_HANDLE || !drawFrame->timestampsWritten)
+        return;
+
+    drawFrame->timestampsWritten = false;
+
+    // Value / availability pairs.
+    uint64_t results[kTimestampsPerFrame][2] = {};
+
+    vkGetQueryPoolResults(m_Device->GetLogical(), drawFrame->timestampPool, 0u, kTimestampsPerFrame,
+                          sizeof(results), results, sizeof(results[0]), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+    for (auto const& result : results)
+    {
+        if (result[1] == 0u)
+            return;
+    }
+
+    auto Milliseconds = [&](uint32_t begin, uint32_t end)
+    {
+        return results[end][0] > results[begin][0] ? (double)(results[end][0] - results[begin][0]) * m_TimestampPeriod * 1e-6 : 0.0;
+    };
+
+    stats->SetGpuTimes(Milliseconds(0u, 1u), Milliseconds(2u, 3u));
+}
+
+// GL Interop
+// ---------------------
+
+void ExFrameContext::CreateGLObjects()
+{
+    if (m_GLCreated)
+        return;
+
+    glewInit();
+
+    glGenTextures(1, &m_GLBackbufferImage);
+    glGenFramebuffers(1, &m_GLBackbufferObject);
+    glGenBuffers(kPixelUnpackRingSize, m_GLPixelUnpackBuffers);
+
+    m_GLCreated = true;
+}
+
+// (Re)create immutable texture storage and unpack buffers for the provided extent. Storage is sized by
+// the same buckets as the render targets, frames are uploaded into (and blit from) a sub-rectangle.
+// Note: Only invoked when the size bucket changes, never per-frame.
+void ExFrameContext::_ResizeGLObjects(VkExtent2D extent)
+{
+    extent = ExRenderTargetPool::GetBucketExtent(extent);
+
+    if (m_GLStorageExtent.width == extent.width && m_GLStorageExtent.height == extent.height)
+        return;
+
+    GLint currentFramebuffer, currentUnpackBuffer;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING,   &currentFramebuffer);
+    glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &currentUnpackBuffer);
+
+    // Immutable storage can't be respecified, so swap in a fresh texture object.
+    if (m_GLStorageExtent.width != 0u)
+    {
+        glDeleteTextures(1, &m_GLBackbufferImage);
+        glGenTextures(1, &m_GLBackbufferImage);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, m_GLBackbufferImage);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, extent.width, extent.height);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_GLBackbufferObject);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_GLBackbufferImage, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, currentFramebuffer);
+
+    for (auto pixelUnpackBuffer : m_GLPixelUnpackBuffers)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelUnpackBuffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, 4 * extent.width * extent.height, nullptr, GL_STREAM_DRAW);
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, currentUnpackBuffer);
+
+    m_GLStorageExtent = extent;
+}
+
+// Stream a completed readback into the GL backbuffer with no intermediate allocations.
+void ExFrameContext::UploadGLBackbuffer(ReadbackFrame* readback)
+{
+    GLint currentTexture, currentUnpackBuffer, unpackAlignment, unpackRowLength;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D,          &currentTexture);
+    glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &currentUnpackBuffer);
+    glGetIntegerv(GL_UNPACK_ALIGNMENT,            &unpackAlignment);
+    glGetIntegerv(GL_UNPACK_ROW_LENGTH,           &unpackRowLength);
+
+    _ResizeGLObjects(readback->extent);
+
+    // Make device writes visible to the host (no-op on coherent memory).
+    vmaInvalidateAllocation(m_Device->GetAllocator(), readback->staging->GetData()->allocation, 0u, VK_WHOLE_SIZE);
+
+    GLsizeiptr size = 4 * readback->extent.width * readback->extent.height;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_GLPixelUnpackBuffers[m_GLPixelUnpackIndex]);
+    m_GLPixelUnpackIndex = (m_GLPixelUnpackIndex + 1u) % kPixelUnpackRingSize;
+
+    // Invalidating the whole range lets the driver hand us fresh memory instead of waiting on a previous upload.
+    void* pixelUnpackData = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+    // The only CPU copy: persistently-mapped Vulkan staging -> driver-owned unpack memory.
+    if (pixelUnpackData != nullptr)
+    {
+        memcpy(pixelUnpackData, readback->mapped, size);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+
+    // Sourced from the bound unpack buffer, so this schedules a DMA rather than a synchronous copy.
+    glPixelStorei(GL_UNPACK_ALIGNMENT,  4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+    glBindTexture(GL_TEXTURE_2D, m_GLBackbufferImage);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, readback->extent.width, readback->extent.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    // Restore host application state.
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, currentUnpackBuffer);
+    glBindTexture(GL_TEXTURE_2D, currentTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT,  unpackAlignment);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, unpackRowLength);
+
+    m_GLBackbufferExtent = readback->extent;
+}
+
+// Present the most recent readback still in flight, dropping any older ones. Used when nothing new is
+// rendered, so the image converges to the latest frame regardless of the readback latency.
+void ExFrameContext::PresentLatestReadback()
+{
+    ReadbackFrame* latest = nullptr;
+
+    for (auto& readback : m_ReadbackRing)
+    {
+        if (readback.pending && (latest == nullptr || readback.frameID > latest->frameID))
+            latest = &readback;
+    }
+
+    if (latest == nullptr)
+        return;
+
+    m_Timeline->Wait(latest->timelineValue);
+
+    UploadGLBackbuffer(latest);
+
+    for (auto& readback : m_ReadbackRing)
+        readback.pending = false;
+}
+
+// Blit the internal backbuffer into the host one.
+void ExFrameContext::BlitGLBackbuffer()
+{
+    GLint currentFramebuffer;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &currentFramebuffer);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_GLBackbufferObject);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, currentFramebuffer);
+
+    glBlitFramebuffer(0, 0, m_GLBackbufferExtent.width, m_GLBackbufferExtent.height, 
+                      0, 0, m_GLBackbufferExtent.width, m_GLBackbufferExtent.height, 
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, currentFramebuffer);
+}
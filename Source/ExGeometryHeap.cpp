@@ -0,0 +1,84 @@
+#include <ExampleDelegate/ExGeometryHeap.h>
+
+#include <algorithm>
+
+ExGeometryHeap::ExGeometryHeap(VulkanWrappers::Device* device, VkBufferUsageFlags usage, VkDeviceSize initialSize)
+    : m_Buffer(device, usage)
+{
+    m_Buffer.Reserve(initialSize);
+
+    _InsertFreeRange(0u, m_Buffer.GetSize());
+}
+
+void ExGeometryHeap::Allocate(VkDeviceSize size, VkDeviceSize alignment, ExGeometryAllocation* allocation)
+{
+    for (;;)
+    {
+        for (auto it = m_FreeRanges.begin(); it != m_FreeRanges.end(); ++it)
+        {
+            VkDeviceSize rangeOffset = it->first;
+            VkDeviceSize rangeSize   = it->second;
+
+            VkDeviceSize alignedOffset = (rangeOffset + alignment - 1u) & ~(alignment - 1u);
+
+            if (alignedOffset + size > rangeOffset + rangeSize)
+                continue;
+
+            m_FreeRanges.erase(it);
+
+            // Give back the alignment padding and the tail.
+            if (alignedOffset > rangeOffset)
+                _InsertFreeRange(rangeOffset, alignedOffset - rangeOffset);
+
+            if (alignedOffset + size < rangeOffset + rangeSize)
+                _InsertFreeRange(alignedOffset + size, rangeOffset + rangeSize - (alignedOffset + size));
+
+            allocation->offset = alignedOffset;
+            allocation->size   = size;
+            return;
+        }
+
+        // Nothing fits, grow and make the new tail available.
+        VkDeviceSize previousSize = m_Buffer.GetSize();
+
+        m_Buffer.Reserve(previousSize + size + alignment);
+
+        _InsertFreeRange(previousSize, m_Buffer.GetSize() - previousSize);
+    }
+}
+
+void ExGeometryHeap::Free(ExGeometryAllocation* allocation)
+{
+    if (!allocation->IsValid())
+        return;
+
+    _InsertFreeRange(allocation->offset, allocation->size);
+
+    *allocation = ExGeometryAllocation();
+}
+
+void ExGeometryHeap::_InsertFreeRange(VkDeviceSize offset, VkDeviceSize size)
+{
+    auto next = m_FreeRanges.lower_bound(offset);
+
+    // Merge with the following range.
+    if (next != m_FreeRanges.end() && offset + size == next->first)
+    {
+        size += next->second;
+        next = m_FreeRanges.erase(next);
+    }
+
+    // Merge with the preceding range.
+    if (next != m_FreeRanges.begin())
+    {
+        auto previous = std::prev(next);
+
+        if (previous->first + previous->second == offset)
+        {
+            previous->second += size;
+            return;
+        }
+    }
+
+    m_FreeRanges.emplace_hint(next, offset, size);
+}
@@ -0,0 +1,113 @@
+#include <ExampleDelegate/ExGrowableBuffer.h>
+#include <ExampleDelegate/ExTimeline.h>
+
+#include <VulkanWrappers/Device.h>
+#include <VulkanWrappers/Buffer.h>
+using namespace VulkanWrappers;
+
+#include <algorithm>
+
+// Number of commits a retired buffer is kept alive for. Covers the frames that may still reference it.
+static constexpr uint64_t kFramesBeforeFree = 4u;
+
+// Retired buffers are stamped with the frame index (and the last submission) on the first garbage collection
+// after retirement, by which point the copy out of them has been submitted.
+static constexpr uint64_t kUnstampedFrame = UINT64_MAX;
+
+ExGrowableBuffer::ExGrowableBuffer(Device* device, VkBufferUsageFlags usage) :
+    m_Device(device),
+    m_Usage(usage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT),
+    m_Buffer(nullptr),
+    m_Size(0u),
+    m_Version(0u),
+    m_GrowthSource(nullptr),
+    m_GrowthSourceSize(0u)
+{
+}
+
+ExGrowableBuffer::~ExGrowableBuffer()
+{
+    for (auto& retired : m_Retired)
+    {
+        m_Device->ReleaseBuffers({ retired.buffer });
+        delete retired.buffer;
+    }
+
+    if (m_Buffer != nullptr)
+    {
+        m_Device->ReleaseBuffers({ m_Buffer });
+        delete m_Buffer;
+    }
+}
+
+void ExGrowableBuffer::Reserve(VkDeviceSize size)
+{
+    if (size <= m_Size)
+        return;
+
+    VkDeviceSize newSize = std::max(size, m_Size * 2u);
+
+    if (m_Buffer != nullptr)
+    {
+        if (m_GrowthSource == nullptr)
+        {
+            // Keep the current contents around until they're copied into the new buffer.
+            m_GrowthSource     = m_Buffer;
+            m_GrowthSourceSize = m_Size;
+
+            m_Retired.push_back({ m_Buffer, kUnstampedFrame, 0u });
+        }
+        else
+        {
+            // Grew twice before the copy was recorded, the intermediate buffer was never used by the GPU.
+            m_Device->ReleaseBuffers({ m_Buffer });
+            delete m_Buffer;
+        }
+    }
+
+    m_Buffer = new Buffer(newSize, m_Usage, 0x0);
+    m_Device->CreateBuffers({ m_Buffer });
+
+    m_Size = newSize;
+    m_Version++;
+}
+
+bool ExGrowableBuffer::RecordGrowth(VkCommandBuffer cmd)
+{
+    if (m_GrowthSource == nullptr)
+        return false;
+
+    VkBufferCopy copyRegion = { 0u, 0u, m_GrowthSourceSize };
+    vkCmdCopyBuffer(cmd, m_GrowthSource->GetData()->buffer, m_Buffer->GetData()->buffer, 1u, &copyRegion);
+
+    m_GrowthSource     = nullptr;
+    m_GrowthSourceSize = 0u;
+
+    return true;
+}
+
+void ExGrowableBuffer::GarbageCollect(uint64_t frameIndex, ExTimeline const* timeline)
+{
+    auto it = std::remove_if(m_Retired.begin(), m_Retired.end(), [&](RetiredBuffer& retired)
+    {
+        // Still waiting to be copied out of.
+        if (retired.buffer == m_GrowthSource)
+            return false;
+
+        if (retired.frameIndex == kUnstampedFrame)
+        {
+            retired.frameIndex    = frameIndex;
+            retired.timelineValue = timeline->GetSubmittedValue();
+        }
+
+        if (frameIndex - retired.frameIndex < kFramesBeforeFree || !timeline->IsComplete(retired.timelineValue))
+            return false;
+
+        m_Device->ReleaseBuffers({ retired.buffer });
+        delete retired.buffer;
+
+        return true;
+    });
+
+    m_Retired.erase(it, m_Retired.end());
+}
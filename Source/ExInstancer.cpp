@@ -0,0 +1,225 @@
+#include <ExampleDelegate/ExInstancer.h>
+
+#include <pxr/base/gf/quath.h>
+#include <pxr/base/work/loops.h>
+#include <pxr/imaging/hd/renderIndex.h>
+#include <pxr/imaging/hd/sceneDelegate.h>
+
+#include <algorithm>
+#include <cmath>
+
+static inline uint32_t PackSnorm16x2(float a, float b)
+{
+    auto Quantize = [](float value) { return (uint32_t)(uint16_t)(int16_t)std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f); };
+    return Quantize(a) | (Quantize(b) << 16u);
+}
+
+static inline GfVec2f UnpackSnorm16x2(uint32_t packed)
+{
+    auto Expand = [](uint32_t bits) { return std::max((float)(int16_t)(uint16_t)bits / 32767.0f, -1.0f); };
+    return GfVec2f(Expand(packed & 0xFFFFu), Expand(packed >> 16u));
+}
+
+static inline uint32_t PackHalf2(float a, float b)
+{
+    return (uint32_t)GfHalf(a).bits() | ((uint32_t)GfHalf(b).bits() << 16u);
+}
+
+static inline GfVec2f UnpackHalf2(uint32_t packed)
+{
+    GfHalf a, b;
+    a.setBits((uint16_t)(packed & 0xFFFFu));
+    b.setBits((uint16_t)(packed >> 16u));
+    return GfVec2f((float)a, (float)b);
+}
+
+ExInstance ExEncodeInstance(GfMatrix4d const& transform, uint32_t drawSlot)
+{
+    ExInstance instance;
+
+    GfVec3d translation = transform.ExtractTranslation();
+
+    instance.translation[0] = (float)translation[0];
+    instance.translation[1] = (float)translation[1];
+    instance.translation[2] = (float)translation[2];
+    instance.drawSlot       = drawSlot;
+
+    // Rows are the transformed basis vectors (row-vector convention), so their lengths are the scale.
+    GfVec3d scale(transform.GetRow3(0).GetLength(), transform.GetRow3(1).GetLength(), transform.GetRow3(2).GetLength());
+
+    // A mirrored basis is carried by the scale, the rotation has to stay proper.
+    if (transform.GetDeterminant3() < 0.0)
+        scale[0] = -scale[0];
+
+    GfMatrix4d rotation(1.0);
+
+    for (int row = 0; row < 3; ++row)
+        rotation.SetRow3(row, std::abs(scale[row]) > 1e-12 ? transform.GetRow3(row) / scale[row] : GfVec3d(0.0));
+
+    // Absorbs any shear into the nearest rotation.
+    rotation.Orthonormalize(false);
+
+    GfQuatd quat = rotation.ExtractRotationQuat().GetNormalized();
+
+    // q and -q are the same rotation, keeping w positive spends no precision on the sign.
+    if (quat.GetReal() < 0.0)
+        quat = GfQuatd(-quat.GetReal(), -quat.GetImaginary());
+
+    GfVec3d const& imaginary = quat.GetImaginary();
+
+    instance.rotation[0] = PackSnorm16x2((float)imaginary[0], (float)imaginary[1]);
+    instance.rotation[1] = PackSnorm16x2((float)imaginary[2], (float)quat.GetReal());
+
+    instance.scale[0] = PackHalf2((float)scale[0], (float)scale[1]);
+    instance.scale[1] = PackHalf2((float)scale[2], 0.0f);
+
+    return instance;
+}
+
+GfMatrix4f ExDecodeInstance(ExInstance const& instance)
+{
+    GfVec2f xy = UnpackSnorm16x2(instance.rotation[0]);
+    GfVec2f zw = UnpackSnorm16x2(instance.rotation[1]);
+
+    GfVec2f scaleXY = UnpackHalf2(instance.scale[0]);
+    GfVec2f scaleZ_ = UnpackHalf2(instance.scale[1]);
+
+    GfQuatf quat(zw[1], xy[0], xy[1], zw[0]);
+    quat.Normalize();
+
+    GfMatrix4f transform(1.0f);
+    transform.SetRotate(quat);
+
+    transform.SetRow3(0, transform.GetRow3(0) * scaleXY[0]);
+    transform.SetRow3(1, transform.GetRow3(1) * scaleXY[1]);
+    transform.SetRow3(2, transform.GetRow3(2) * scaleZ_[0]);
+    transform.SetRow3(3, GfVec3f(instance.translation[0], instance.translation[1], instance.translation[2]));
+
+    return transform;
+}
+
+ExInstancer::ExInstancer(HdSceneDelegate* delegate, SdfPath const& id) : HdInstancer(delegate, id), m_Transform(1.0)
+{
+}
+
+void ExInstancer::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam, HdDirtyBits* dirtyBits)
+{
+    SdfPath const& id = GetId();
+
+    _UpdateInstancer(sceneDelegate, dirtyBits);
+
+    if (HdChangeTracker::IsTransformDirty(*dirtyBits, id))
+        m_Transform = sceneDelegate->GetInstancerTransform(id);
+
+    if (HdChangeTracker::IsAnyPrimvarDirty(*dirtyBits, id))
+    {
+        for (HdPrimvarDescriptor const& primvar : sceneDelegate->GetPrimvarDescriptors(id, HdInterpolationInstance))
+        {
+            if (!HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, primvar.name))
+                continue;
+
+            VtValue value = sceneDelegate->Get(id, primvar.name);
+
+            if (primvar.name == HdInstancerTokens->instanceTranslations)
+            {
+                m_Translations = value.IsHolding<VtVec3fArray>() ? value.UncheckedGet<VtVec3fArray>() : VtVec3fArray();
+            }
+            else if (primvar.name == HdInstancerTokens->instanceRotations)
+            {
+                m_Rotations = VtQuatfArray();
+
+                if (value.IsHolding<VtQuatfArray>())
+                {
+                    m_Rotations = value.UncheckedGet<VtQuatfArray>();
+                }
+                else if (value.IsHolding<VtQuathArray>())
+                {
+                    VtQuathArray const& rotations = value.UncheckedGet<VtQuathArray>();
+
+                    m_Rotations.resize(rotations.size());
+                    std::transform(rotations.begin(), rotations.end(), m_Rotations.begin(), [](GfQuath const& quat) { return GfQuatf(quat); });
+                }
+            }
+            else if (primvar.name == HdInstancerTokens->instanceScales)
+            {
+                m_Scales = value.IsHolding<VtVec3fArray>() ? value.UncheckedGet<VtVec3fArray>() : VtVec3fArray();
+            }
+            else if (primvar.name == HdInstancerTokens->instanceTransforms)
+            {
+                m_Transforms = value.IsHolding<VtMatrix4dArray>() ? value.UncheckedGet<VtMatrix4dArray>() : VtMatrix4dArray();
+            }
+        }
+    }
+
+    *dirtyBits &= ~HdChangeTracker::AllSceneDirtyBits;
+}
+
+GfMatrix4d ExInstancer::_ComputeLocalTransform(int index) const
+{
+    // Row-vector order: the instance transform applies first, then scale, rotation, translation and the instancer itself.
+    GfMatrix4d transform = index >= 0 && (size_t)index < m_Transforms.size() ? m_Transforms[index] : GfMatrix4d(1.0);
+
+    if (index >= 0 && (size_t)index < m_Scales.size())
+        transform *= GfMatrix4d(1.0).SetScale(GfVec3d(m_Scales[index]));
+
+    if (index >= 0 && (size_t)index < m_Rotations.size())
+        transform *= GfMatrix4d(1.0).SetRotate(GfQuatd(m_Rotations[index]));
+
+    if (index >= 0 && (size_t)index < m_Translations.size())
+        transform *= GfMatrix4d(1.0).SetTranslate(GfVec3d(m_Translations[index]));
+
+    return transform * m_Transform;
+}
+
+VtMatrix4dArray ExInstancer::_ComputeParentTransforms() const
+{
+    if (GetParentId().IsEmpty())
+        return VtMatrix4dArray(1u, GfMatrix4d(1.0));
+
+    auto* parent = static_cast<ExInstancer const*>(GetDelegate()->GetRenderIndex().GetInstancer(GetParentId()));
+
+    if (!TF_VERIFY(parent != nullptr))
+        return VtMatrix4dArray(1u, GfMatrix4d(1.0));
+
+    return parent->ComputeInstanceTransforms(GetId());
+}
+
+VtMatrix4dArray ExInstancer::ComputeInstanceTransforms(SdfPath const& prototypeId) const
+{
+    VtIntArray      indices = GetDelegate()->GetInstanceIndices(GetId(), prototypeId);
+    VtMatrix4dArray parents = _ComputeParentTransforms();
+
+    // Every instance of this level under every instance of the parent, parent-major.
+    VtMatrix4dArray transforms(parents.size() * indices.size());
+
+    GfMatrix4d* output = transforms.data();
+
+    WorkParallelForN(transforms.size(), [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            output[i] = _ComputeLocalTransform(indices[i % indices.size()]) * parents[i / indices.size()];
+    });
+
+    return transforms;
+}
+
+VtUIntArray ExInstancer::ComputeInstances(SdfPath const& prototypeId, uint32_t drawSlot) const
+{
+    VtIntArray      indices = GetDelegate()->GetInstanceIndices(GetId(), prototypeId);
+    VtMatrix4dArray parents = _ComputeParentTransforms();
+
+    const size_t instanceCount = parents.size() * indices.size();
+
+    // Encoded straight from the instance primvars, this level's transforms are never held in full precision.
+    VtUIntArray words(instanceCount * kInstanceWords);
+
+    ExInstance* instances = reinterpret_cast<ExInstance*>(words.data());
+
+    WorkParallelForN(instanceCount, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            instances[i] = ExEncodeInstance(_ComputeLocalTransform(indices[i % indices.size()]) * parents[i / indices.size()], drawSlot);
+    });
+
+    return words;
+}
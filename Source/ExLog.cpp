@@ -0,0 +1,113 @@
+#include <ExampleDelegate/ExLog.h>
+
+#include <pxr/base/tf/registryManager.h>
+
+#include <chrono>
+#include <cstdio>
+
+// How often the background thread writes out buffered lines.
+static constexpr std::chrono::milliseconds kDrainInterval(100);
+
+TF_REGISTRY_FUNCTION(TfDebug)
+{
+    TF_DEBUG_ENVIRONMENT_SYMBOL(EX_DEBUG_DELEGATE,       "Render delegate and render pass creation / destruction");
+    TF_DEBUG_ENVIRONMENT_SYMBOL(EX_DEBUG_PRIM_LIFECYCLE, "Rprim, sprim and bprim creation / destruction");
+    TF_DEBUG_ENVIRONMENT_SYMBOL(EX_DEBUG_SYNC,           "Per-prim Sync() calls");
+}
+
+ExLog& ExLog::GetInstance()
+{
+    static ExLog s_Log;
+    return s_Log;
+}
+
+ExLog::ExLog() : m_Stop(false)
+{
+    m_Thread = std::thread([this]() { _Run(); });
+}
+
+ExLog::~ExLog()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_WakeMutex);
+        m_Stop = true;
+    }
+
+    m_Wake.notify_one();
+    m_Thread.join();
+
+    _Drain();
+}
+
+ExLog::ThreadBuffer* ExLog::_GetThreadBuffer()
+{
+    // Registered once per thread, after which appending only touches the thread's own buffer.
+    thread_local ThreadBuffer* s_ThreadBuffer = nullptr;
+
+    if (s_ThreadBuffer == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(m_BuffersMutex);
+
+        m_Buffers.push_back(std::make_unique<ThreadBuffer>());
+        s_ThreadBuffer = m_Buffers.back().get();
+    }
+
+    return s_ThreadBuffer;
+}
+
+void ExLog::Write(std::string const& message)
+{
+    ThreadBuffer* buffer = _GetThreadBuffer();
+
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+
+    buffer->text += message;
+    buffer->text += '\n';
+}
+
+void ExLog::Flush()
+{
+    _Drain();
+}
+
+void ExLog::_Drain()
+{
+    std::lock_guard<std::mutex> drainLock(m_DrainMutex);
+
+    std::string text;
+    {
+        std::lock_guard<std::mutex> lock(m_BuffersMutex);
+
+        for (auto& buffer : m_Buffers)
+        {
+            std::string taken;
+            {
+                std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+                taken.swap(buffer->text);
+            }
+
+            text += taken;
+        }
+    }
+
+    if (text.empty())
+        return;
+
+    // One write per drain, outside of every buffer lock.
+    fwrite(text.data(), 1u, text.size(), stdout);
+    fflush(stdout);
+}
+
+void ExLog::_Run()
+{
+    std::unique_lock<std::mutex> lock(m_WakeMutex);
+
+    while (!m_Stop)
+    {
+        m_Wake.wait_for(lock, kDrainInterval, [this]() { return m_Stop; });
+
+        lock.unlock();
+        _Drain();
+        lock.lock();
+    }
+}
@@ -1,25 +1,65 @@
 #include <ExampleDelegate/ExMesh.h>
+#include <ExampleDelegate/ExLog.h>
+#include <ExampleDelegate/ExRenderParam.h>
+#include <ExampleDelegate/ExRenderStats.h>
+#include <ExampleDelegate/ExVertexQuantization.h>
 
-#include <iostream>
+#include <pxr/base/trace/trace.h>
+#include <pxr/base/work/reduce.h>
+#include <pxr/imaging/hd/renderIndex.h>
+
+#include <cstring>
 
 ExMesh::ExMesh(SdfPath const& id)
-    : HdMesh(id)
+    : HdMesh(id), m_Transform(1.0f), m_CullStyle(HdCullStyleDontCare), m_DoubleSided(false), m_QuantizedVertices(false),
+      m_DrawTable(nullptr), m_DrawSlot(UINT32_MAX), m_AuthoredNormals(false), m_IndicesPublished(false)
 {
 }
 
 HdDirtyBits ExMesh::GetInitialDirtyBitsMask() const
 {
-    return HdChangeTracker::Clean | HdChangeTracker::DirtyTransform;
+    return HdChangeTracker::Clean           | 
+           HdChangeTracker::InitRepr        |
+           HdChangeTracker::DirtyTopology   |
+           HdChangeTracker::DirtyPoints     |
+           HdChangeTracker::DirtyNormals    |
+           HdChangeTracker::DirtyTransform  |
+           HdChangeTracker::DirtyVisibility |
+           HdChangeTracker::DirtyPrimvar    |
+           HdChangeTracker::DirtyInstancer  |
+           HdChangeTracker::DirtyInstanceIndex |
+           HdChangeTracker::DirtyCullStyle  |
+           HdChangeTracker::DirtyDoubleSided;
 }
 
 HdDirtyBits ExMesh::_PropagateDirtyBits(HdDirtyBits bits) const
 {
+    // A topology change is the one full rebuild: the point count may have changed with it, so the
+    // points (and any authored normals and colors) are pulled again too.
+    if (bits & HdChangeTracker::DirtyTopology)
+        bits |= HdChangeTracker::DirtyPoints | HdChangeTracker::DirtyNormals | HdChangeTracker::DirtyPrimvar;
+
     return bits;
 }
 
-void ExMesh::_InitRepr(TfToken const &reprToken, HdDirtyBits *dirtyBits)
+// Queue a vertex stream for upload, in its compact encoding when the mesh is quantized. A topology change adds
+// the stream anew, otherwise it is patched (the encodings keep their size along with the vertex count).
+template <typename Encode>
+static ExGeometryRangeSharedPtr UploadVertexStream(ExResourceRegistry* registry, ExGeometryRangeSharedPtr const& range, bool add,
+                                                   VtVec3fArray const& stream, bool quantized, Encode const& encode)
 {
+    if (quantized)
+    {
+        VtUIntArray encoded = encode(stream);
+        return add ? registry->AddGeometry(encoded) : registry->UpdateGeometry(range, encoded);
+    }
 
+    return add ? registry->AddGeometry(stream) : registry->UpdateGeometry(range, stream);
+}
+
+void ExMesh::_InitRepr(TfToken const &reprToken, HdDirtyBits *dirtyBits)
+{
+    // Every repr draws the same triangles, so there is no per-repr state to set up.
 }
 
 void ExMesh::Sync(HdSceneDelegate *sceneDelegate,
@@ -27,5 +67,301 @@ void ExMesh::Sync(HdSceneDelegate *sceneDelegate,
                 HdDirtyBits     *dirtyBits,
                 TfToken const   &reprToken)
 {
-    std::cout << "* (multithreaded) Sync Tiny Mesh id=" << GetId() << std::endl;
+    TRACE_FUNCTION();
+    ExScopedTimer timer(renderParam != nullptr ? static_cast<ExRenderParam*>(renderParam)->GetRenderStats() : nullptr, ExRenderPhase::Sync);
+
+    EX_LOG(EX_DEBUG_SYNC, "Sync Mesh id=%s", GetId().GetText());
+
+    SdfPath const& id = GetId();
+
+    // Only pull on data that is marked dirty. Everything written here is owned by this mesh, so
+    // concurrent Sync() calls on other meshes never contend with us.
+
+    bool topologyDirty = HdChangeTracker::IsTopologyDirty(*dirtyBits, id);
+
+    if (topologyDirty)
+        _SyncTopology(sceneDelegate);
+
+    bool pointsDirty = HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, HdTokens->points);
+
+    if (pointsDirty)
+    {
+        VtValue points = GetPoints(sceneDelegate);
+
+        if (points.IsHolding<VtVec3fArray>())
+            m_Geometry.positions = points.UncheckedGet<VtVec3fArray>();
+        else
+            m_Geometry.positions = VtVec3fArray();
+
+        // Object-space bounds for culling, taken from the points themselves rather than the authored extent.
+        m_LocalBounds = GfRange3f();
+
+        for (GfVec3f const& position : m_Geometry.positions)
+            m_LocalBounds.UnionWith(position);
+    }
+
+    bool normalsDirty = HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, HdTokens->normals);
+
+    // Computed normals are a function of the points and topology, so they go stale with either.
+    bool normalsChanged = normalsDirty || (!m_AuthoredNormals && (pointsDirty || topologyDirty));
+
+    if (normalsChanged)
+        _SyncNormals(sceneDelegate, normalsDirty);
+
+    bool colorsDirty = HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, HdTokens->displayColor);
+
+    if (colorsDirty)
+        _SyncColors(sceneDelegate);
+
+    bool transformDirty  = HdChangeTracker::IsTransformDirty(*dirtyBits, id);
+    bool visibilityDirty = HdChangeTracker::IsVisibilityDirty(*dirtyBits, id);
+
+    if (transformDirty)
+        m_Transform = GfMatrix4f(sceneDelegate->GetTransform(id));
+
+    if (visibilityDirty)
+        _UpdateVisibility(sceneDelegate, dirtyBits);
+
+    // Only read by the passes when they cull clusters, nothing to re-resolve.
+    if (HdChangeTracker::IsCullStyleDirty(*dirtyBits, id))
+        m_CullStyle = GetCullStyle(sceneDelegate);
+
+    if (HdChangeTracker::IsDoubleSidedDirty(*dirtyBits, id))
+        m_DoubleSided = GetDoubleSided(sceneDelegate);
+
+    // Parent instancers are synced on demand (once, however many prototypes share them).
+    _UpdateInstancer(sceneDelegate, dirtyBits);
+    HdInstancer::_SyncInstancerAndParents(sceneDelegate->GetRenderIndex(), GetInstancerId());
+
+    // Never hand out indices that reference points that don't exist. The topology is kept, so the mesh is
+    // triangulated again once enough points arrive (possibly in a later, points-only change).
+    bool pointsCoverTopology = m_Topology.GetNumPoints() <= (int)m_Geometry.positions.size();
+    bool indicesDirty        = topologyDirty || (pointsDirty && pointsCoverTopology != m_IndicesPublished);
+
+    if (indicesDirty)
+    {
+        if (pointsCoverTopology)
+        {
+            _TriangulateTopology();
+        }
+        else
+        {
+            TF_WARN("Mesh %s references %d points but only %zu were provided, skipping.", 
+                id.GetText(), m_Topology.GetNumPoints(), m_Geometry.positions.size());
+
+            m_Geometry.indices         = VtVec3iArray();
+            m_Geometry.primitiveParams = VtIntArray();
+        }
+
+        m_IndicesPublished = pointsCoverTopology;
+    }
+
+    // Queue the changed streams for upload. The registry batches them into a single transfer at
+    // commit time and shares storage between meshes with identical data. Outside of a topology
+    // change, streams keep their size and are patched in place (e.g. deforming points).
+    auto resourceRegistry = std::static_pointer_cast<ExResourceRegistry>(sceneDelegate->GetRenderIndex().GetResourceRegistry());
+
+    // The slot is stored in every instance, so it is acquired before they are built.
+    bool firstSync = m_DrawSlot == UINT32_MAX;
+
+    if (firstSync)
+    {
+        m_DrawTable = resourceRegistry->GetDrawTable();
+        m_DrawSlot  = m_DrawTable->AcquireSlot(this);
+
+        m_QuantizedVertices = resourceRegistry->QuantizesVertices();
+    }
+
+    bool instancesDirty = firstSync || HdChangeTracker::IsInstancerDirty(*dirtyBits, id) || HdChangeTracker::IsInstanceIndexDirty(*dirtyBits, id);
+
+    if (instancesDirty)
+        _SyncInstances(sceneDelegate);
+
+    if (IsInstanced() && (instancesDirty || pointsDirty || transformDirty))
+        _UpdateInstanceBounds();
+
+    // Only the device copies are quantized, culling and the software rasterizer keep reading full precision.
+    // Positions are relative to the local bounds, which are current as of this sync.
+    if (topologyDirty || pointsDirty)
+    {
+        m_PositionRange = UploadVertexStream(resourceRegistry.get(), m_PositionRange, topologyDirty, m_Geometry.positions, m_QuantizedVertices,
+                                             [this](VtVec3fArray const& positions) { return ExQuantizePositions(positions, m_LocalBounds); });
+    }
+
+    if (topologyDirty || normalsChanged)
+        m_NormalRange = UploadVertexStream(resourceRegistry.get(), m_NormalRange, topologyDirty, m_Geometry.normals, m_QuantizedVertices, ExEncodeNormals);
+
+    if (topologyDirty || colorsDirty)
+        m_ColorRange = UploadVertexStream(resourceRegistry.get(), m_ColorRange, topologyDirty, m_Geometry.colors, m_QuantizedVertices, ExEncodeHalf3);
+
+    if (indicesDirty)
+    {
+        // Reorders the triangles cluster by cluster, so it goes ahead of everything built from the indices.
+        m_Clusters.clear();
+
+        if (!resourceRegistry->IsHostOnly())
+            m_Clusters = ExBuildClusters(m_Geometry.positions, &m_Geometry.indices, &m_Geometry.primitiveParams);
+
+        m_IndexRange = resourceRegistry->AddGeometry(m_Geometry.indices);
+
+        // Simplified from the points of this sync. Levels only hold indices, so a deforming mesh keeps drawing
+        // its current points with them, and they are only rebuilt along with the topology.
+        m_LodChain = resourceRegistry->GetLodChain(m_Geometry.positions, m_Geometry.indices);
+
+        m_LodIndexRanges.clear();
+
+        if (m_LodChain != nullptr)
+        {
+            for (ExMeshLod const& lod : *m_LodChain)
+                m_LodIndexRanges.push_back(resourceRegistry->AddGeometry(lod.indices));
+        }
+    }
+    else if (pointsDirty && !m_Clusters.empty())
+        ExUpdateClusterBounds(m_Geometry.positions, m_Geometry.indices, &m_Clusters);
+
+    if (instancesDirty)
+        m_InstanceRange = resourceRegistry->UpdateGeometry(m_InstanceRange, m_Instances);
+
+    // The draw record is re-resolved at commit, once the new ranges have a place in the heap. A change
+    // of transform alone keeps the record and only patches the slot's matrix.
+    if (indicesDirty || pointsDirty || normalsChanged || colorsDirty || visibilityDirty || instancesDirty)
+        m_DrawTable->MarkDirty(m_DrawSlot);
+    else if (transformDirty)
+        m_DrawTable->MarkTransformDirty(m_DrawSlot);
+
+    *dirtyBits &= ~HdChangeTracker::AllSceneDirtyBits;
+}
+
+void ExMesh::Finalize(HdRenderParam *renderParam)
+{
+    if (m_DrawSlot != UINT32_MAX)
+        m_DrawTable->ReleaseSlot(m_DrawSlot);
+
+    m_DrawSlot = UINT32_MAX;
+}
+
+void ExMesh::_SyncTopology(HdSceneDelegate* sceneDelegate)
+{
+    // Refine level 0 (no subdivision).
+    m_Topology = HdMeshTopology(GetMeshTopology(sceneDelegate), 0);
+
+    // Only needed to compute normals, but only depends on topology so build it once here.
+    m_Adjacency.BuildAdjacencyTable(&m_Topology);
+}
+
+void ExMesh::_TriangulateTopology()
+{
+    VtVec3iArray indices;
+    VtIntArray   primitiveParams;
+
+    HdMeshUtil meshUtil(&m_Topology, GetId());
+    meshUtil.ComputeTriangleIndices(&indices, &primitiveParams);
+
+    // Strip the edge flags so that each triangle just carries the index of the face it came from.
+    for (int& primitiveParam : primitiveParams)
+        primitiveParam = HdMeshUtil::DecodeFaceIndexFromCoarseFaceParam(primitiveParam);
+
+    m_Geometry.indices         = std::move(indices);
+    m_Geometry.primitiveParams = std::move(primitiveParams);
+}
+
+void ExMesh::_SyncNormals(HdSceneDelegate* sceneDelegate, bool normalsDirty)
+{
+    if (normalsDirty)
+    {
+        m_AuthoredNormals = false;
+
+        // Only per-vertex normals can be used directly with the triangulated index buffer.
+        for (HdInterpolation interpolation : { HdInterpolationVertex, HdInterpolationVarying })
+        {
+            for (HdPrimvarDescriptor const& primvar : GetPrimvarDescriptors(sceneDelegate, interpolation))
+            {
+                if (primvar.name != HdTokens->normals)
+                    continue;
+
+                VtValue normals = GetNormals(sceneDelegate);
+
+                if (normals.IsHolding<VtVec3fArray>() && normals.UncheckedGet<VtVec3fArray>().size() == m_Geometry.positions.size())
+                {
+                    m_Geometry.normals = normals.UncheckedGet<VtVec3fArray>();
+                    m_AuthoredNormals  = true;
+                }
+            }
+        }
+
+        if (m_AuthoredNormals)
+            return;
+    }
+
+    m_Geometry.normals = Hd_SmoothNormals::ComputeSmoothNormals(&m_Adjacency, (int)m_Geometry.positions.size(), m_Geometry.positions.cdata());
+}
+
+void ExMesh::_SyncColors(HdSceneDelegate* sceneDelegate)
+{
+    m_Geometry.colors = VtVec3fArray();
+
+    // Same restriction as normals. Meshes without colors are drawn with a variant that never reads them.
+    for (HdInterpolation interpolation : { HdInterpolationVertex, HdInterpolationVarying })
+    {
+        for (HdPrimvarDescriptor const& primvar : GetPrimvarDescriptors(sceneDelegate, interpolation))
+        {
+            if (primvar.name != HdTokens->displayColor)
+                continue;
+
+            VtValue colors = GetPrimvar(sceneDelegate, HdTokens->displayColor);
+
+            if (colors.IsHolding<VtVec3fArray>() && colors.UncheckedGet<VtVec3fArray>().size() == m_Geometry.positions.size())
+                m_Geometry.colors = colors.UncheckedGet<VtVec3fArray>();
+        }
+    }
+}
+
+void ExMesh::_SyncInstances(HdSceneDelegate* sceneDelegate)
+{
+    if (!IsInstanced())
+    {
+        ExInstance identity = ExEncodeInstance(GfMatrix4d(1.0), m_DrawSlot);
+
+        m_Instances = VtUIntArray(kInstanceWords);
+        memcpy(m_Instances.data(), &identity, sizeof(ExInstance));
+
+        return;
+    }
+
+    auto* instancer = static_cast<ExInstancer*>(sceneDelegate->GetRenderIndex().GetInstancer(GetInstancerId()));
+
+    if (!TF_VERIFY(instancer != nullptr))
+    {
+        m_Instances = VtUIntArray();
+        return;
+    }
+
+    m_Instances = instancer->ComputeInstances(GetId(), m_DrawSlot);
+}
+
+void ExMesh::_UpdateInstanceBounds()
+{
+    m_InstanceBounds = GfRange3f();
+
+    if (m_LocalBounds.IsEmpty())
+        return;
+
+    GfRange3d meshBounds = GfBBox3d(GfRange3d(m_LocalBounds), GfMatrix4d(m_Transform)).ComputeAlignedRange();
+
+    ExInstance const* instances = reinterpret_cast<ExInstance const*>(m_Instances.cdata());
+
+    m_InstanceBounds = WorkParallelReduceN(GfRange3f(), GetInstanceCount(),
+        [&](size_t begin, size_t end, GfRange3f const& identity)
+        {
+            GfRange3f bounds = identity;
+
+            for (size_t i = begin; i < end; ++i)
+                bounds.UnionWith(GfRange3f(GfBBox3d(meshBounds, GfMatrix4d(ExDecodeInstance(instances[i]))).ComputeAlignedRange()));
+
+            return bounds;
+        },
+        [](GfRange3f const& a, GfRange3f const& b)
+        {
+            return GfRange3f::GetUnion(a, b);
+        });
 }
@@ -0,0 +1,268 @@
+#include <ExampleDelegate/ExMeshClusters.h>
+
+#include <pxr/base/trace/trace.h>
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <cmath>
+
+// Below this a mesh is culled as a whole, its clusters wouldn't pay for their own tests.
+static constexpr size_t kMinClusteredTriangles = 4096u;
+
+static int8_t QuantizeSnorm8(float value)
+{
+    return (int8_t)std::clamp((int)std::round(value * 127.0f), -127, 127);
+}
+
+std::vector<ExMeshCluster> ExBuildClusters(VtVec3fArray const& positions, VtVec3iArray* triangles, VtIntArray* primitiveParams)
+{
+    TRACE_FUNCTION();
+
+    const uint32_t vertexCount   = (uint32_t)positions.size();
+    const uint32_t triangleCount = (uint32_t)triangles->size();
+
+    if (triangleCount < kMinClusteredTriangles)
+        return {};
+
+    GfVec3i const* source = triangles->cdata();
+
+    for (uint32_t t = 0u; t < triangleCount; ++t)
+    {
+        for (uint32_t corner = 0u; corner < 3u; ++corner)
+        {
+            if (source[t][corner] < 0 || (uint32_t)source[t][corner] >= vertexCount)
+                return {};
+        }
+    }
+
+    // Vertex -> triangles.
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1u, 0u);
+
+    for (uint32_t t = 0u; t < triangleCount; ++t)
+    {
+        for (uint32_t corner = 0u; corner < 3u; ++corner)
+            adjacencyOffsets[source[t][corner] + 1u]++;
+    }
+
+    for (uint32_t v = 0u; v < vertexCount; ++v)
+        adjacencyOffsets[v + 1u] += adjacencyOffsets[v];
+
+    std::vector<uint32_t> adjacency(3u * (size_t)triangleCount);
+    {
+        std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+        for (uint32_t t = 0u; t < triangleCount; ++t)
+        {
+            for (uint32_t corner = 0u; corner < 3u; ++corner)
+                adjacency[cursor[source[t][corner]]++] = t;
+        }
+    }
+
+    std::vector<bool>     emitted(triangleCount, false);
+    std::vector<uint32_t> vertexCluster(vertexCount, UINT32_MAX);
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> clusterVertices;
+
+    order.reserve(triangleCount);
+    clusterVertices.reserve(kMaxClusterVertices);
+
+    std::vector<ExMeshCluster> clusters;
+    clusters.reserve(triangleCount / kMaxClusterTriangles + 1u);
+
+    // Vertices a triangle would add to the cluster.
+    auto NewVertexCount = [&](uint32_t t, uint32_t cluster)
+    {
+        return (uint32_t)(vertexCluster[source[t][0]] != cluster) +
+               (uint32_t)(vertexCluster[source[t][1]] != cluster) +
+               (uint32_t)(vertexCluster[source[t][2]] != cluster);
+    };
+
+    // Triangle left around a set of vertices that adds the fewest vertices to the cluster.
+    auto FindNeighbour = [&](uint32_t const* vertices, size_t count, uint32_t cluster, uint32_t* best)
+    {
+        uint32_t bestNewVertices = 4u;
+
+        for (size_t i = 0u; i < count; ++i)
+        {
+            for (uint32_t j = adjacencyOffsets[vertices[i]]; j < adjacencyOffsets[vertices[i] + 1u]; ++j)
+            {
+                uint32_t t = adjacency[j];
+
+                if (emitted[t])
+                    continue;
+
+                uint32_t newVertices = NewVertexCount(t, cluster);
+
+                if (newVertices < bestNewVertices)
+                {
+                    *best           = t;
+                    bestNewVertices = newVertices;
+                }
+            }
+        }
+    };
+
+    uint32_t seed = 0u;
+
+    while (order.size() < triangleCount)
+    {
+        uint32_t cluster          = (uint32_t)clusters.size();
+        uint32_t clusterTriangles = 0u;
+
+        clusterVertices.clear();
+
+        // Start from the first triangle left, input order tends to be coherent already.
+        while (emitted[seed])
+            seed++;
+
+        uint32_t next = seed;
+
+        for (;;)
+        {
+            if (clusterTriangles == kMaxClusterTriangles || clusterVertices.size() + NewVertexCount(next, cluster) > kMaxClusterVertices)
+                break;
+
+            emitted[next] = true;
+            order.push_back(next);
+            clusterTriangles++;
+
+            uint32_t lastVertices[3];
+
+            for (uint32_t corner = 0u; corner < 3u; ++corner)
+            {
+                lastVertices[corner] = (uint32_t)source[next][corner];
+
+                if (vertexCluster[lastVertices[corner]] != cluster)
+                {
+                    vertexCluster[lastVertices[corner]] = cluster;
+                    clusterVertices.push_back(lastVertices[corner]);
+                }
+            }
+
+            // Grow from the triangle just added, only looking around the whole cluster once that is a dead end.
+            uint32_t best = UINT32_MAX;
+
+            FindNeighbour(lastVertices, 3u, cluster, &best);
+
+            if (best == UINT32_MAX)
+                FindNeighbour(clusterVertices.data(), clusterVertices.size(), cluster, &best);
+
+            // The cluster's piece of the surface is used up.
+            if (best == UINT32_MAX)
+                break;
+
+            next = best;
+        }
+
+        ExMeshCluster& newCluster = clusters.emplace_back();
+        newCluster.firstIndex = 3u * (uint32_t)(order.size() - clusterTriangles);
+        newCluster.indexCount = 3u * clusterTriangles;
+    }
+
+    VtVec3iArray reordered(triangleCount);
+
+    for (uint32_t i = 0u; i < triangleCount; ++i)
+        reordered[i] = source[order[i]];
+
+    if (primitiveParams->size() == triangleCount)
+    {
+        VtIntArray reorderedParams(triangleCount);
+
+        for (uint32_t i = 0u; i < triangleCount; ++i)
+            reorderedParams[i] = primitiveParams->cdata()[order[i]];
+
+        *primitiveParams = std::move(reorderedParams);
+    }
+
+    *triangles = std::move(reordered);
+
+    ExUpdateClusterBounds(positions, *triangles, &clusters);
+
+    return clusters;
+}
+
+void ExUpdateClusterBounds(VtVec3fArray const& positions, VtVec3iArray const& triangles, std::vector<ExMeshCluster>* clusters)
+{
+    TRACE_FUNCTION();
+
+    GfVec3i const* source = triangles.cdata();
+
+    WorkParallelForN(clusters->size(), [&](size_t begin, size_t end)
+    {
+        GfVec3f normals[kMaxClusterTriangles];
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            ExMeshCluster& cluster = (*clusters)[i];
+
+            GfVec3i const* clusterTriangles = source + cluster.firstIndex / 3u;
+            uint32_t       triangleCount    = cluster.indexCount / 3u;
+
+            GfRange3f box;
+
+            for (uint32_t t = 0u; t < triangleCount; ++t)
+            {
+                for (uint32_t corner = 0u; corner < 3u; ++corner)
+                    box.UnionWith(positions[clusterTriangles[t][corner]]);
+            }
+
+            cluster.center = box.GetMidpoint();
+            cluster.radius = 0.0f;
+
+            for (uint32_t t = 0u; t < triangleCount; ++t)
+            {
+                for (uint32_t corner = 0u; corner < 3u; ++corner)
+                    cluster.radius = std::max(cluster.radius, (positions[clusterTriangles[t][corner]] - cluster.center).GetLength());
+            }
+
+            // The cone's axis is the area-weighted average normal, degenerate triangles face nowhere and are left out.
+            GfVec3f  normalSum(0.0f);
+            uint32_t normalCount = 0u;
+
+            for (uint32_t t = 0u; t < triangleCount; ++t)
+            {
+                GfVec3f const& p0 = positions[clusterTriangles[t][0]];
+                GfVec3f const& p1 = positions[clusterTriangles[t][1]];
+                GfVec3f const& p2 = positions[clusterTriangles[t][2]];
+
+                GfVec3f normal = GfCross(p1 - p0, p2 - p0);
+                float   length = normal.GetLength();
+
+                if (length <= 0.0f)
+                    continue;
+
+                normalSum += normal;
+                normals[normalCount++] = normal / length;
+            }
+
+            cluster.coneAxis[0] = cluster.coneAxis[1] = cluster.coneAxis[2] = 0;
+            cluster.coneCutoff  = kNoNormalCone;
+
+            float sumLength = normalSum.GetLength();
+
+            if (normalCount == 0u || sumLength <= 0.0f)
+                continue;
+
+            for (uint32_t axis = 0u; axis < 3u; ++axis)
+                cluster.coneAxis[axis] = QuantizeSnorm8(normalSum[axis] / sumLength);
+
+            // The spread is measured against the axis as it is stored, so quantization never makes the cone too narrow.
+            GfVec3f storedAxis = GfVec3f(cluster.coneAxis[0], cluster.coneAxis[1], cluster.coneAxis[2]).GetNormalized();
+
+            float minDot = 1.0f;
+
+            for (uint32_t n = 0u; n < normalCount; ++n)
+                minDot = std::min(minDot, GfDot(normals[n], storedAxis));
+
+            // Normals a right angle or more apart: some triangle faces any given eye.
+            if (minDot <= 0.0f)
+                continue;
+
+            // Back-facing once the view direction is within 90 degrees minus the spread of the axis, i.e. its cosine
+            // to the axis is above the sine of the spread. Rounded up, which only ever culls less.
+            float cutoff = std::sqrt(std::max(1.0f - minDot * minDot, 0.0f));
+
+            cluster.coneCutoff = (int8_t)std::min((int)std::ceil(cutoff * 127.0f), (int)kNoNormalCone);
+        }
+    });
+}
@@ -0,0 +1,330 @@
+#include <ExampleDelegate/ExMeshSimplifier.h>
+
+#include <pxr/base/gf/vec3d.h>
+#include <pxr/base/trace/trace.h>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+// Quadrics
+// ---------------------
+
+// Area-weighted sum of squared distances to a set of planes, as the symmetric 4x4 matrix of Garland and
+// Heckbert (upper triangle). Divided by the weight it is the mean squared distance to the planes.
+struct Quadric
+{
+    double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+    double b2 = 0.0, bc = 0.0, bd = 0.0;
+    double c2 = 0.0, cd = 0.0;
+    double d2 = 0.0;
+
+    double weight = 0.0;
+};
+
+// Quadric of the plane n.p + d = 0 (unit normal).
+static Quadric PlaneQuadric(GfVec3d const& n, double d, double weight)
+{
+    Quadric q;
+    q.a2 = weight * n[0] * n[0]; q.ab = weight * n[0] * n[1]; q.ac = weight * n[0] * n[2]; q.ad = weight * n[0] * d;
+    q.b2 = weight * n[1] * n[1]; q.bc = weight * n[1] * n[2]; q.bd = weight * n[1] * d;
+    q.c2 = weight * n[2] * n[2]; q.cd = weight * n[2] * d;
+    q.d2 = weight * d * d;
+
+    q.weight = weight;
+
+    return q;
+}
+
+static void AddQuadric(Quadric* q, Quadric const& r)
+{
+    q->a2 += r.a2; q->ab += r.ab; q->ac += r.ac; q->ad += r.ad;
+    q->b2 += r.b2; q->bc += r.bc; q->bd += r.bd;
+    q->c2 += r.c2; q->cd += r.cd;
+    q->d2 += r.d2;
+
+    q->weight += r.weight;
+}
+
+// Mean squared distance of a point to the planes of the quadric.
+static double EvaluateQuadric(Quadric const& q, GfVec3f const& p)
+{
+    if (q.weight <= 0.0)
+        return 0.0;
+
+    double x = p[0], y = p[1], z = p[2];
+
+    double error = q.a2 * x * x + 2.0 * q.ab * x * y + 2.0 * q.ac * x * z + 2.0 * q.ad * x
+                 + q.b2 * y * y + 2.0 * q.bc * y * z + 2.0 * q.bd * y
+                 + q.c2 * z * z + 2.0 * q.cd * z
+                 + q.d2;
+
+    // Rounding can take a near-zero error slightly negative.
+    return std::max(error, 0.0) / q.weight;
+}
+
+static GfVec3d TriangleNormal(GfVec3f const& p0, GfVec3f const& p1, GfVec3f const& p2)
+{
+    return GfCross(GfVec3d(p1 - p0), GfVec3d(p2 - p0));
+}
+
+// Simplification
+// ---------------------
+
+// Passes give up once no collapse is possible, this only bounds pathological inputs.
+static constexpr uint32_t kMaxSimplifyPasses = 64u;
+
+// A candidate collapse of one vertex into a neighbour.
+struct Collapse
+{
+    uint32_t from;
+    uint32_t to;
+    double   cost;
+};
+
+VtVec3iArray ExSimplifyTriangles(VtVec3fArray const& positions, VtVec3iArray const& triangles, size_t targetTriangleCount, float* error)
+{
+    TRACE_FUNCTION();
+
+    *error = 0.0f;
+
+    const uint32_t vertexCount = (uint32_t)positions.size();
+
+    std::vector<uint32_t> indices(3u * triangles.size());
+
+    for (size_t i = 0u; i < triangles.size(); ++i)
+    {
+        for (uint32_t corner = 0u; corner < 3u; ++corner)
+        {
+            int index = triangles[i][corner];
+
+            // Out of range indices can't be reasoned about, leave the mesh alone.
+            if (index < 0 || (uint32_t)index >= vertexCount)
+                return triangles;
+
+            indices[3u * i + corner] = (uint32_t)index;
+        }
+    }
+
+    // Each vertex starts with the planes of the triangles around it.
+    std::vector<Quadric> quadrics(vertexCount);
+
+    for (size_t i = 0u; i < indices.size(); i += 3u)
+    {
+        GfVec3d normal = TriangleNormal(positions[indices[i]], positions[indices[i + 1u]], positions[indices[i + 2u]]);
+        double  length = normal.GetLength();
+
+        if (length <= 0.0)
+            continue;
+
+        normal /= length;
+
+        Quadric plane = PlaneQuadric(normal, -GfDot(normal, GfVec3d(positions[indices[i]])), 0.5 * length);
+
+        for (uint32_t corner = 0u; corner < 3u; ++corner)
+            AddQuadric(&quadrics[indices[i + corner]], plane);
+    }
+
+    // Vertices on an edge that isn't shared by exactly two triangles stay put (determined once, from the input).
+    std::vector<bool> locked(vertexCount, false);
+    {
+        std::unordered_map<uint64_t, uint32_t> edgeUses;
+        edgeUses.reserve(indices.size());
+
+        for (size_t i = 0u; i < indices.size(); i += 3u)
+        {
+            for (uint32_t corner = 0u; corner < 3u; ++corner)
+            {
+                uint32_t a = indices[i + corner], b = indices[i + (corner + 1u) % 3u];
+                edgeUses[((uint64_t)std::min(a, b) << 32u) | std::max(a, b)]++;
+            }
+        }
+
+        for (auto const& edge : edgeUses)
+        {
+            if (edge.second != 2u)
+            {
+                locked[(uint32_t)(edge.first >> 32u)]         = true;
+                locked[(uint32_t)(edge.first & 0xFFFFFFFFu)] = true;
+            }
+        }
+    }
+
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<bool>     touched(vertexCount);
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1u);
+    std::vector<uint32_t> adjacency;
+
+    double maxCost = 0.0;
+
+    for (uint32_t pass = 0u; pass < kMaxSimplifyPasses && indices.size() / 3u > targetTriangleCount; ++pass)
+    {
+        // Vertex -> triangles, for the flip test.
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0u);
+
+        for (uint32_t index : indices)
+            adjacencyOffsets[index + 1u]++;
+
+        for (uint32_t v = 0u; v < vertexCount; ++v)
+            adjacencyOffsets[v + 1u] += adjacencyOffsets[v];
+
+        adjacency.resize(indices.size());
+        {
+            std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+            for (size_t i = 0u; i < indices.size(); ++i)
+                adjacency[cursor[indices[i]]++] = (uint32_t)(i / 3u);
+        }
+
+        // Every directed edge out of an unlocked vertex, cheapest first. Interior edges show up twice, the
+        // second one is skipped below as its vertices are already touched.
+        collapses.clear();
+
+        for (size_t i = 0u; i < indices.size(); i += 3u)
+        {
+            for (uint32_t corner = 0u; corner < 3u; ++corner)
+            {
+                uint32_t a = indices[i + corner], b = indices[i + (corner + 1u) % 3u];
+
+                for (uint32_t direction = 0u; direction < 2u; ++direction)
+                {
+                    uint32_t from = direction == 0u ? a : b;
+                    uint32_t to   = direction == 0u ? b : a;
+
+                    if (locked[from])
+                        continue;
+
+                    Quadric merged = quadrics[from];
+                    AddQuadric(&merged, quadrics[to]);
+
+                    collapses.push_back({ from, to, EvaluateQuadric(merged, positions[to]) });
+                }
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](Collapse const& l, Collapse const& r) { return l.cost < r.cost; });
+
+        // A collapse removes about two triangles, don't overshoot the target by much in the last pass.
+        size_t collapseBudget = (indices.size() / 3u - targetTriangleCount) / 2u + 1u;
+        size_t collapseCount  = 0u;
+
+        for (uint32_t v = 0u; v < vertexCount; ++v)
+            remap[v] = v;
+
+        std::fill(touched.begin(), touched.end(), false);
+
+        for (Collapse const& collapse : collapses)
+        {
+            if (collapseCount >= collapseBudget)
+                break;
+
+            // At most one change per neighbourhood per pass, so each flip test sees the final triangles.
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+
+            bool flips = false;
+
+            for (uint32_t j = adjacencyOffsets[collapse.from]; j < adjacencyOffsets[collapse.from + 1u] && !flips; ++j)
+            {
+                uint32_t const* triangle = &indices[3u * adjacency[j]];
+
+                // Triangles on the collapsed edge degenerate and go away.
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                    continue;
+
+                GfVec3f moved[3];
+                for (uint32_t corner = 0u; corner < 3u; ++corner)
+                    moved[corner] = positions[triangle[corner] == collapse.from ? collapse.to : triangle[corner]];
+
+                GfVec3d before = TriangleNormal(positions[triangle[0]], positions[triangle[1]], positions[triangle[2]]);
+                GfVec3d after  = TriangleNormal(moved[0], moved[1], moved[2]);
+
+                flips = GfDot(before, after) <= 0.0;
+            }
+
+            if (flips)
+                continue;
+
+            remap[collapse.from] = collapse.to;
+
+            for (uint32_t j = adjacencyOffsets[collapse.from]; j < adjacencyOffsets[collapse.from + 1u]; ++j)
+            {
+                uint32_t const* triangle = &indices[3u * adjacency[j]];
+
+                touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+            }
+
+            AddQuadric(&quadrics[collapse.to], quadrics[collapse.from]);
+
+            maxCost = std::max(maxCost, collapse.cost);
+            collapseCount++;
+        }
+
+        if (collapseCount == 0u)
+            break;
+
+        // Apply the pass, dropping the triangles that degenerated.
+        size_t written = 0u;
+
+        for (size_t i = 0u; i < indices.size(); i += 3u)
+        {
+            uint32_t a = remap[indices[i]], b = remap[indices[i + 1u]], c = remap[indices[i + 2u]];
+
+            if (a == b || b == c || a == c)
+                continue;
+
+            indices[written++] = a;
+            indices[written++] = b;
+            indices[written++] = c;
+        }
+
+        indices.resize(written);
+    }
+
+    *error = (float)std::sqrt(maxCost);
+
+    VtVec3iArray simplified(indices.size() / 3u);
+
+    for (size_t i = 0u; i < simplified.size(); ++i)
+        simplified[i] = GfVec3i((int)indices[3u * i], (int)indices[3u * i + 1u], (int)indices[3u * i + 2u]);
+
+    return simplified;
+}
+
+// LOD Chains
+// ---------------------
+
+// Below this a mesh is cheap enough as it is.
+static constexpr size_t kMinLodTriangles = 256u;
+
+// A level that doesn't get rid of at least this fraction of its parent's triangles isn't worth a draw range.
+static constexpr float kMinLodReduction = 0.25f;
+
+ExMeshLodChain ExBuildLodChain(VtVec3fArray const& positions, VtVec3iArray const& triangles, uint32_t maxLevels)
+{
+    TRACE_FUNCTION();
+
+    ExMeshLodChain chain;
+    chain.reserve(maxLevels);
+
+    VtVec3iArray const* parent = &triangles;
+
+    while (chain.size() < maxLevels && parent->size() >= kMinLodTriangles)
+    {
+        ExMeshLod lod;
+        lod.indices = ExSimplifyTriangles(positions, *parent, parent->size() / 2u, &lod.error);
+
+        if ((float)lod.indices.size() > (1.0f - kMinLodReduction) * (float)parent->size())
+            break;
+
+        // Simplifying a level accumulates on the level's own error.
+        if (!chain.empty())
+            lod.error += chain.back().error;
+
+        chain.push_back(std::move(lod));
+        parent = &chain.back().indices;
+    }
+
+    return chain;
+}
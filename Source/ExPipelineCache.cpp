@@ -0,0 +1,252 @@
+#include <ExampleDelegate/ExPipelineCache.h>
+#include <ExampleDelegate/ExLog.h>
+
+#include <VulkanWrappers/Device.h>
+using namespace VulkanWrappers;
+
+#include <pxr/base/arch/hash.h>
+#include <pxr/base/plug/plugin.h>
+#include <pxr/base/plug/registry.h>
+#include <pxr/base/tf/diagnostic.h>
+#include <pxr/base/tf/hash.h>
+#include <pxr/base/trace/trace.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+static std::vector<char> ReadBinaryFile(std::string const& path)
+{
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+
+    if (!file.is_open())
+        return {};
+
+    std::vector<char> data((size_t)file.tellg());
+    file.seekg(0);
+    file.read(data.data(), data.size());
+
+    return data;
+}
+
+ExPipelineCache::ExPipelineCache(Device* device, std::string const& path)
+    : m_Device(device), m_Path(path), m_PipelineCache(VK_NULL_HANDLE)
+{
+    // Reading and handing the blob to the driver can take a while, don't hold up delegate creation.
+    m_Dispatcher.Run([this]() { _GetPipelineCache(); });
+}
+
+ExPipelineCache::~ExPipelineCache()
+{
+    m_Dispatcher.Wait();
+
+    Save();
+
+    for (auto const& entry : m_Pipelines)
+        vkDestroyPipeline(m_Device->GetLogical(), entry.second, nullptr);
+
+    for (auto const& entry : m_ShadersByHash)
+        vkDestroyShaderModule(m_Device->GetLogical(), entry.second, nullptr);
+
+    vkDestroyPipelineCache(m_Device->GetLogical(), m_PipelineCache, nullptr);
+}
+
+VkShaderModule ExPipelineCache::GetShaderModule(std::string const& resource)
+{
+    std::lock_guard<std::mutex> lock(m_ShaderMutex);
+
+    auto it = m_ShadersByResource.find(resource);
+
+    if (it != m_ShadersByResource.end())
+        return it->second;
+
+    TRACE_FUNCTION();
+
+    // Fetch the base plugin in order to construct asset paths.
+    auto pluginBase = PlugRegistry::GetInstance().GetPluginWithName("hdExample");
+
+    if (!TF_VERIFY(pluginBase != nullptr))
+        return VK_NULL_HANDLE;
+
+    std::string path = pluginBase->FindPluginResource(resource);
+
+    std::vector<char> code = ReadBinaryFile(path);
+
+    if (code.empty())
+    {
+        TF_CODING_ERROR("Failed to open shader binary %s", path.c_str());
+        return VK_NULL_HANDLE;
+    }
+
+    // Identical binaries (i.e. a variant that only differs in specialization) share one module.
+    uint64_t hash = ArchHash64(code.data(), code.size());
+
+    VkShaderModule& module = m_ShadersByHash[hash];
+
+    if (module == VK_NULL_HANDLE)
+    {
+        VkShaderModuleCreateInfo moduleInfo = {};
+        moduleInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = code.size();
+        moduleInfo.pCode    = reinterpret_cast<const uint32_t*>(code.data());
+
+        TF_VERIFY(vkCreateShaderModule(m_Device->GetLogical(), &moduleInfo, nullptr, &module) == VK_SUCCESS);
+
+        m_ShaderHashes[module] = hash;
+    }
+
+    m_ShadersByResource[resource] = module;
+
+    return module;
+}
+
+VkPipeline ExPipelineCache::GetGraphicsPipeline(VkGraphicsPipelineCreateInfo const& pipelineInfo, uint64_t stateKey)
+{
+    uint64_t key = TfHash::Combine(stateKey, (uint64_t)pipelineInfo.layout);
+    {
+        std::lock_guard<std::mutex> lock(m_ShaderMutex);
+
+        for (uint32_t i = 0u; i < pipelineInfo.stageCount; ++i)
+        {
+            auto it = m_ShaderHashes.find(pipelineInfo.pStages[i].module);
+
+            if (!TF_VERIFY(it != m_ShaderHashes.end(), "Pipeline stage module not obtained from the cache."))
+                return VK_NULL_HANDLE;
+
+            key = TfHash::Combine(key, it->second, (uint32_t)pipelineInfo.pStages[i].stage);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_PipelineMutex);
+
+        auto it = m_Pipelines.find(key);
+
+        if (it != m_Pipelines.end())
+            return it->second;
+    }
+
+    TRACE_FUNCTION();
+
+    // Compiled outside of the lock, so that variants compile concurrently.
+    VkPipeline pipeline = VK_NULL_HANDLE;
+
+    if (!TF_VERIFY(vkCreateGraphicsPipelines(m_Device->GetLogical(), _GetPipelineCache(), 1u, &pipelineInfo, nullptr, &pipeline) == VK_SUCCESS))
+        return VK_NULL_HANDLE;
+
+    std::lock_guard<std::mutex> lock(m_PipelineMutex);
+
+    auto inserted = m_Pipelines.emplace(key, pipeline);
+
+    // Another thread compiled the same pipeline in the meantime.
+    if (!inserted.second)
+        vkDestroyPipeline(m_Device->GetLogical(), pipeline, nullptr);
+
+    return inserted.first->second;
+}
+
+void ExPipelineCache::Precompile(std::function<void()> const& task)
+{
+    m_Dispatcher.Run(task);
+}
+
+void ExPipelineCache::Wait()
+{
+    m_Dispatcher.Wait();
+}
+
+void ExPipelineCache::Save()
+{
+    if (m_Path.empty() || m_PipelineCache == VK_NULL_HANDLE)
+        return;
+
+    TRACE_FUNCTION();
+
+    size_t size = 0u;
+    vkGetPipelineCacheData(m_Device->GetLogical(), m_PipelineCache, &size, nullptr);
+
+    std::vector<char> data(size);
+
+    if (size == 0u || vkGetPipelineCacheData(m_Device->GetLogical(), m_PipelineCache, &size, data.data()) != VK_SUCCESS)
+        return;
+
+    // Written next to the destination and moved over it, so that another delegate (or process) loading the
+    // blob never sees a partial file.
+    std::string tempPath = m_Path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+
+        if (!file.is_open())
+        {
+            TF_WARN("Failed to write the pipeline cache to %s", tempPath.c_str());
+            return;
+        }
+
+        file.write(data.data(), size);
+    }
+
+    if (std::rename(tempPath.c_str(), m_Path.c_str()) != 0)
+    {
+        TF_WARN("Failed to write the pipeline cache to %s", m_Path.c_str());
+        std::remove(tempPath.c_str());
+    }
+}
+
+VkPipelineCache ExPipelineCache::_GetPipelineCache()
+{
+    std::call_once(m_LoadOnce, [this]() { _Load(); });
+
+    return m_PipelineCache;
+}
+
+void ExPipelineCache::_Load()
+{
+    TRACE_FUNCTION();
+
+    std::vector<char> data;
+
+    if (!m_Path.empty())
+    {
+        data = ReadBinaryFile(m_Path);
+
+        if (!data.empty() && !_IsCompatible(data))
+        {
+            EX_LOG(EX_DEBUG_DELEGATE, "Discarding pipeline cache %s, it was written for another device or driver", m_Path.c_str());
+            data.clear();
+        }
+    }
+
+    VkPipelineCacheCreateInfo cacheInfo = {};
+    cacheInfo.sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = data.size();
+    cacheInfo.pInitialData    = data.empty() ? nullptr : data.data();
+
+    if (vkCreatePipelineCache(m_Device->GetLogical(), &cacheInfo, nullptr, &m_PipelineCache) == VK_SUCCESS)
+        return;
+
+    // A blob the driver rejects regardless is no reason to go without a cache.
+    cacheInfo.initialDataSize = 0u;
+    cacheInfo.pInitialData    = nullptr;
+
+    TF_VERIFY(vkCreatePipelineCache(m_Device->GetLogical(), &cacheInfo, nullptr, &m_PipelineCache) == VK_SUCCESS);
+}
+
+bool ExPipelineCache::_IsCompatible(std::vector<char> const& data) const
+{
+    if (data.size() < sizeof(VkPipelineCacheHeaderVersionOne))
+        return false;
+
+    VkPipelineCacheHeaderVersionOne header;
+    memcpy(&header, data.data(), sizeof(header));
+
+    VmaAllocatorInfo allocatorInfo;
+    vmaGetAllocatorInfo(m_Device->GetAllocator(), &allocatorInfo);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(allocatorInfo.physicalDevice, &properties);
+
+    return header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           header.vendorID      == properties.vendorID &&
+           header.deviceID      == properties.deviceID &&
+           memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
@@ -1 +1,282 @@
-#include <ExampleDelegate/ExRenderBuffer.h>
\ No newline at end of file
+#include <ExampleDelegate/ExRenderBuffer.h>
+#include <ExampleDelegate/ExRenderTargetPool.h>
+#include <ExampleDelegate/ExTimeline.h>
+
+#include <VulkanWrappers/Device.h>
+#include <VulkanWrappers/Buffer.h>
+using namespace VulkanWrappers;
+
+#include <algorithm>
+#include <cstring>
+
+ExRenderBuffer::ExRenderBuffer(SdfPath const& id, Device* device, ExRenderTargetPool* pool, ExTimeline* timeline)
+    : HdRenderBuffer(id), m_Width(0u), m_Height(0u), m_Format(HdFormatInvalid), 
+      m_Device(device), m_Pool(pool), m_Timeline(timeline), m_DeviceBuffer(nullptr), m_Data(nullptr), 
+      m_ResolveValue(0u), m_ResolvePending(false), m_ResolveFinal(true), m_Mappers(0), m_Converged(false)
+{
+    if (m_Device == nullptr)
+        return;
+
+    TF_VERIFY(m_Pool != nullptr && m_Timeline != nullptr);
+}
+
+ExRenderBuffer::~ExRenderBuffer()
+{
+    _Deallocate();
+}
+
+void ExRenderBuffer::Sync(HdSceneDelegate *sceneDelegate, HdRenderParam *renderParam, HdDirtyBits *dirtyBits)
+{
+    // Allocation is driven by the descriptor, nothing delegate specific to pull.
+    HdRenderBuffer::Sync(sceneDelegate, renderParam, dirtyBits);
+}
+
+void ExRenderBuffer::Finalize(HdRenderParam *renderParam)
+{
+    HdRenderBuffer::Finalize(renderParam);
+}
+
+bool ExRenderBuffer::Allocate(GfVec3i const& dimensions, HdFormat format, bool multiSampled)
+{
+    _Deallocate();
+
+    if (dimensions[2] != 1)
+    {
+        TF_WARN("Render buffer %s requested %dx%dx%d, but only depth 1 is supported.",
+            GetId().GetText(), dimensions[0], dimensions[1], dimensions[2]);
+        return false;
+    }
+
+    // Samples are resolved as they are written, so multisampling is ignored.
+    m_Width  = (unsigned int)dimensions[0];
+    m_Height = (unsigned int)dimensions[1];
+    m_Format = format;
+
+    size_t size = m_Width * m_Height * HdDataSizeOfFormat(format);
+
+    if (m_Device == nullptr)
+    {
+        m_Buffer.resize(size, 0u);
+        m_Data = m_Buffer.data();
+
+        return true;
+    }
+
+    if (size == 0u)
+        return true;
+
+    // Copy destination and host view are the same memory, so Map() never copies.
+    m_DeviceBuffer = m_Pool->AcquireBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, 
+                                           VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+
+    VmaAllocationInfo allocInfo;
+    vmaGetAllocationInfo(m_Device->GetAllocator(), m_DeviceBuffer->GetData()->allocation, &allocInfo);
+
+    m_Data = static_cast<uint8_t*>(allocInfo.pMappedData);
+
+    // Pooled memory may hold a previous owner's pixels.
+    memset(m_Data, 0, size);
+
+    return true;
+}
+
+unsigned int ExRenderBuffer::GetWidth() const
+{
+    return m_Width;
+}
+
+unsigned int ExRenderBuffer::GetHeight() const
+{
+    return m_Height;
+}
+
+unsigned int ExRenderBuffer::GetDepth() const
+{
+    return 1u;
+}
+
+HdFormat ExRenderBuffer::GetFormat() const
+{
+    return m_Format;
+}
+
+bool ExRenderBuffer::IsMultiSampled() const
+{
+    return false;
+}
+
+void* ExRenderBuffer::Map()
+{
+    m_Mappers++;
+    return m_Data;
+}
+
+void ExRenderBuffer::Unmap()
+{
+    m_Mappers--;
+}
+
+bool ExRenderBuffer::IsMapped() const
+{
+    return m_Mappers.load() != 0;
+}
+
+bool ExRenderBuffer::IsConverged() const
+{
+    {
+        std::lock_guard<std::mutex> lock(m_ResolveMutex);
+
+        // Poll rather than wait, the caller will simply ask again next frame.
+        if (m_ResolvePending && m_Timeline->IsComplete(m_ResolveValue))
+            _CompleteResolve();
+    }
+
+    return m_Converged.load();
+}
+
+void ExRenderBuffer::SetConverged(bool cv)
+{
+    m_Converged.store(cv);
+}
+
+void ExRenderBuffer::Resolve()
+{
+    // Samples are written final, only a device copy still in flight needs to land.
+    std::lock_guard<std::mutex> lock(m_ResolveMutex);
+
+    _WaitForResolve();
+}
+
+void ExRenderBuffer::BeginResolve()
+{
+    std::lock_guard<std::mutex> lock(m_ResolveMutex);
+
+    // Copies land in the same memory, so the previous one has to complete first.
+    _WaitForResolve();
+
+    m_Converged.store(false);
+}
+
+void ExRenderBuffer::EndResolve(uint64_t timelineValue, bool final)
+{
+    std::lock_guard<std::mutex> lock(m_ResolveMutex);
+
+    m_ResolveFinal = final;
+    m_ResolveValue = timelineValue;
+
+    m_ResolvePending = true;
+}
+
+void ExRenderBuffer::_WaitForResolve() const
+{
+    if (!m_ResolvePending)
+        return;
+
+    m_Timeline->Wait(m_ResolveValue);
+
+    _CompleteResolve();
+}
+
+void ExRenderBuffer::_CompleteResolve() const
+{
+    // Host-visible memory is not necessarily coherent.
+    vmaInvalidateAllocation(m_Device->GetAllocator(), m_DeviceBuffer->GetData()->allocation, 0u, VK_WHOLE_SIZE);
+
+    m_ResolvePending = false;
+    m_Converged.store(m_ResolveFinal);
+}
+
+void ExRenderBuffer::_Deallocate()
+{
+    // If the buffer is mapped while we're doing this, there's not much we can do.
+    TF_VERIFY(!IsMapped());
+
+    {
+        std::lock_guard<std::mutex> lock(m_ResolveMutex);
+
+        // Don't hand memory back to the pool while the GPU is still writing it.
+        _WaitForResolve();
+    }
+
+    m_Width  = 0u;
+    m_Height = 0u;
+    m_Format = HdFormatInvalid;
+
+    m_Buffer.clear();
+    m_Buffer.shrink_to_fit();
+
+    if (m_DeviceBuffer != nullptr)
+        m_Pool->Release(m_DeviceBuffer);
+
+    m_DeviceBuffer = nullptr;
+    m_Data         = nullptr;
+
+    m_Mappers  .store(0);
+    m_Converged.store(false);
+}
+
+void ExRenderBuffer::_WritePixel(uint8_t* dst, size_t numComponents, float const* value) const
+{
+    HdFormat componentFormat = HdGetComponentFormat(m_Format);
+    size_t   componentCount  = HdGetComponentCount(m_Format);
+
+    // Missing source components are written as zero.
+    for (size_t c = 0u; c < componentCount; ++c)
+    {
+        float v = c < numComponents ? value[c] : 0.0f;
+
+        switch (componentFormat)
+        {
+            case HdFormatUNorm8:
+                dst[c] = (uint8_t)(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f);
+                break;
+            case HdFormatSNorm8:
+                reinterpret_cast<int8_t*>(dst)[c] = (int8_t)(std::clamp(v, -1.0f, 1.0f) * 127.0f);
+                break;
+            case HdFormatFloat16:
+                reinterpret_cast<GfHalf*>(dst)[c] = GfHalf(v);
+                break;
+            case HdFormatFloat32:
+                reinterpret_cast<float*>(dst)[c] = v;
+                break;
+            case HdFormatInt32:
+                reinterpret_cast<int32_t*>(dst)[c] = (int32_t)v;
+                break;
+            default:
+                TF_CODING_ERROR("Unsupported render buffer format %d", (int)m_Format);
+                return;
+        }
+    }
+}
+
+void ExRenderBuffer::WriteRow(unsigned int x, unsigned int y, unsigned int count, size_t numComponents, float const* values)
+{
+    size_t pixelSize = HdDataSizeOfFormat(m_Format);
+
+    uint8_t* dst = m_Data + (y * m_Width + x) * pixelSize;
+
+    // Fast path for float targets of the same layout (e.g. color and depth).
+    if (HdGetComponentFormat(m_Format) == HdFormatFloat32 && HdGetComponentCount(m_Format) == numComponents)
+    {
+        memcpy(dst, values, count * pixelSize);
+        return;
+    }
+
+    for (unsigned int i = 0u; i < count; ++i)
+        _WritePixel(dst + i * pixelSize, numComponents, values + i * numComponents);
+}
+
+void ExRenderBuffer::Clear(size_t numComponents, float const* value)
+{
+    if (m_Data == nullptr)
+        return;
+
+    size_t pixelSize = HdDataSizeOfFormat(m_Format);
+    size_t size      = m_Width * m_Height * pixelSize;
+
+    // Convert once, then replicate.
+    _WritePixel(m_Data, numComponents, value);
+
+    for (size_t offset = pixelSize; offset < size; offset += pixelSize)
+        memcpy(m_Data + offset, m_Data, pixelSize);
+}
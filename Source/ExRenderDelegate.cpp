@@ -1,11 +1,31 @@
 #include <ExampleDelegate/ExRenderDelegate.h>
+#include <ExampleDelegate/ExLog.h>
 #include <ExampleDelegate/ExRenderPass.h>
 #include <ExampleDelegate/ExMesh.h>
+#include <ExampleDelegate/ExInstancer.h>
+#include <ExampleDelegate/ExCamera.h>
+#include <ExampleDelegate/ExRenderTargetPool.h>
+#include <ExampleDelegate/ExFrameContext.h>
+#include <ExampleDelegate/ExTimeline.h>
+#include <ExampleDelegate/ExPipelineCache.h>
+#include <ExampleDelegate/ExResourceRegistry.h>
+#include <ExampleDelegate/ExRenderBuffer.h>
+#include <ExampleDelegate/ExRenderParam.h>
 
 #include <VulkanWrappers/Device.h>
 
-#include <iostream>
+#include <pxr/base/arch/fileSystem.h>
+#include <pxr/base/tf/diagnostic.h>
+#include <pxr/base/tf/stringUtils.h>
+#include <pxr/base/trace/collector.h>
+#include <pxr/base/trace/reporter.h>
+#include <pxr/base/trace/trace.h>
+
+#include <fstream>
 #include <memory>
+#include <mutex>
+
+TF_DEFINE_PUBLIC_TOKENS(ExRenderSettingsTokens, EX_RENDER_SETTINGS_TOKENS);
 
 const TfTokenVector ExRenderDelegate::SUPPORTED_RPRIM_TYPES =
 {
@@ -19,6 +39,7 @@ const TfTokenVector ExRenderDelegate::SUPPORTED_SPRIM_TYPES =
 
 const TfTokenVector ExRenderDelegate::SUPPORTED_BPRIM_TYPES =
 {
+    HdPrimTypeTokens->renderBuffer,
 };
 
 ExRenderDelegate::ExRenderDelegate() : HdRenderDelegate()
@@ -33,14 +54,46 @@ ExRenderDelegate::ExRenderDelegate(HdRenderSettingsMap const& settingsMap) : HdR
 
 void ExRenderDelegate::_Initialize()
 {
-    std::cout << "Creating Custom RenderDelegate" << std::endl;
-    _resourceRegistry = std::make_shared<HdResourceRegistry>();
+    EX_LOG(EX_DEBUG_DELEGATE, "Creating Custom RenderDelegate");
+
+    m_GraphicsDevice    = nullptr;
+    m_SoftwareRendering = false;
+
+    // Advertise the delegate settings to the application (and seed any that weren't provided).
+    m_SettingDescriptors.push_back({ "Readback Latency (Frames)", ExRenderSettingsTokens->readbackLatency,   VtValue(0)    });
+    m_SettingDescriptors.push_back({ "Parallel Recording",        ExRenderSettingsTokens->parallelRecording, VtValue(true) });
+    m_SettingDescriptors.push_back({ "Frustum Culling",           ExRenderSettingsTokens->frustumCulling,    VtValue(true) });
+    m_SettingDescriptors.push_back({ "Occlusion Culling",         ExRenderSettingsTokens->occlusionCulling,  VtValue(false) });
+    m_SettingDescriptors.push_back({ "Cluster Culling",           ExRenderSettingsTokens->clusterCulling,    VtValue(true) });
+    m_SettingDescriptors.push_back({ "Software Rendering",        ExRenderSettingsTokens->softwareRendering, VtValue(false) });
+    m_SettingDescriptors.push_back({ "Chrome Trace Output",       ExRenderSettingsTokens->traceOutputPath,   VtValue(std::string()) });
+    m_SettingDescriptors.push_back({ "Projection Jitter",         ExRenderSettingsTokens->projectionJitter,  VtValue(false) });
+    m_SettingDescriptors.push_back({ "Progressive Samples",       ExRenderSettingsTokens->progressiveSamples, VtValue(16) });
+    m_SettingDescriptors.push_back({ "Pipeline Cache Path",       ExRenderSettingsTokens->pipelineCachePath, VtValue(std::string()) });
+    m_SettingDescriptors.push_back({ "LOD Pixel Error",           ExRenderSettingsTokens->lodPixelError,     VtValue(1.0f) });
+    m_SettingDescriptors.push_back({ "Quantize Vertices",         ExRenderSettingsTokens->quantizeVertices,  VtValue(false) });
+
+    _PopulateDefaultSettings(m_SettingDescriptors);
+
+    m_RenderParam = std::make_unique<ExRenderParam>(&m_RenderStats);
 }
 
 ExRenderDelegate::~ExRenderDelegate()
 {
+    // Write out a trace that was still being collected.
+    _UpdateTracing(std::string());
+
+    m_FrameContext.reset();
+    m_PipelineCache.reset();
+    m_RenderTargetPool.reset();
     _resourceRegistry.reset();
-    std::cout << "Destroying Custom RenderDelegate" << std::endl;
+    m_Timeline.reset();
+    EX_LOG(EX_DEBUG_DELEGATE, "Destroying Custom RenderDelegate");
+
+#ifdef EX_ENABLE_LOGGING
+    // Don't leave the teardown of a delegate sitting in a buffer.
+    ExLog::GetInstance().Flush();
+#endif
 }
 
 // In case 
@@ -48,20 +101,79 @@ struct NoOpDeleter { void operator()(VulkanWrappers::Device* ptr) const {} };
 
 void ExRenderDelegate::SetDrivers(HdDriverVector const& drivers)
 {
+    m_SoftwareRendering = GetRenderSetting<bool>(ExRenderSettingsTokens->softwareRendering, false);
+
+    VkPhysicalDeviceFeatures2 const* enabledFeatures = nullptr;
+
     for (const auto& driver : drivers)
     {
-        if (driver->name == TfToken("CustomVulkanDevice") && driver->driver.IsHolding<VulkanWrappers::Device*>())
+        // Applications without Vulkan can ask for the CPU rasterizer explicitly.
+        if (driver->name == TfToken("CustomSoftwareRasterizer"))
         {
-            m_GraphicsDevice = driver->driver.UncheckedGet<VulkanWrappers::Device*>();
-            return;
+            m_SoftwareRendering = true;
+            break;
         }
+
+        if (driver->name == TfToken("CustomVulkanDevice") && driver->driver.IsHolding<VulkanWrappers::Device*>())
+            m_GraphicsDevice = driver->driver.UncheckedGet<VulkanWrappers::Device*>();
+
+        // The feature chain the device was created with. Vulkan can't be asked what a logical device enabled,
+        // so optional features are only used once the application says so.
+        if (driver->name == TfToken("CustomVulkanDeviceFeatures") && driver->driver.IsHolding<VkPhysicalDeviceFeatures2 const*>())
+            enabledFeatures = driver->driver.UncheckedGet<VkPhysicalDeviceFeatures2 const*>();
     }
 
-    // If no driver is passed, then create it here (no window). 
-    m_DefaultGraphicsDevice = std::make_unique<VulkanWrappers::Device>();
+    if (m_SoftwareRendering)
+    {
+        // Host-only registry: the draw table and bounds hierarchy are still maintained for culling.
+        m_GraphicsDevice  = nullptr;
+        _resourceRegistry = std::make_shared<ExResourceRegistry>(nullptr);
+        return;
+    }
 
-    // And set the main device resource to the default one.
-    m_GraphicsDevice = m_DefaultGraphicsDevice.get();
+    if (m_GraphicsDevice == nullptr)
+    {
+        // If no driver is passed, then create it here (no window). 
+        m_DefaultGraphicsDevice = std::make_unique<VulkanWrappers::Device>();
+
+        // And set the main device resource to the default one. It only has the core features enabled.
+        m_GraphicsDevice = m_DefaultGraphicsDevice.get();
+        enabledFeatures  = nullptr;
+    }
+
+    // Every submission is tracked on a timeline semaphore, there is no device path without one.
+    if (!ExTimeline::IsSupported(m_GraphicsDevice, enabledFeatures))
+    {
+        TF_RUNTIME_ERROR("The Vulkan device doesn't have the timelineSemaphore feature enabled, falling back to software rendering.");
+
+        m_DefaultGraphicsDevice.reset();
+
+        m_SoftwareRendering = true;
+        m_GraphicsDevice    = nullptr;
+        _resourceRegistry   = std::make_shared<ExResourceRegistry>(nullptr);
+        return;
+    }
+
+    // Without it enabled, every draw is its own indirect command.
+    bool multiDrawIndirect = enabledFeatures != nullptr && enabledFeatures->features.multiDrawIndirect == VK_TRUE;
+
+    m_Timeline         = std::make_unique<ExTimeline>(m_GraphicsDevice);
+    m_RenderTargetPool = std::make_unique<ExRenderTargetPool>(m_GraphicsDevice, m_Timeline.get());
+
+    // Start loading the cache as early as possible, the context's pipelines are the first to need it.
+    std::string pipelineCachePath = GetRenderSetting<std::string>(ExRenderSettingsTokens->pipelineCachePath, std::string());
+
+    if (pipelineCachePath.empty())
+        pipelineCachePath = TfStringCatPaths(ArchGetTmpDir(), "hdExamplePipelineCache.bin");
+
+    m_PipelineCache = std::make_unique<ExPipelineCache>(m_GraphicsDevice, pipelineCachePath);
+    m_FrameContext  = std::make_unique<ExFrameContext>(m_GraphicsDevice, m_RenderTargetPool.get(), m_Timeline.get(), m_PipelineCache.get(), multiDrawIndirect);
+
+    // Device resources are only available once we have a device. Meshes pick their vertex format up from the
+    // registry, so quantization can't change after this.
+    bool quantizeVertices = GetRenderSetting<bool>(ExRenderSettingsTokens->quantizeVertices, false);
+
+    _resourceRegistry = std::make_shared<ExResourceRegistry>(m_GraphicsDevice, m_Timeline.get(), quantizeVertices);
 }
 
 TfTokenVector const& ExRenderDelegate::GetSupportedRprimTypes() const
@@ -84,21 +196,84 @@ HdResourceRegistrySharedPtr ExRenderDelegate::GetResourceRegistry() const
     return _resourceRegistry;
 }
 
+// The trace collector is process-global: delegates tracing at the same time share it, and it is only turned off
+// (and its events cleared) once the last of them is done. Tracing someone else enabled is left alone.
+static std::mutex s_TracingMutex;
+static uint32_t   s_TracingDelegateCount    = 0u;
+static bool       s_TracingEnabledElsewhere = false;
+
+void ExRenderDelegate::_UpdateTracing(std::string const& tracePath)
+{
+    if (tracePath == m_TracePath)
+        return;
+
+    std::lock_guard<std::mutex> lock(s_TracingMutex);
+
+    if (!m_TracePath.empty())
+    {
+        bool lastDelegate = --s_TracingDelegateCount == 0u;
+
+        if (lastDelegate && !s_TracingEnabledElsewhere)
+            TraceCollector::GetInstance().SetEnabled(false);
+
+        std::ofstream file(m_TracePath);
+
+        if (file)
+            TraceReporter::GetGlobalReporter()->ReportChromeTracing(file);
+        else
+            TF_WARN("Failed to open trace output %s", m_TracePath.c_str());
+
+        // Other delegates' events are still being collected into the same tree.
+        if (lastDelegate && !s_TracingEnabledElsewhere)
+            TraceReporter::GetGlobalReporter()->ClearTree();
+    }
+
+    m_TracePath = tracePath;
+
+    if (!m_TracePath.empty())
+    {
+        if (s_TracingDelegateCount++ == 0u)
+        {
+            s_TracingEnabledElsewhere = TraceCollector::GetInstance().IsEnabled();
+
+            if (!s_TracingEnabledElsewhere)
+                TraceCollector::GetInstance().SetEnabled(true);
+        }
+    }
+}
+
 void ExRenderDelegate::CommitResources(HdChangeTracker *tracker)
 {
+    // Commit runs once per frame after sync, so it is where one frame interval ends and the next begins.
+    m_RenderStats.EndFrame();
+
+    _UpdateTracing(GetRenderSetting<std::string>(ExRenderSettingsTokens->traceOutputPath, std::string()));
+
+    TRACE_FUNCTION();
+    ExScopedTimer timer(&m_RenderStats, ExRenderPhase::Commit);
+
+    if (m_RenderTargetPool != nullptr)
+        m_RenderTargetPool->Tick();
+
+    if (_resourceRegistry != nullptr)
+    {
+        // Reclaim released geometry first so that this commit can reuse the memory.
+        _resourceRegistry->GarbageCollect();
+
+        // Flush everything queued by rprim sync in one transfer.
+        _resourceRegistry->Commit();
+    }
 }
 
 HdRenderPassSharedPtr ExRenderDelegate::CreateRenderPass(HdRenderIndex *index, HdRprimCollection const& collection)
 {
-    std::cout << "Create Custom RenderPass with Collection="  << collection.GetName() << std::endl; 
+    EX_LOG(EX_DEBUG_DELEGATE, "Create Custom RenderPass with Collection=%s", collection.GetName().GetText());
     return HdRenderPassSharedPtr(new ExRenderPass(index, collection, this));  
 }
 
 HdRprim* ExRenderDelegate::CreateRprim(TfToken const& typeId, SdfPath const& rprimId)
 {
-    std::cout << "Create Custom Rprim type=" << typeId.GetText() 
-        << " id=" << rprimId 
-        << std::endl;
+    EX_LOG(EX_DEBUG_PRIM_LIFECYCLE, "Create Custom Rprim type=%s id=%s", typeId.GetText(), rprimId.GetText());
 
     if (typeId == HdPrimTypeTokens->mesh) {
         return new ExMesh(rprimId);
@@ -112,56 +287,100 @@ HdRprim* ExRenderDelegate::CreateRprim(TfToken const& typeId, SdfPath const& rpr
 
 void ExRenderDelegate::DestroyRprim(HdRprim *rPrim)
 {
-    std::cout << "Destroy Custom Rprim id=" << rPrim->GetId() << std::endl;
+    EX_LOG(EX_DEBUG_PRIM_LIFECYCLE, "Destroy Custom Rprim id=%s", rPrim->GetId().GetText());
     delete rPrim;
 }
 
 HdSprim* ExRenderDelegate::CreateSprim(TfToken const& typeId, SdfPath const& sprimId)
 {
-    TF_CODING_ERROR("Unknown Sprim type=%s id=%s", typeId.GetText(), sprimId.GetText());
+    if (typeId == HdPrimTypeTokens->camera) {
+        EX_LOG(EX_DEBUG_PRIM_LIFECYCLE, "Create Camera Sprim id=%s", sprimId.GetText());
+        return new ExCamera(sprimId);
+    } else {
+        TF_CODING_ERROR("Unknown Sprim type=%s id=%s", typeId.GetText(), sprimId.GetText());
+    }
     return nullptr;
 }
 
 HdSprim* ExRenderDelegate::CreateFallbackSprim(TfToken const& typeId)
 {
-    TF_CODING_ERROR("Creating unknown fallback sprim type=%s", typeId.GetText()); 
+    if (typeId == HdPrimTypeTokens->camera) {
+        return new ExCamera(SdfPath::EmptyPath());
+    } else {
+        TF_CODING_ERROR("Creating unknown fallback sprim type=%s", typeId.GetText()); 
+    }
     return nullptr;
 }
 
 void ExRenderDelegate::DestroySprim(HdSprim *sPrim)
 {
-    TF_CODING_ERROR("Destroy Sprim not supported");
+    delete sPrim;
 }
 
 HdBprim* ExRenderDelegate::CreateBprim(TfToken const& typeId, SdfPath const& bprimId)
 {
-    TF_CODING_ERROR("Unknown Bprim type=%s id=%s", typeId.GetText(), bprimId.GetText());
+    if (typeId == HdPrimTypeTokens->renderBuffer) {
+        return new ExRenderBuffer(bprimId, m_GraphicsDevice, m_RenderTargetPool.get(), m_Timeline.get());
+    } else {
+        TF_CODING_ERROR("Unknown Bprim type=%s id=%s", typeId.GetText(), bprimId.GetText());
+    }
     return nullptr;
 }
 
 HdBprim* ExRenderDelegate::CreateFallbackBprim(TfToken const& typeId)
 {
-    TF_CODING_ERROR("Creating unknown fallback bprim type=%s", typeId.GetText()); 
+    if (typeId == HdPrimTypeTokens->renderBuffer) {
+        return new ExRenderBuffer(SdfPath::EmptyPath(), m_GraphicsDevice, m_RenderTargetPool.get(), m_Timeline.get());
+    } else {
+        TF_CODING_ERROR("Creating unknown fallback bprim type=%s", typeId.GetText()); 
+    }
     return nullptr;
 }
 
 void ExRenderDelegate::DestroyBprim(HdBprim *bPrim)
 {
-    TF_CODING_ERROR("Destroy Bprim not supported");
+    delete bPrim;
 }
 
 HdInstancer* ExRenderDelegate::CreateInstancer(HdSceneDelegate *delegate, SdfPath const& id)
 {
-    TF_CODING_ERROR("Creating Instancer not supported id=%s", id.GetText());
-    return nullptr;
+    EX_LOG(EX_DEBUG_PRIM_LIFECYCLE, "Create Custom Instancer id=%s", id.GetText());
+    return new ExInstancer(delegate, id);
 }
 
 void ExRenderDelegate::DestroyInstancer(HdInstancer *instancer)
 {
-    TF_CODING_ERROR("Destroy instancer not supported");
+    EX_LOG(EX_DEBUG_PRIM_LIFECYCLE, "Destroy Custom Instancer id=%s", instancer->GetId().GetText());
+    delete instancer;
 }
 
 HdRenderParam* ExRenderDelegate::GetRenderParam() const
 {
-    return nullptr;
+    return m_RenderParam.get();
+}
+
+HdAovDescriptor ExRenderDelegate::GetDefaultAovDescriptor(TfToken const& name) const
+{
+    // Formats match the device targets, which are copied into the AOVs without conversion.
+    if (name == HdAovTokens->color)
+        return HdAovDescriptor(HdFormatUNorm8Vec4, false, VtValue(GfVec4f(0.0f, 0.0f, 0.0f, 1.0f)));
+
+    if (name == HdAovTokens->depth)
+        return HdAovDescriptor(HdFormatFloat32, false, VtValue(1.0f));
+
+    // Prim ids are only written by the device path.
+    if (name == HdAovTokens->primId && !m_SoftwareRendering)
+        return HdAovDescriptor(HdFormatInt32, false, VtValue(-1));
+
+    return HdAovDescriptor();
+}
+
+HdRenderSettingDescriptorList ExRenderDelegate::GetRenderSettingDescriptors() const
+{
+    return m_SettingDescriptors;
+}
+
+VtDictionary ExRenderDelegate::GetRenderStats() const
+{
+    return m_RenderStats.GetDictionary();
 }
\ No newline at end of file
@@ -1,59 +1,767 @@
 #include <ExampleDelegate/ExRenderPass.h>
 #include <ExampleDelegate/ExRenderDelegate.h>
+#include <ExampleDelegate/ExRenderTargetPool.h>
+#include <ExampleDelegate/ExResourceRegistry.h>
+#include <ExampleDelegate/ExDrawTable.h>
+#include <ExampleDelegate/ExMesh.h>
+#include <ExampleDelegate/ExCuller.h>
+#include <ExampleDelegate/ExSoftwareRasterizer.h>
+#include <ExampleDelegate/ExRenderBuffer.h>
+#include <ExampleDelegate/ExRenderStats.h>
+#include <ExampleDelegate/ExFrameContext.h>
+#include <ExampleDelegate/ExTimeline.h>
+#include <ExampleDelegate/ExCamera.h>
 #include <ExampleDelegate/StbUsage.h>
 
 #include <VulkanWrappers/Device.h>
 #include <VulkanWrappers/Window.h>
 #include <VulkanWrappers/Image.h>
-#include <VulkanWrappers/Shader.h>
 #include <VulkanWrappers/Buffer.h>
 using namespace VulkanWrappers;
 
 #include <pxr/usd/ar/defaultResolver.h>
 #include <pxr/usd/ar/resolver.h>
 #include <pxr/usd/ar/resolvedPath.h>
-#include <pxr/base/plug/plugin.h>
-#include <pxr/base/plug/registry.h>
 #include <pxr/imaging/hd/camera.h>
+#include <pxr/imaging/hd/renderIndex.h>
+
+#include <pxr/base/tf/hash.h>
+#include <pxr/base/work/loops.h>
+#include <pxr/base/trace/trace.h>
+
+#include <tbb/enumerable_thread_specific.h>
 
 #include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <iostream>
+#include <numeric>
+
+using ReadbackFrame        = ExFrameContext::ReadbackFrame;
+using DrawFrame            = ExFrameContext::DrawFrame;
+using MeshPipeline         = ExFrameContext::MeshPipeline;
+using AccumulationPipeline = ExFrameContext::AccumulationPipeline;
+
+// Copy the rendered sub-rectangle of a (bucket-sized) target into tightly packed buffer memory.
+static void CopyImageRegionToBuffer(VkCommandBuffer cmd, Image* image, Buffer* buffer, VkExtent2D extent)
+{
+    VkBufferImageCopy copyRegion = {};
+    copyRegion.bufferOffset                    = 0u;
+    copyRegion.bufferRowLength                 = 0u;
+    copyRegion.bufferImageHeight               = 0u;
+    copyRegion.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    copyRegion.imageSubresource.layerCount     = 1u;
+    copyRegion.imageExtent                     = { extent.width, extent.height, 1u };
+
+    vkCmdCopyImageToBuffer(cmd, image->GetData()->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer->GetData()->buffer, 1u, &copyRegion);
+}
 
-// Resource IDs
+// Mesh Drawing
 // ---------------------
 
-enum ShaderID
+// Slots per parallel recording task. Small lists aren't worth the fork / join, and are recorded inline.
+static constexpr uint32_t kSlotsPerRecordingChunk = 1024u;
+
+// Point the frame's descriptor set at the current heap, record and transform buffers (only if any were reallocated).
+// Note: The frame slot is only reused once its previous submission has completed.
+static void UpdateDrawDescriptors(Device* device, DrawFrame* drawFrame, ExResourceRegistry* registry)
+{
+    ExGrowableBuffer* buffers[4] = 
+    {
+        registry->GetGeometryHeap()->GetBuffer(),
+        registry->GetDrawTable()->GetRecordBuffer(),
+        registry->GetDrawTable()->GetTransformBuffer(),
+        registry->GetGeometryHeap()->GetBuffer()
+    };
+
+    uint64_t* versions[4] = { &drawFrame->heapVersion, &drawFrame->recordVersion, &drawFrame->transformVersion, &drawFrame->instanceVersion };
+
+    VkDescriptorBufferInfo bufferInfos[4] = {};
+    VkWriteDescriptorSet   writes[4]      = {};
+    uint32_t               writeCount     = 0u;
+
+    for (uint32_t i = 0u; i < 4u; ++i)
+    {
+        if (*versions[i] == buffers[i]->GetVersion())
+            continue;
+
+        bufferInfos[writeCount].buffer = buffers[i]->Get()->GetData()->buffer;
+        bufferInfos[writeCount].offset = 0u;
+        bufferInfos[writeCount].range  = VK_WHOLE_SIZE;
+
+        writes[writeCount].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[writeCount].dstSet          = drawFrame->descriptorSet;
+        writes[writeCount].dstBinding      = i;
+        writes[writeCount].descriptorCount = 1u;
+        writes[writeCount].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[writeCount].pBufferInfo     = &bufferInfos[writeCount];
+
+        *versions[i] = buffers[i]->GetVersion();
+        writeCount++;
+    }
+
+    if (writeCount > 0u)
+        vkUpdateDescriptorSets(device->GetLogical(), writeCount, writes, 0u, nullptr);
+}
+
+// Ensure the frame's indirect buffer can hold a number of commands.
+static void ReserveIndirectCommands(Device* device, ExRenderTargetPool* pool, DrawFrame* drawFrame, uint32_t commandCount)
 {
-    MESH_VS,
-    UNLIT_PS,
+    VkDeviceSize requiredSize = std::max(1u, commandCount) * sizeof(VkDrawIndexedIndirectCommand);
+
+    if (drawFrame->indirectCapacity >= requiredSize)
+        return;
+
+    if (drawFrame->indirect != nullptr)
+        pool->Release(drawFrame->indirect);
+
+    drawFrame->indirect = pool->AcquireBuffer(requiredSize, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, 
+                                              VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+
+    VmaAllocationInfo allocInfo;
+    vmaGetAllocationInfo(device->GetAllocator(), drawFrame->indirect->GetData()->allocation, &allocInfo);
+
+    drawFrame->mapped           = allocInfo.pMappedData;
+    drawFrame->indirectCapacity = allocInfo.size;
+}
+
+// What the draws of a frame are written for: it picks the level of detail of each draw, and culls the clusters
+// of dense meshes. An object-space error e at distance d from the eye covers e * pixelsPerUnit / d pixels on
+// screen (e * pixelsPerUnit at any distance for an orthographic view).
+struct DrawView
+{
+    GfVec3f eye;
+    GfVec3f forward;
+    float   pixelsPerUnit;
+    bool    orthographic;
+
+    // Largest error a level may show, in pixels. Zero always draws full detail.
+    float maxPixelError;
+
+    ExFrustum frustum;
+    bool      clusterCulling;
+
+    // Cull style of the pass, for meshes without an opinion of their own.
+    HdCullStyle cullStyle;
 };
 
-enum ImageID
+static DrawView ComputeDrawView(HdRenderPassStateSharedPtr const& renderPassState, GfMatrix4f const& viewProjection, float viewportHeight, 
+                                float maxPixelError, bool clusterCulling)
 {
-    COLOR,
-    DEPTH
+    GfMatrix4d projection = renderPassState->GetProjectionMatrix();
+    GfMatrix4d viewToWorld = renderPassState->GetWorldToViewMatrix().GetInverse();
+
+    DrawView view;
+    view.eye            = GfVec3f(viewToWorld.ExtractTranslation());
+    view.forward        = GfVec3f(viewToWorld.TransformDir(GfVec3d(0.0, 0.0, -1.0)).GetNormalized());
+    view.orthographic   = projection[3][3] == 1.0;
+    view.maxPixelError  = maxPixelError;
+    view.frustum        = ExFrustum::FromViewProjection(viewProjection);
+    view.clusterCulling = clusterCulling;
+    view.cullStyle      = renderPassState->GetCullStyle();
+
+    // [1][1] scales view-space y into clip space, whose [-1, 1] spans the viewport's height.
+    view.pixelsPerUnit = (float)(0.5 * projection[1][1] * viewportHeight);
+
+    return view;
+}
+
+// Coarsest resident level of a slot whose error stays under the pixel threshold at the point of the slot's
+// bounds closest to the eye.
+static uint32_t SelectLod(ExDrawLods const& lods, GfRange3f const& bounds, GfMatrix4f const& transform, DrawView const& view)
+{
+    if (lods.count <= 1u || view.maxPixelError <= 0.0f || bounds.IsEmpty())
+        return 0u;
+
+    float distance = 1.0f;
+
+    if (!view.orthographic)
+    {
+        GfVec3f closest;
+        for (uint32_t axis = 0u; axis < 3u; ++axis)
+            closest[axis] = std::min(std::max(view.eye[axis], bounds.GetMin()[axis]), bounds.GetMax()[axis]);
+
+        distance = (closest - view.eye).GetLength();
+
+        // The eye is inside the bounds.
+        if (distance <= 0.0f)
+            return 0u;
+    }
+
+    // Errors are in object space, scale them by the largest axis of the mesh transform (instancer
+    // transforms aren't known per slot).
+    float scale = std::max({ GfVec3f(transform[0][0], transform[0][1], transform[0][2]).GetLength(),
+                             GfVec3f(transform[1][0], transform[1][1], transform[1][2]).GetLength(),
+                             GfVec3f(transform[2][0], transform[2][1], transform[2][2]).GetLength() });
+
+    float pixelsPerError = scale * view.pixelsPerUnit / distance;
+
+    for (uint32_t level = lods.count - 1u; level > 0u; --level)
+    {
+        if (lods.error[level] * pixelsPerError <= view.maxPixelError)
+            return level;
+    }
+
+    return 0u;
+}
+
+// Clusters per culling task, a dense mesh is tested wide rather than on the one thread writing its slot.
+static constexpr size_t kClustersPerCullTask = 1024u;
+
+// The view in the object space of one mesh. Spheres and normal cones stay exact under any affine transform
+// that way, and only the view is transformed rather than every cluster.
+struct ClusterView
+{
+    // Normalized, so that a plane's value at a point is the distance to it.
+    GfVec4f planes[6];
+
+    GfVec3f eye;
+    GfVec3f forward;
+    bool    orthographic;
+    bool    backfaceCulling;
 };
 
-enum BufferID
+// Whether a mesh's back faces may go unseen, as Storm resolves the mesh's cull style against the pass's. Only
+// then is a back-facing cluster culled, as the pipelines themselves draw both sides.
+static bool CullsBackfaces(ExMesh const* mesh, HdCullStyle passCullStyle)
+{
+    HdCullStyle cullStyle = mesh->GetSyncedCullStyle() == HdCullStyleDontCare ? passCullStyle : mesh->GetSyncedCullStyle();
+
+    return cullStyle == HdCullStyleBack || (cullStyle == HdCullStyleBackUnlessDoubleSided && !mesh->IsDoubleSided());
+}
+
+// Clusters of a slot that can be culled on their own, null if the slot is drawn whole. The instances of a slot
+// share its commands, so an instanced mesh is always drawn whole.
+static std::vector<ExMeshCluster> const* GetCullableClusters(ExDrawTable const* drawTable, uint32_t slot, DrawView const& view)
+{
+    if (!view.clusterCulling)
+        return nullptr;
+
+    ExMesh const* mesh = drawTable->GetMesh(slot);
+
+    if (mesh == nullptr || mesh->IsInstanced() || mesh->GetClusters().empty())
+        return nullptr;
+
+    return &mesh->GetClusters();
+}
+
+// Move the view into a mesh's object space.
+//   \return False if the transform can't be inverted.
+static bool ComputeClusterView(DrawView const& view, ExMesh const* mesh, GfMatrix4f const& transform, ClusterView* clusterView)
 {
-    COLOR_MAP_STAGING,
+    double     determinant = 0.0;
+    GfMatrix4f inverse     = transform.GetInverse(&determinant);
+
+    if (std::abs(determinant) <= 1e-12)
+        return false;
+
+    for (uint32_t i = 0u; i < 6u; ++i)
+    {
+        // Row vectors: a point p * M is inside a world plane P where p . (M * P) >= 0.
+        GfVec4f plane  = transform * view.frustum.planes[i];
+        float   length = GfVec3f(plane[0], plane[1], plane[2]).GetLength();
+
+        clusterView->planes[i] = length > 0.0f ? plane / length : plane;
+    }
+
+    clusterView->eye             = inverse.Transform(view.eye);
+    clusterView->forward         = inverse.TransformDir(view.forward).GetNormalized();
+    clusterView->orthographic    = view.orthographic;
+    clusterView->backfaceCulling = CullsBackfaces(mesh, view.cullStyle);
+
+    return true;
+}
+
+static bool IsClusterVisible(ExMeshCluster const& cluster, ClusterView const& view)
+{
+    for (GfVec4f const& plane : view.planes)
+    {
+        if (plane[0] * cluster.center[0] + plane[1] * cluster.center[1] + plane[2] * cluster.center[2] + plane[3] < -cluster.radius)
+            return false;
+    }
+
+    if (!view.backfaceCulling || cluster.coneCutoff == kNoNormalCone)
+        return true;
+
+    GfVec3f axis   = GfVec3f(cluster.coneAxis[0], cluster.coneAxis[1], cluster.coneAxis[2]).GetNormalized();
+    float   cutoff = (float)cluster.coneCutoff / 127.0f;
+
+    // An orthographic view looks at every triangle from the same direction.
+    if (view.orthographic)
+        return GfDot(view.forward, axis) < cutoff;
+
+    GfVec3f toCluster = cluster.center - view.eye;
+
+    return GfDot(toCluster, axis) < cutoff * toCluster.GetLength() + cluster.radius;
+}
+
+// Per-thread cluster visibility, reused across slots and frames so the hot loop doesn't allocate.
+static tbb::enumerable_thread_specific<std::vector<uint8_t>> s_ClusterVisibility;
+
+// Write the commands of a slot's visible clusters. Consecutive clusters are consecutive in the index buffer, so
+// each run of visible clusters is a single command.
+//   \return The number of commands written, at most one per cluster.
+static uint32_t WriteClusterCommands(VkDrawIndexedIndirectCommand* commands, ExDrawRecord const& record, std::vector<ExMeshCluster> const& clusters, 
+                                     ClusterView const& view)
+{
+    // Taken out for the duration: while waiting on the cluster tests below this thread may pick up another
+    // slot's tests, which would otherwise find its own scratch in use.
+    std::vector<uint8_t> visible = std::move(s_ClusterVisibility.local());
+    visible.resize(clusters.size());
+
+    auto TestClusters = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            visible[i] = IsClusterVisible(clusters[i], view);
+    };
+
+    if (clusters.size() > kClustersPerCullTask)
+    {
+        WorkParallelForN((clusters.size() + kClustersPerCullTask - 1u) / kClustersPerCullTask, [&](size_t begin, size_t end)
+        {
+            TestClusters(begin * kClustersPerCullTask, std::min(end * kClustersPerCullTask, clusters.size()));
+        });
+    }
+    else
+        TestClusters(0u, clusters.size());
+
+    // Runs are built on the side, the mapped memory is write-combined and never read back.
+    VkDrawIndexedIndirectCommand run = {};
+    run.instanceCount = record.instanceCount;
+    run.firstInstance = record.firstInstance;
+
+    uint32_t drawCount = 0u;
+
+    for (size_t i = 0u; i <= clusters.size(); ++i)
+    {
+        if (i < clusters.size() && visible[i])
+        {
+            if (run.indexCount == 0u)
+                run.firstIndex = record.firstIndex + clusters[i].firstIndex;
+
+            run.indexCount += clusters[i].indexCount;
+            continue;
+        }
+
+        if (run.indexCount > 0u)
+        {
+            commands[drawCount++] = run;
+            run.indexCount = 0u;
+        }
+    }
+
+    s_ClusterVisibility.local() = std::move(visible);
+
+    return drawCount;
+}
+
+// Place the commands of each visible slot in the indirect buffer: one per slot, or up to one per cluster for a
+// slot whose clusters are culled.
+//   \param offsets Receives the first command of each slot, and the total command count last.
+static void ComputeCommandOffsets(ExDrawTable const* drawTable, DrawView const& view, std::vector<uint32_t> const& slots, std::vector<uint32_t>* offsets)
+{
+    offsets->resize(slots.size() + 1u);
+
+    uint32_t commandCount = 0u;
+
+    for (size_t i = 0u; i < slots.size(); ++i)
+    {
+        (*offsets)[i] = commandCount;
+
+        std::vector<ExMeshCluster> const* clusters = GetCullableClusters(drawTable, slots[i], view);
+
+        commandCount += clusters != nullptr ? (uint32_t)clusters->size() : 1u;
+    }
+
+    offsets->back() = commandCount;
+}
+
+// Write the indexed indirect commands of the resident slots in slots[first, last), packed from the slots' first
+// command, each drawing the level of detail the view calls for (and only its visible clusters, where it has
+// them). Ranges never overlap, so disjoint ranges can be written concurrently.
+//   \return The number of commands written.
+static uint32_t WriteIndirectCommands(DrawFrame* drawFrame, ExDrawTable* drawTable, DrawView const& view, std::vector<uint32_t> const& slots, 
+                                      std::vector<uint32_t> const& commandOffsets, uint32_t first, uint32_t last)
+{
+    auto* commands = reinterpret_cast<VkDrawIndexedIndirectCommand*>(drawFrame->mapped) + commandOffsets[first];
+
+    uint32_t drawCount = 0u;
+
+    for (uint32_t i = first; i < last; ++i)
+    {
+        uint32_t            slot   = slots[i];
+        ExDrawRecord const& record = drawTable->GetRecord(slot);
+
+        if (record.indexCount == 0u || record.instanceCount == 0u)
+            continue;
+
+        ExDrawLods const& lods  = drawTable->GetLods(slot);
+        uint32_t          level = SelectLod(lods, drawTable->GetBounds(slot), drawTable->GetTransform(slot), view);
+
+        // Only the full-detail level is clustered, coarser levels are cheap enough to draw whole.
+        std::vector<ExMeshCluster> const* clusters = level == 0u ? GetCullableClusters(drawTable, slot, view) : nullptr;
+
+        if (clusters != nullptr && clusters->back().firstIndex + clusters->back().indexCount == record.indexCount)
+        {
+            ClusterView clusterView;
+
+            if (ComputeClusterView(view, drawTable->GetMesh(slot), drawTable->GetTransform(slot), &clusterView))
+            {
+                drawCount += WriteClusterCommands(commands + drawCount, record, *clusters, clusterView);
+                continue;
+            }
+        }
+
+        // Every instance of the slot in one draw. The instance index addresses the instance in the heap,
+        // which in turn holds the slot, which is how the shader finds the draw record.
+        VkDrawIndexedIndirectCommand& command = commands[drawCount++];
+        command.indexCount    = level > 0u ? lods.indexCount[level] : record.indexCount;
+        command.instanceCount = record.instanceCount;
+        command.firstIndex    = level > 0u ? lods.firstIndex[level] : record.firstIndex;
+        command.vertexOffset  = 0;
+        command.firstInstance = record.firstInstance;
+    }
+
+    return drawCount;
+}
+
+// Everything a command buffer needs to draw a range of the frame's indirect commands. Secondary
+// command buffers inherit none of this, so each one binds it again.
+struct DrawState
+{
+    VkDescriptorSet descriptorSet;
+    GfMatrix4f      viewProjection;
+    VkViewport      viewport;
+    VkRect2D        scissor;
+    VkBuffer        indexBuffer;
+    VkBuffer        indirectBuffer;
+};
+
+// A run of slots[firstSlot, lastSlot) drawn with one shader variant, whose commands are packed from firstCommand.
+struct DrawBatch
+{
+    uint32_t features     = 0u;
+    uint32_t firstSlot    = 0u;
+    uint32_t lastSlot     = 0u;
+    uint32_t firstCommand = 0u;
+    uint32_t drawCount    = 0u;
+};
+
+// Slots sorted by variant come in at most one batch per variant.
+struct DrawBatches
+{
+    DrawBatch batches[kMeshVariantCount];
+    uint32_t  count = 0u;
+};
+
+// Group the slots by shader variant, so that each variant's pipeline is bound once per command buffer rather
+// than whenever consecutive draws differ. Counting sort (there are only a handful of variants), and stable,
+// so the culler's order is kept within a variant.
+static void SortByVariant(ExDrawTable const* drawTable, std::vector<uint32_t>* slots, std::vector<uint32_t>* scratch, DrawBatches* batches)
+{
+    uint32_t offsets[kMeshVariantCount] = {};
+
+    for (uint32_t slot : *slots)
+        offsets[drawTable->GetFeatures(slot)]++;
+
+    batches->count = 0u;
+
+    for (uint32_t features = 0u, first = 0u; features < kMeshVariantCount; ++features)
+    {
+        uint32_t count = offsets[features];
+
+        if (count > 0u)
+        {
+            DrawBatch& batch = batches->batches[batches->count++];
+            batch.features  = features;
+            batch.firstSlot = first;
+            batch.lastSlot  = first + count;
+        }
+
+        offsets[features] = first;
+        first += count;
+    }
+
+    scratch->resize(slots->size());
+
+    for (uint32_t slot : *slots)
+        (*scratch)[offsets[drawTable->GetFeatures(slot)]++] = slot;
+
+    slots->swap(*scratch);
+}
+
+static void RecordDraws(VkCommandBuffer cmd, MeshPipeline const& pipeline, DrawState const& state, DrawBatch const* batches, uint32_t batchCount)
+{
+    // Every variant shares the layout, so these stay bound across pipeline switches.
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipelineLayout, 0u, 1u, &state.descriptorSet, 0u, nullptr);
+    vkCmdPushConstants(cmd, pipeline.pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0u, sizeof(GfMatrix4f), state.viewProjection.GetArray());
+
+    Device::vkCmdSetViewportWithCountEXT(cmd, 1u, &state.viewport);
+    Device::vkCmdSetScissorWithCountEXT(cmd, 1u, &state.scissor);
+
+    // Every mesh indexes into the one heap, so the index buffer is bound once for all draws.
+    vkCmdBindIndexBuffer(cmd, state.indexBuffer, 0u, VK_INDEX_TYPE_UINT32);
+
+    const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+    for (uint32_t i = 0u; i < batchCount; ++i)
+    {
+        DrawBatch const& batch = batches[i];
+
+        if (batch.drawCount == 0u)
+            continue;
+
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.variants[batch.features]);
+
+        // Without multi-draw support this degrades to one indirect call per draw (still no per-draw CPU state).
+        for (uint32_t first = 0u; first < batch.drawCount; first += pipeline.maxDrawIndirectCount)
+        {
+            uint32_t count = std::min(batch.drawCount - first, pipeline.maxDrawIndirectCount);
+            vkCmdDrawIndexedIndirect(cmd, state.indirectBuffer, (VkDeviceSize)(batch.firstCommand + first) * stride, count, stride);
+        }
+    }
+}
+
+// Parallel Recording
+// ---------------------
+
+// Split the slot list into chunks and, for each on a worker thread, write its indirect commands and record them
+// into a secondary command buffer that continues the primary's dynamic rendering scope.
+//   \param commandOffsets First command of each slot, see ComputeCommandOffsets().
+//   \param batches        Variant batches of the (sorted) slots, a chunk records its share of each.
+//   \param secondaries    Receives the recorded command buffers in submission (slot) order, empty chunks are skipped.
+static void RecordDrawsParallel(ExFrameContext* context, DrawFrame* drawFrame, ExDrawTable* drawTable, DrawView const& view, std::vector<uint32_t> const& slots, 
+                                std::vector<uint32_t> const& commandOffsets, DrawBatches const& batches, DrawState const& state, 
+                                std::vector<VkCommandBuffer>* secondaries)
+{
+    const uint32_t slotCount  = (uint32_t)slots.size();
+    const uint32_t chunkCount = (slotCount + kSlotsPerRecordingChunk - 1u) / kSlotsPerRecordingChunk;
+
+    std::vector<VkCommandBuffer> chunkBuffers(chunkCount, VK_NULL_HANDLE);
+
+    MeshPipeline const& pipeline = context->GetMeshPipeline();
+
+    VkFormat colorFormats[2] = { pipeline.colorFormat, ExFrameContext::kPrimIdFormat };
+
+    VkCommandBufferInheritanceRenderingInfoKHR inheritanceRendering = {};
+    inheritanceRendering.sType                   = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR;
+    inheritanceRendering.colorAttachmentCount    = 2u;
+    inheritanceRendering.pColorAttachmentFormats = colorFormats;
+    inheritanceRendering.depthAttachmentFormat   = ExFrameContext::kDepthFormat;
+    inheritanceRendering.rasterizationSamples    = VK_SAMPLE_COUNT_1_BIT;
+
+    VkCommandBufferInheritanceInfo inheritance = {};
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.pNext = &inheritanceRendering;
+
+    WorkParallelForN(chunkCount, [&](size_t begin, size_t end)
+    {
+        for (size_t chunk = begin; chunk < end; ++chunk)
+        {
+            uint32_t firstSlot = (uint32_t)chunk * kSlotsPerRecordingChunk;
+            uint32_t lastSlot  = std::min(firstSlot + kSlotsPerRecordingChunk, slotCount);
+
+            DrawBatches chunkBatches;
+            uint32_t    drawCount = 0u;
+
+            for (uint32_t i = 0u; i < batches.count; ++i)
+            {
+                DrawBatch const& batch = batches.batches[i];
+
+                if (batch.lastSlot <= firstSlot || batch.firstSlot >= lastSlot)
+                    continue;
+
+                DrawBatch& chunkBatch = chunkBatches.batches[chunkBatches.count++];
+                chunkBatch.features  = batch.features;
+                chunkBatch.firstSlot = std::max(batch.firstSlot, firstSlot);
+                chunkBatch.lastSlot  = std::min(batch.lastSlot,  lastSlot);
+
+                chunkBatch.firstCommand = commandOffsets[chunkBatch.firstSlot];
+                chunkBatch.drawCount    = WriteIndirectCommands(drawFrame, drawTable, view, slots, commandOffsets, chunkBatch.firstSlot, chunkBatch.lastSlot);
+
+                drawCount += chunkBatch.drawCount;
+            }
+
+            if (drawCount == 0u)
+                continue;
+
+            VkCommandBuffer secondary = context->AcquireSecondaryCommandBuffer(drawFrame);
+
+            VkCommandBufferBeginInfo beginInfo = {};
+            beginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags            = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            beginInfo.pInheritanceInfo = &inheritance;
+
+            vkBeginCommandBuffer(secondary, &beginInfo);
+            RecordDraws(secondary, pipeline, state, chunkBatches.batches, chunkBatches.count);
+            vkEndCommandBuffer(secondary);
+
+            chunkBuffers[chunk] = secondary;
+        }
+    });
+
+    secondaries->clear();
+
+    for (auto secondary : chunkBuffers)
+    {
+        if (secondary != VK_NULL_HANDLE)
+            secondaries->push_back(secondary);
+    }
+}
+
+// Accumulation
+// ---------------------
+
+// Per-pass accumulation resources. The color target may be reallocated while earlier frames are still
+// in flight, so a new set points at the new target and the old one is retired with the frames using it.
+struct ExRenderPass::Accumulation
+{
+    Image*     target = nullptr;
+    VkExtent2D extent = { 0u, 0u };
+
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet  descriptorSet  = VK_NULL_HANDLE;
+    Image*           boundColor     = nullptr;
 };
 
-// Resources
+// Layout transition of a single-level color image.
+static void TransitionColorImage(VkCommandBuffer cmd, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout,
+                                 VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask               = srcAccess;
+    barrier.dstAccessMask               = dstAccess;
+    barrier.oldLayout                   = oldLayout;
+    barrier.newLayout                   = newLayout;
+    barrier.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image                       = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1u;
+    barrier.subresourceRange.layerCount = 1u;
+
+    vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0x0, 0u, nullptr, 0u, nullptr, 1u, &barrier);
+}
+
+// AOV Resolve
 // ---------------------
 
-static VkCommandBuffer s_InternalCmd;
-static VkViewport      s_PreviousViewport;
+// Render buffers bound to the pass for each AOV we produce (null if unbound), with their clear values.
+struct AovTargets
+{
+    ExRenderBuffer* color  = nullptr;
+    ExRenderBuffer* depth  = nullptr;
+    ExRenderBuffer* primId = nullptr;
+
+    GfVec4f clearColor  = GfVec4f(0.0f, 0.0f, 0.0f, 1.0f);
+    float   clearDepth  = 1.0f;
+    int32_t clearPrimId = -1;
+};
+
+static AovTargets GatherAovTargets(HdRenderIndex* renderIndex, HdRenderPassStateSharedPtr const& renderPassState)
+{
+    AovTargets targets;
+
+    for (auto const& binding : renderPassState->GetAovBindings())
+    {
+        // Bindings made by path (i.e. from the task controller) are resolved through the render index.
+        HdRenderBuffer* renderBuffer = binding.renderBuffer;
+
+        if (renderBuffer == nullptr)
+            renderBuffer = static_cast<HdRenderBuffer*>(renderIndex->GetBprim(HdPrimTypeTokens->renderBuffer, binding.renderBufferId));
+
+        if (renderBuffer == nullptr)
+            continue;
 
-static std::unordered_map<ShaderID, Shader> s_Shaders;
-static std::unordered_map<ImageID,  Image>  s_Images;
-static std::unordered_map<BufferID, Buffer> s_Buffers;
+        if (binding.aovName == HdAovTokens->color)
+        {
+            targets.color = static_cast<ExRenderBuffer*>(renderBuffer);
+
+            if (binding.clearValue.IsHolding<GfVec4f>())
+                targets.clearColor = binding.clearValue.UncheckedGet<GfVec4f>();
+        }
+        else if (binding.aovName == HdAovTokens->depth)
+        {
+            targets.depth = static_cast<ExRenderBuffer*>(renderBuffer);
+
+            if (binding.clearValue.IsHolding<float>())
+                targets.clearDepth = binding.clearValue.UncheckedGet<float>();
+        }
+        else if (binding.aovName == HdAovTokens->primId)
+        {
+            targets.primId = static_cast<ExRenderBuffer*>(renderBuffer);
+
+            if (binding.clearValue.IsHolding<int>())
+                targets.clearPrimId = binding.clearValue.UncheckedGet<int>();
+        }
+    }
+
+    return targets;
+}
+
+// Targets are copied into AOV memory as-is, so the buffer has to be device-backed with a matching texel layout.
+static bool IsAovResolvable(ExRenderBuffer* renderBuffer, HdFormat format)
+{
+    if (renderBuffer == nullptr || renderBuffer->GetDeviceBuffer() == nullptr)
+        return false;
+
+    if (renderBuffer->GetFormat() != format)
+    {
+        TF_WARN("AOV %s has format %d, expected %d. It will not be resolved.", 
+            renderBuffer->GetId().GetText(), (int)renderBuffer->GetFormat(), (int)format);
+        return false;
+    }
+
+    return true;
+}
+
+// Copy the rendered sub-rectangle of a (bucket-sized) target into an AOV's rows.
+static void CopyImageToRenderBuffer(VkCommandBuffer cmd, Image* image, VkImageAspectFlags aspect, ExRenderBuffer* renderBuffer, VkExtent2D extent)
+{
+    VkBufferImageCopy copyRegion = {};
+    copyRegion.bufferOffset                    = 0u;
+    copyRegion.bufferRowLength                 = renderBuffer->GetWidth();
+    copyRegion.bufferImageHeight               = 0u;
+    copyRegion.imageSubresource.aspectMask     = aspect;
+    copyRegion.imageSubresource.layerCount     = 1u;
+    copyRegion.imageExtent                     = { std::min(extent.width, renderBuffer->GetWidth()), std::min(extent.height, renderBuffer->GetHeight()), 1u };
+
+    vkCmdCopyImageToBuffer(cmd, image->GetData()->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, renderBuffer->GetDeviceBuffer()->GetData()->buffer, 1u, &copyRegion);
+}
 
-static unsigned int s_GLBackbufferImage;
-static unsigned int s_GLBackbufferObject;
+// Copy the (transfer source) color target into a frame-provided backbuffer and prepare it for present.
+static void CopyToBackBuffer(VkCommandBuffer cmd, Image* colorTarget, VkImage backBuffer, VkExtent2D extent)
+{
+    Image::TransferUnknownToDestination(cmd, backBuffer);
+
+    VkImageCopy copyRegion = {};
+    copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    copyRegion.srcSubresource.layerCount = 1;
+    copyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    copyRegion.dstSubresource.layerCount = 1;
+    copyRegion.extent.width              = extent.width;
+    copyRegion.extent.height             = extent.height;
+    copyRegion.extent.depth              = 1;
+
+    vkCmdCopyImage(cmd, 
+                   colorTarget->GetData()->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 
+                   backBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 
+                   1u, &copyRegion);
+
+    // After copying we prepare the backbuffer for swapchain present.
+    Image::TransferDestinationToPresent(cmd, backBuffer);
+}
 
-void CreateViewportSizedResources(Device* device, VkViewport viewport)
+void ExRenderPass::_UpdateRenderTargets(VkExtent2D extent)
 {
+    if (m_ColorTarget != nullptr && m_TargetExtent.width == extent.width && m_TargetExtent.height == extent.height)
+        return;
+
+    Device*             device = m_Owner->GetGraphicsDevice();
+    ExRenderTargetPool* pool   = m_Owner->GetRenderTargetPool();
+
     VkFormat colorFormat;
     {
         if (device->GetWindow() != nullptr)
@@ -62,61 +770,323 @@ void CreateViewportSizedResources(Device* device, VkViewport viewport)
             colorFormat = VK_FORMAT_R8G8B8A8_SRGB;
     }
 
-    s_Images[ImageID::COLOR] = Image(viewport.width, viewport.height, 
-                                    colorFormat, 
-                                    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, 
-                                    VK_IMAGE_ASPECT_COLOR_BIT);
+    // Hand back the previous target first: if the new extent is in the same bucket we get it straight back.
+    // Frames in flight may still reference it, the pool defers freeing the memory until it has been idle for a while.
+    if (m_ColorTarget != nullptr)
+        pool->Release(m_ColorTarget);
+
+    // Also sampled and overwritten by accumulation.
+    m_ColorTarget = pool->AcquireImage(extent, colorFormat, 
+                                       VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, 
+                                       VK_IMAGE_ASPECT_COLOR_BIT);
+
+    if (m_DepthTarget != nullptr)
+        pool->Release(m_DepthTarget);
+
+    m_DepthTarget = pool->AcquireImage(extent, ExFrameContext::kDepthFormat, 
+                                       VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, 
+                                       VK_IMAGE_ASPECT_DEPTH_BIT);
 
-    s_Buffers[BufferID::COLOR_MAP_STAGING] = Buffer(4 * viewport.width * viewport.height, 
-                                    VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT, 
-                                    VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
+    if (m_PrimIdTarget != nullptr)
+        pool->Release(m_PrimIdTarget);
 
-    for (auto& image : s_Images)
-        device->CreateImages( { &image.second } );
+    m_PrimIdTarget = pool->AcquireImage(extent, ExFrameContext::kPrimIdFormat, 
+                                        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, 
+                                        VK_IMAGE_ASPECT_COLOR_BIT);
 
-    for (auto& buffer : s_Buffers)
-        device->CreateBuffers( { &buffer.second } );
+    m_TargetExtent = extent;
 }
 
-ExRenderPass::ExRenderPass(HdRenderIndex *index, HdRprimCollection const &collection, ExRenderDelegate* renderDelegate) 
-    : HdRenderPass(index, collection), m_Owner(renderDelegate)
+bool ExRenderPass::_UpdateViewKey(HdRenderPassStateSharedPtr const& renderPassState, VkExtent2D extent)
+{
+    auto camera = dynamic_cast<ExCamera const*>(renderPassState->GetCamera());
+
+    ViewKey key;
+    key.camera        = renderPassState->GetCamera();
+    key.cameraVersion = camera != nullptr ? camera->GetVersion() : 0u;
+    key.worldToView   = renderPassState->GetWorldToViewMatrix();
+    key.projection    = renderPassState->GetProjectionMatrix();
+    key.framing       = renderPassState->GetFraming();
+    key.viewport      = renderPassState->GetViewport();
+    key.extent        = extent;
+    key.jitter        = m_Owner->GetRenderSetting<bool>(ExRenderSettingsTokens->projectionJitter, false);
+
+    bool viewChanged = key.camera        != m_ViewKey.camera        ||
+                       key.cameraVersion != m_ViewKey.cameraVersion ||
+                       key.worldToView   != m_ViewKey.worldToView   ||
+                       key.projection    != m_ViewKey.projection    ||
+                       key.framing       != m_ViewKey.framing       ||
+                       key.viewport      != m_ViewKey.viewport      ||
+                       key.extent.width  != m_ViewKey.extent.width  ||
+                       key.extent.height != m_ViewKey.extent.height ||
+                       key.jitter        != m_ViewKey.jitter;
+
+    if (viewChanged)
+    {
+        m_ViewKey     = key;
+        m_ViewDirty   = true;
+        m_JitterIndex = 0u;
+    }
+
+    return viewChanged;
+}
+
+GfMatrix4f const& ExRenderPass::_UpdateViewProjection(HdRenderPassStateSharedPtr const& renderPassState, VkExtent2D extent)
 {
-    auto device = m_Owner->GetGraphicsDevice();
+    // Hydra matrices are row-vector with GL clip depth, remap z from [-1, 1] to [0, 1] for Vulkan.
+    static const GfMatrix4d kDepthRemap(1.0, 0.0, 0.0, 0.0,
+                                        0.0, 1.0, 0.0, 0.0,
+                                        0.0, 0.0, 0.5, 0.0,
+                                        0.0, 0.0, 0.5, 1.0);
+
+    _UpdateViewKey(renderPassState, extent);
+
+    if (!m_ViewDirty && !m_ViewKey.jitter)
+        return m_ViewProjection;
+
+    GfMatrix4d projection = renderPassState->GetProjectionMatrix();
+
+    if (m_ViewKey.jitter)
+        projection = ExApplyJitter(projection, ExComputeJitter(m_JitterIndex++), extent.width, extent.height);
+
+    m_ViewProjection = GfMatrix4f(renderPassState->GetWorldToViewMatrix() * projection * kDepthRemap);
+    m_ViewDirty      = false;
+
+    return m_ViewProjection;
+}
+
+size_t ExRenderPass::_ComputeSettingsHash() const
+{
+    return TfHash::Combine(m_Owner->GetRenderSetting<int>  (ExRenderSettingsTokens->progressiveSamples, 16),
+                           m_Owner->GetRenderSetting<bool> (ExRenderSettingsTokens->frustumCulling, true),
+                           m_Owner->GetRenderSetting<bool> (ExRenderSettingsTokens->occlusionCulling, false),
+                           m_Owner->GetRenderSetting<float>(ExRenderSettingsTokens->lodPixelError, 1.0f),
+                           m_Owner->GetRenderSetting<bool> (ExRenderSettingsTokens->clusterCulling, true));
+}
+
+bool ExRenderPass::_UpdateProgress(HdRenderPassStateSharedPtr const& renderPassState, VkExtent2D extent)
+{
+    HdChangeTracker& changeTracker = GetRenderIndex()->GetChangeTracker();
+
+    unsigned int sceneStateVersion = changeTracker.GetSceneStateVersion();
+    unsigned int collectionVersion = changeTracker.GetCollectionVersion(GetRprimCollection().GetName());
+    unsigned int renderTagVersion  = changeTracker.GetRenderTagVersion();
+    size_t       settingsHash      = _ComputeSettingsHash();
+
+    bool changed = _UpdateViewKey(renderPassState, extent)           ||
+                   sceneStateVersion != m_SceneStateVersion          ||
+                   collectionVersion != m_CollectionVersion          ||
+                   renderTagVersion  != m_RenderTagVersion           ||
+                   settingsHash      != m_SettingsHash               ||
+                   renderPassState->GetAovBindings() != m_AovBindings;
+
+    // Only jittered samples average into a better image, otherwise one sample is final.
+    int progressiveSamples = m_Owner->GetRenderSetting<int>(ExRenderSettingsTokens->progressiveSamples, 16);
 
-    // Fetch the base plugin in order to construct asset paths.
-    auto pluginBase = PlugRegistry::GetInstance().GetPluginWithName("hdExample");
-    TF_VERIFY(pluginBase != nullptr);
+    m_TargetSampleCount = m_ViewKey.jitter ? (uint32_t)std::max(progressiveSamples, 1) : 1u;
 
-    /*
-    s_Shaders = 
+    if (changed)
     {
-        { ShaderID::MESH_VS,  Shader(pluginBase->FindPluginResource("shaders/TriangleVert.spv").c_str(), VK_SHADER_STAGE_VERTEX_BIT)   },
-        { ShaderID::UNLIT_PS, Shader(pluginBase->FindPluginResource("shaders/TriangleFrag.spv").c_str(), VK_SHADER_STAGE_FRAGMENT_BIT) }
-    };
+        m_SceneStateVersion = sceneStateVersion;
+        m_CollectionVersion = collectionVersion;
+        m_RenderTagVersion  = renderTagVersion;
+        m_SettingsHash      = settingsHash;
+        m_AovBindings       = renderPassState->GetAovBindings();
+        m_SampleCount       = 0u;
+    }
 
-    for (auto& shader : s_Shaders)
-        device->CreateShaders ({ &shader.second });
+    return m_SampleCount < m_TargetSampleCount;
+}
 
-    // The internal command should be secondary since there already exist a primary one to be used for application-managed queue submission.
-    if (m_Owner->RequiresManualQueueSubmit())
-        device->CreateCommandBuffer(&s_InternalCmd);
-    */
+void ExRenderPass::_RecordAccumulation(VkCommandBuffer cmd, VkRect2D const& scissor, VkViewport const& viewport)
+{
+    Device*             device  = m_Owner->GetGraphicsDevice();
+    ExRenderTargetPool* pool    = m_Owner->GetRenderTargetPool();
+    ExFrameContext*     context = m_Owner->GetFrameContext();
+
+    AccumulationPipeline const& pipeline = context->GetAccumulationPipeline();
+
+    if (m_Accumulation == nullptr)
+        m_Accumulation = std::make_unique<Accumulation>();
+
+    Accumulation& accumulation = *m_Accumulation;
+
+    // A new size always restarts accumulation (see _UpdateViewKey), so the previous average can be dropped.
+    if (accumulation.target == nullptr || accumulation.extent.width != m_TargetExtent.width || accumulation.extent.height != m_TargetExtent.height)
+    {
+        if (accumulation.target != nullptr)
+            pool->Release(accumulation.target);
+
+        accumulation.target = pool->AcquireImage(m_TargetExtent, ExFrameContext::kAccumulationFormat, 
+                                                 VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, 
+                                                 VK_IMAGE_ASPECT_COLOR_BIT);
+        accumulation.extent = m_TargetExtent;
+    }
+
+    // A set in use by a frame in flight can't be rewritten, so a new color target gets a new set.
+    if (accumulation.boundColor != m_ColorTarget)
+    {
+        context->RetireDescriptorPool(accumulation.descriptorPool);
+
+        VkDescriptorPoolSize poolSize = {};
+        poolSize.type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        poolSize.descriptorCount = 1u;
+
+        VkDescriptorPoolCreateInfo poolInfo = {};
+        poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.maxSets       = 1u;
+        poolInfo.poolSizeCount = 1u;
+        poolInfo.pPoolSizes    = &poolSize;
+
+        vkCreateDescriptorPool(device->GetLogical(), &poolInfo, nullptr, &accumulation.descriptorPool);
+
+        VkDescriptorSetAllocateInfo setInfo = {};
+        setInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        setInfo.descriptorPool     = accumulation.descriptorPool;
+        setInfo.descriptorSetCount = 1u;
+        setInfo.pSetLayouts        = &pipeline.descriptorSetLayout;
+
+        vkAllocateDescriptorSets(device->GetLogical(), &setInfo, &accumulation.descriptorSet);
+
+        VkDescriptorImageInfo imageInfo = {};
+        imageInfo.sampler     = pipeline.sampler;
+        imageInfo.imageView   = m_ColorTarget->GetData()->view;
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        VkWriteDescriptorSet write = {};
+        write.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet          = accumulation.descriptorSet;
+        write.dstBinding      = 0u;
+        write.descriptorCount = 1u;
+        write.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.pImageInfo      = &imageInfo;
+
+        vkUpdateDescriptorSets(device->GetLogical(), 1u, &write, 0u, nullptr);
+
+        accumulation.boundColor = m_ColorTarget;
+    }
+
+    VkImage color   = m_ColorTarget->GetData()->image;
+    VkImage average = accumulation.target->GetData()->image;
+
+    // The first sample replaces whatever the target held, later ones find it where the previous blit left it.
+    bool firstSample = m_SampleCount == 0u;
+
+    TransitionColorImage(cmd, color, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+    TransitionColorImage(cmd, average, firstSample ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0x0,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+
+    // Cleared on the first sample so that undefined contents (possibly NaN) never reach the blend.
+    VkRenderingAttachmentInfoKHR averageAttachment = {};
+    averageAttachment.sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+    averageAttachment.imageView   = accumulation.target->GetData()->view;
+    averageAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    averageAttachment.loadOp      = firstSample ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+    averageAttachment.storeOp     = VK_ATTACHMENT_STORE_OP_STORE;
+
+    VkRenderingInfoKHR renderInfo = {};
+    renderInfo.sType                = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+    renderInfo.renderArea           = scissor;
+    renderInfo.layerCount           = 1;
+    renderInfo.colorAttachmentCount = 1;
+    renderInfo.pColorAttachments    = &averageAttachment;
+
+#if __APPLE__
+    Device::vkCmdBeginRenderingKHR(cmd, &renderInfo);
+#else
+    vkCmdBeginRendering(cmd, &renderInfo);
+#endif
+
+    float weight = 1.0f / (float)(m_SampleCount + 1u);
+    float blendConstants[4] = { weight, weight, weight, weight };
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipelineLayout, 0u, 1u, &accumulation.descriptorSet, 0u, nullptr);
+
+    Device::vkCmdSetViewportWithCountEXT(cmd, 1u, &viewport);
+    Device::vkCmdSetScissorWithCountEXT(cmd, 1u, &scissor);
+
+    vkCmdSetBlendConstants(cmd, blendConstants);
+    vkCmdDraw(cmd, 3u, 1u, 0u, 0u);
+
+#if __APPLE__
+    Device::vkCmdEndRenderingKHR(cmd);
+#else
+    vkCmdEndRendering(cmd);
+#endif
+
+    // Replace the sample with the average (converted to the color format by the blit), so everything
+    // downstream of the color target is unchanged.
+    TransitionColorImage(cmd, average, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+    TransitionColorImage(cmd, color, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0x0,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+    VkImageBlit blitRegion = {};
+    blitRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blitRegion.srcSubresource.layerCount = 1u;
+    blitRegion.srcOffsets[1]             = { (int32_t)scissor.extent.width, (int32_t)scissor.extent.height, 1 };
+    blitRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blitRegion.dstSubresource.layerCount = 1u;
+    blitRegion.dstOffsets[1]             = { (int32_t)scissor.extent.width, (int32_t)scissor.extent.height, 1 };
+
+    vkCmdBlitImage(cmd, average, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, color, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1u, &blitRegion, VK_FILTER_NEAREST);
+
+    TransitionColorImage(cmd, color, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+}
+
+bool ExRenderPass::IsConverged() const
+{
+    return m_SampleCount >= m_TargetSampleCount;
+}
+
+ExRenderPass::ExRenderPass(HdRenderIndex *index, HdRprimCollection const &collection, ExRenderDelegate* renderDelegate) 
+    : HdRenderPass(index, collection), m_Owner(renderDelegate), m_ViewKey(), m_ViewDirty(true), m_ViewProjection(1.0f), m_JitterIndex(0u),
+      m_SceneStateVersion(0u), m_CollectionVersion(0u), m_RenderTagVersion(0u), m_SettingsHash(0u), m_SampleCount(0u), m_TargetSampleCount(1u),
+      m_ColorTarget(nullptr), m_DepthTarget(nullptr), m_PrimIdTarget(nullptr), m_TargetExtent({ 0u, 0u }), m_Culler(std::make_unique<ExCuller>())
+{
+    // No device resources to create when rasterizing on the CPU. Otherwise the pipelines live in the
+    // delegate's frame context, and the targets are created on first execute.
+    if (m_Owner->IsSoftwareRendering())
+        m_SoftwareRasterizer = std::make_unique<ExSoftwareRasterizer>();
 }
 
 ExRenderPass::~ExRenderPass() 
 {
-    auto device = m_Owner->GetGraphicsDevice();
+    if (m_Owner->IsSoftwareRendering())
+        return;
+
+    ExFrameContext* context = m_Owner->GetFrameContext();
+
+    // The targets go back to the pool shared with the delegate's other passes. Nothing here waits on the
+    // device: the pool and the context hold on to what frames in flight may still use until they complete.
+    std::lock_guard<std::mutex> lock(context->GetMutex());
+
+    if (m_ColorTarget != nullptr)
+        m_Owner->GetRenderTargetPool()->Release(m_ColorTarget);
 
-    vkDeviceWaitIdle(device->GetLogical());
+    if (m_DepthTarget != nullptr)
+        m_Owner->GetRenderTargetPool()->Release(m_DepthTarget);
 
-    for (auto& shader : s_Shaders)
-        device->ReleaseShaders ({ &shader.second });
+    if (m_PrimIdTarget != nullptr)
+        m_Owner->GetRenderTargetPool()->Release(m_PrimIdTarget);
 
-    for (auto& image : s_Images)
-        device->ReleaseImages ({ &image.second });
+    if (m_Accumulation != nullptr)
+    {
+        if (m_Accumulation->target != nullptr)
+            m_Owner->GetRenderTargetPool()->Release(m_Accumulation->target);
 
-    for (auto& buffer : s_Buffers)
-        device->ReleaseBuffers ({ &buffer.second });
+        context->RetireDescriptorPool(m_Accumulation->descriptorPool);
+    }
 }
 
 static void GetViewportScissor(HdRenderPassStateSharedPtr const& renderPassState, VkRect2D* scissor, VkViewport* viewport)
@@ -159,58 +1129,178 @@ static void GetViewportScissor(HdRenderPassStateSharedPtr const& renderPassState
     
 }
 
+void ExRenderPass::_ExecuteSoftware(HdRenderPassStateSharedPtr const& renderPassState)
+{
+    // Only color and depth are produced in software.
+    AovTargets aovs = GatherAovTargets(GetRenderIndex(), renderPassState);
+
+    ExSoftwareTarget target;
+    target.color      = aovs.color;
+    target.depth      = aovs.depth;
+    target.clearColor = aovs.clearColor;
+    target.clearDepth = aovs.clearDepth;
+
+    ExRenderBuffer* reference = target.color != nullptr ? target.color : target.depth;
+
+    if (reference == nullptr)
+    {
+        TF_WARN("Software rendering requires a color or depth AOV binding, nothing was rendered.");
+        return;
+    }
+
+    VkExtent2D extent = { reference->GetWidth(), reference->GetHeight() };
+
+    // The AOVs still hold the last image if nothing changed.
+    if (!_UpdateProgress(renderPassState, extent))
+        return;
+
+    ExResourceRegistry* registry  = m_Owner->GetExResourceRegistry();
+    ExDrawTable*        drawTable = registry->GetDrawTable();
+
+    ExRenderStats* stats = m_Owner->GetExRenderStats();
+
+    GfMatrix4f viewProjection = _UpdateViewProjection(renderPassState, extent);
+    {
+        TRACE_SCOPE("Cull");
+        ExScopedTimer timer(stats, ExRenderPhase::Cull);
+
+        if (m_Owner->GetRenderSetting<bool>(ExRenderSettingsTokens->frustumCulling, true))
+        {
+            m_Culler->Cull(registry->GetBoundsHierarchy(), *drawTable, viewProjection,
+                           (float)reference->GetWidth() / std::max((float)reference->GetHeight(), 1.0f),
+                           m_Owner->GetRenderSetting<bool>(ExRenderSettingsTokens->occlusionCulling, false),
+                           &m_VisibleSlots);
+        }
+        else
+        {
+            m_VisibleSlots.resize(drawTable->GetSlotCount());
+            std::iota(m_VisibleSlots.begin(), m_VisibleSlots.end(), 0u);
+        }
+    }
+
+    stats->SetDrawCounts(drawTable->GetSlotCount(), (uint32_t)m_VisibleSlots.size());
+
+    // Rasterization takes the place of recording (there is nothing to submit).
+    {
+        TRACE_SCOPE("Rasterize");
+        ExScopedTimer timer(stats, ExRenderPhase::Record);
+
+        m_SoftwareRasterizer->Render(*drawTable, m_VisibleSlots, viewProjection, target);
+    }
+
+    // Samples are not accumulated in software, every image is final.
+    m_SampleCount = m_TargetSampleCount;
+}
+
 void ExRenderPass::_Execute(HdRenderPassStateSharedPtr const& renderPassState, TfTokenVector const &renderTags)
 {   
+    TRACE_FUNCTION();
+
+    if (m_Owner->IsSoftwareRendering())
+    {
+        _ExecuteSoftware(renderPassState);
+        return;
+    }
+
+    ExRenderStats* stats = m_Owner->GetExRenderStats();
+
     // Grab a handle to the device. 
     Device* device = m_Owner->GetGraphicsDevice();
 
-    // grab a handle to the current frame. 
-    Frame* frame = m_Owner->GetRenderSetting(TfToken("CurrentFrame")).UncheckedGet<Frame*>();
+    // Frame resources of this delegate, shared with its other passes for the duration of the execute.
+    ExFrameContext* context = m_Owner->GetFrameContext();
+
+    std::lock_guard<std::mutex> lock(context->GetMutex());
+
+    // grab a handle to the current frame (only provided when the application submits). 
+    Frame* frame = nullptr;
+
+    // Index of that frame. Our draw frames recorded into it are reused once the application is kFrameCount frames past it.
+    uint64_t hostFrame = ExFrameContext::kNoHostFrame;
+
+    if (!m_Owner->RequiresManualQueueSubmit())
+    {
+        frame = m_Owner->GetRenderSetting(TfToken("CurrentFrame")).UncheckedGet<Frame*>();
+
+        VtValue frameIndex = m_Owner->GetRenderSetting(TfToken("CurrentFrameIndex"));
+
+        if (!frameIndex.IsHolding<uint64_t>())
+        {
+            TF_CODING_ERROR("The application submits, but no \"CurrentFrameIndex\" (uint64_t) was provided along with the \"CurrentFrame\".");
+            return;
+        }
+
+        hostFrame = frameIndex.UncheckedGet<uint64_t>();
+    }
 
     VkRect2D   currentScissor;
     VkViewport currentViewport;
     GetViewportScissor(renderPassState, &currentScissor, &currentViewport);
 
-    if (s_PreviousViewport.width  != currentViewport.width ||
-        s_PreviousViewport.height != currentViewport.height)
-    {
-        CreateViewportSizedResources(device, currentViewport);
-        s_PreviousViewport = currentViewport;
-    }
+    _UpdateRenderTargets(currentScissor.extent);
 
-    // Create necesarry backbuffers if needed 
-    static bool bCreatedGLObjects = false;
+    // AOVs are only resolved on the manual-submit path. Otherwise the command buffer is handed back to the
+    // application, so there is no submission of ours to fence the copies with.
+    AovTargets aovs;
 
-    if (m_Owner->RequiresManualQueueSubmit() && !bCreatedGLObjects)
+    if (m_Owner->RequiresManualQueueSubmit())
     {
-        glewInit();
+        aovs = GatherAovTargets(GetRenderIndex(), renderPassState);
+
+        if (!IsAovResolvable(aovs.color,  HdFormatUNorm8Vec4)) aovs.color  = nullptr;
+        if (!IsAovResolvable(aovs.depth,  HdFormatFloat32))    aovs.depth  = nullptr;
+        if (!IsAovResolvable(aovs.primId, HdFormatInt32))      aovs.primId = nullptr;
+    }
 
-        GLint currentFramebuffer;
-        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &currentFramebuffer);
+    // When the color AOV is resolved the application presents it, so our own GL round trip is skipped.
+    bool presentAov = aovs.color != nullptr;
 
-        std::vector<uint8_t> imageData(4 * currentViewport.width * currentViewport.height);
-        glGenTextures(1, &s_GLBackbufferImage);
-        glBindTexture(GL_TEXTURE_2D, s_GLBackbufferImage);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, currentViewport.width, currentViewport.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, imageData.data());
+    // Create necesarry backbuffers if needed (headless applications presenting AOVs may have no GL context at all).
+    if (m_Owner->RequiresManualQueueSubmit() && !presentAov)
+        context->CreateGLObjects();
 
-        glGenFramebuffers(1, &s_GLBackbufferObject);
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, s_GLBackbufferObject);
-        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, s_GLBackbufferImage, 0);
+    // Nothing changed and the image is final: present it again instead of rendering it again.
+    if (!_UpdateProgress(renderPassState, currentScissor.extent))
+    {
+        TRACE_SCOPE("Present Cached");
 
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, currentFramebuffer);
-        glBindTexture(GL_TEXTURE_2D, currentFramebuffer);
+        // Resolved AOVs still hold the image. Otherwise catch the GL backbuffer up with the frames in flight.
+        if (m_Owner->RequiresManualQueueSubmit())
+        {
+            if (!presentAov)
+            {
+                context->PresentLatestReadback();
+                context->BlitGLBackbuffer();
+            }
+        }
+        else
+        {
+            // The color target was left as a transfer source by the frame that rendered it.
+            CopyToBackBuffer(frame->commandBuffer, m_ColorTarget, frame->backBuffer, currentScissor.extent);
+        }
 
-        bCreatedGLObjects = true;
+        return;
     }
 
+    ReadbackFrame* readback = nullptr;
+
     VkCommandBuffer cmd;
     {
         if (m_Owner->RequiresManualQueueSubmit())
         {
-            assert(s_InternalCmd != nullptr);
+            // Waits for the last submission that used the slot.
+            {
+                TRACE_SCOPE("Wait For Frame Slot");
+                ExScopedTimer timer(stats, ExRenderPhase::Readback);
+
+                readback = context->AcquireReadbackFrame();
+            }
+
+            if (!presentAov)
+                context->ResizeReadbackStaging(readback, currentScissor.extent);
 
             // Reset the command buffer for this frame.
-            vkResetCommandBuffer(s_InternalCmd, 0x0);
+            vkResetCommandBuffer(readback->cmd, 0x0);
 
             // Enable the command buffer into a recording state. 
             VkCommandBufferBeginInfo commandBegin = {};
@@ -219,9 +1309,9 @@ void ExRenderPass::_Execute(HdRenderPassStateSharedPtr const& renderPassState, T
             commandBegin.flags            = 0;
             commandBegin.pInheritanceInfo = nullptr;
                         
-            vkBeginCommandBuffer(s_InternalCmd, &commandBegin);
+            vkBeginCommandBuffer(readback->cmd, &commandBegin);
 
-            cmd = s_InternalCmd;
+            cmd = readback->cmd;
         }
         else
         {
@@ -232,26 +1322,173 @@ void ExRenderPass::_Execute(HdRenderPassStateSharedPtr const& renderPassState, T
         }
     }
 
-    Image::TransferUnknownToWrite(cmd, s_Images[ImageID::COLOR].GetData()->image);
+    ExResourceRegistry* registry = m_Owner->GetExResourceRegistry();
+    ExDrawTable*        drawTable = registry->GetDrawTable();
+
+    // Only handed out once the submission (or application frame) that last used it has completed, so its
+    // indirect commands, descriptor set, recording pools and queries can all be reused.
+    DrawFrame* drawFrame = context->AcquireDrawFrame(hostFrame);
+
+    context->ReadTimestamps(drawFrame, stats);
+
+    // Draws recorded inline (into cmd), or on worker threads into secondary command buffers.
+    uint32_t                     drawCount = 0u;
+    DrawBatches                  batches;
+    std::vector<VkCommandBuffer> secondaries;
+    DrawState                    drawState = {};
+
+    bool recordParallel = false;
+
+    // Nothing can be drawn until the first commit has created the record and transform buffers.
+    if (drawTable->GetRecordBuffer()->Get() != nullptr && drawTable->GetTransformBuffer()->Get() != nullptr)
+    {
+        UpdateDrawDescriptors(device, drawFrame, registry);
+
+        drawState.descriptorSet  = drawFrame->descriptorSet;
+        drawState.viewProjection = _UpdateViewProjection(renderPassState, currentScissor.extent);
+        drawState.viewport       = currentViewport;
+        drawState.scissor        = currentScissor;
+        drawState.indexBuffer    = registry->GetGeometryHeap()->GetBuffer()->Get()->GetData()->buffer;
+
+        // The readback lands in GL with a bottom-left origin, which matches the un-flipped Vulkan image.
+        // When presenting directly, flip to match Hydra's Y-up clip space.
+        if (!m_Owner->RequiresManualQueueSubmit())
+        {
+            drawState.viewport.height = -currentViewport.height;
+            drawState.viewport.y      =  currentViewport.height;
+        }
+
+        // Cull ahead of recording, so that only the surviving slots cost submission and vertex work.
+        {
+            TRACE_SCOPE("Cull");
+            ExScopedTimer timer(stats, ExRenderPhase::Cull);
+
+            if (m_Owner->GetRenderSetting<bool>(ExRenderSettingsTokens->frustumCulling, true))
+            {
+                m_Culler->Cull(registry->GetBoundsHierarchy(), *drawTable, drawState.viewProjection,
+                               currentViewport.width / std::max(currentViewport.height, 1.0f),
+                               m_Owner->GetRenderSetting<bool>(ExRenderSettingsTokens->occlusionCulling, false),
+                               &m_VisibleSlots);
+            }
+            else
+            {
+                m_VisibleSlots.resize(drawTable->GetSlotCount());
+                std::iota(m_VisibleSlots.begin(), m_VisibleSlots.end(), 0u);
+            }
+        }
+
+        stats->SetDrawCounts(drawTable->GetSlotCount(), (uint32_t)m_VisibleSlots.size());
+
+        TRACE_SCOPE("Record");
+        ExScopedTimer timer(stats, ExRenderPhase::Record);
+
+        SortByVariant(drawTable, &m_VisibleSlots, &m_SortScratch, &batches);
+
+        DrawView view = ComputeDrawView(renderPassState, drawState.viewProjection, currentViewport.height,
+                                        m_Owner->GetRenderSetting<float>(ExRenderSettingsTokens->lodPixelError, 1.0f),
+                                        m_Owner->GetRenderSetting<bool>(ExRenderSettingsTokens->clusterCulling, true));
+
+        // Sized for the slots now that it is known which of them are split into clusters.
+        ComputeCommandOffsets(drawTable, view, m_VisibleSlots, &m_CommandOffsets);
+        ReserveIndirectCommands(device, m_Owner->GetRenderTargetPool(), drawFrame, m_CommandOffsets.back());
+
+        drawState.indirectBuffer = drawFrame->indirect->GetData()->buffer;
+
+        recordParallel = m_Owner->GetRenderSetting<bool>(ExRenderSettingsTokens->parallelRecording, true) &&
+                         m_VisibleSlots.size() > kSlotsPerRecordingChunk;
+
+        if (recordParallel)
+            RecordDrawsParallel(context, drawFrame, drawTable, view, m_VisibleSlots, m_CommandOffsets, batches, drawState, &secondaries);
+        else
+        {
+            for (uint32_t i = 0u; i < batches.count; ++i)
+            {
+                DrawBatch& batch = batches.batches[i];
+
+                batch.firstCommand = m_CommandOffsets[batch.firstSlot];
+                batch.drawCount    = WriteIndirectCommands(drawFrame, drawTable, view, m_VisibleSlots, m_CommandOffsets, batch.firstSlot, batch.lastSlot);
+                drawCount         += batch.drawCount;
+            }
+        }
+
+        vmaFlushAllocation(device->GetAllocator(), drawFrame->indirect->GetData()->allocation, 0u, VK_WHOLE_SIZE);
+    }
+
+    // Queries have to be reset outside of a rendering scope before they are written again.
+    context->ResetTimestamps(cmd, drawFrame);
+
+    // The targets are shared by every frame in flight, so the previous frame's copy-outs (and accumulation
+    // reads of the color) must finish before we render over them again. The transitions wait on those stages
+    // themselves rather than relying on the wrapper's, write-after-read only needs the execution dependency.
+    TransitionColorImage(cmd, m_ColorTarget->GetData()->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+
+    TransitionColorImage(cmd, m_PrimIdTarget->GetData()->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+
+    // Depth is cleared every frame, so the previous contents can be discarded (after the previous depth copy-out).
+    {
+        VkImageMemoryBarrier depthBarrier = {};
+        depthBarrier.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        depthBarrier.srcAccessMask               = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        depthBarrier.dstAccessMask               = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        depthBarrier.oldLayout                   = VK_IMAGE_LAYOUT_UNDEFINED;
+        depthBarrier.newLayout                   = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
+        depthBarrier.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+        depthBarrier.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+        depthBarrier.image                       = m_DepthTarget->GetData()->image;
+        depthBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+        depthBarrier.subresourceRange.levelCount = 1u;
+        depthBarrier.subresourceRange.layerCount = 1u;
+
+        vkCmdPipelineBarrier(cmd, 
+                             VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 
+                             VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, 
+                             0x0, 0u, nullptr, 0u, nullptr, 1u, &depthBarrier);
+    }
 
     VkRenderingAttachmentInfoKHR colorAttachment = {};
     colorAttachment.sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
-    colorAttachment.imageView   = s_Images[ImageID::COLOR].GetData()->view;
+    colorAttachment.imageView   = m_ColorTarget->GetData()->view;
     colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
     colorAttachment.loadOp      = VK_ATTACHMENT_LOAD_OP_CLEAR;
     colorAttachment.storeOp     = VK_ATTACHMENT_STORE_OP_STORE;
-    colorAttachment.clearValue.color = { 1, 0, 0, 1 };
-
+    colorAttachment.clearValue.color = { { aovs.clearColor[0], aovs.clearColor[1], aovs.clearColor[2], aovs.clearColor[3] } };
+
+    VkRenderingAttachmentInfoKHR primIdAttachment = {};
+    primIdAttachment.sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+    primIdAttachment.imageView   = m_PrimIdTarget->GetData()->view;
+    primIdAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    primIdAttachment.loadOp      = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    primIdAttachment.storeOp     = aovs.primId != nullptr ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    primIdAttachment.clearValue.color.int32[0] = aovs.clearPrimId;
+
+    VkRenderingAttachmentInfoKHR colorAttachments[2] = { colorAttachment, primIdAttachment };
+
+    VkRenderingAttachmentInfoKHR depthAttachment = {};
+    depthAttachment.sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+    depthAttachment.imageView   = m_DepthTarget->GetData()->view;
+    depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
+    depthAttachment.loadOp      = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.storeOp     = aovs.depth != nullptr ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.clearValue.depthStencil = { aovs.clearDepth, 0u };
 
     VkRenderingInfoKHR renderInfo = {};
     renderInfo.sType                = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
     renderInfo.renderArea           = currentScissor;
     renderInfo.layerCount           = 1;
-    renderInfo.colorAttachmentCount = 1;
-    renderInfo.pColorAttachments    = &colorAttachment;
-    renderInfo.pDepthAttachment     = nullptr;
+    renderInfo.colorAttachmentCount = 2;
+    renderInfo.pColorAttachments    = colorAttachments;
+    renderInfo.pDepthAttachment     = &depthAttachment;
     renderInfo.pStencilAttachment   = nullptr;
 
+    // Secondary command buffers may only be executed in a scope that declares it.
+    if (recordParallel)
+        renderInfo.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR;
+
+    context->WriteTimestamp(cmd, drawFrame, 0u, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
 
     // Write commands for this frame. 
 #if __APPLE__
@@ -260,32 +1497,10 @@ void ExRenderPass::_Execute(HdRenderPassStateSharedPtr const& renderPassState, T
     vkCmdBeginRendering(cmd, &renderInfo);
 #endif
 
-    /*
-    Shader::Bind(cmd, s_Shaders[ShaderID::MESH_VS]);
-    Shader::Bind(cmd, s_Shaders[ShaderID::UNLIT_PS]);
-
-    // Configure render state
-    Device::SetDefaultRenderState(cmd);
-
-    if (m_Owner->RequiresManualQueueSubmit())
-    {
-        VkViewport flippedViewport = currentViewport;
-        {
-            flippedViewport.height = -currentViewport.height;
-            flippedViewport.y = currentViewport.height;
-        }
-
-        Device::vkCmdSetViewportWithCountEXT(cmd, 1u, &flippedViewport);
-        Device::vkCmdSetFrontFaceEXT(cmd, VK_FRONT_FACE_COUNTER_CLOCKWISE);
-    }
-    else
-        Device::vkCmdSetViewportWithCountEXT(cmd, 1u, &currentViewport);
-
-
-    Device::vkCmdSetScissorWithCountEXT(cmd, 1u,  &currentScissor);
-
-    vkCmdDraw(cmd, 3u, 1u, 0u, 0u);
-    */
+    if (!secondaries.empty())
+        vkCmdExecuteCommands(cmd, (uint32_t)secondaries.size(), secondaries.data());
+    else if (drawCount > 0u)
+        RecordDraws(cmd, context->GetMeshPipeline(), drawState, batches.batches, batches.count);
 
 #if __APPLE__
     Device::vkCmdEndRenderingKHR(cmd);
@@ -293,14 +1508,74 @@ void ExRenderPass::_Execute(HdRenderPassStateSharedPtr const& renderPassState, T
     vkCmdEndRendering(cmd);
 #endif
 
+    // Progressive: average this sample with the previous ones for the same view.
+    if (m_TargetSampleCount > 1u)
+        _RecordAccumulation(cmd, currentScissor, currentViewport);
+
+    m_SampleCount++;
+
+    context->WriteTimestamp(cmd, drawFrame, 1u, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
     // Conclude internal command buffer recording.
     if (m_Owner->RequiresManualQueueSubmit())
     {
+        context->WriteTimestamp(cmd, drawFrame, 2u, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+
         // Prepare internal color target for copy.
-        Image::TransferWriteToSource(cmd, s_Images[ImageID::COLOR].GetData()->image);
+        Image::TransferWriteToSource(cmd, m_ColorTarget->GetData()->image);
 
-        // Transfer the internal color target to staging buffer memory that will be mapped after the command is executed.
-        Buffer::CopyImage(cmd, &s_Images[ImageID::COLOR], &s_Buffers[BufferID::COLOR_MAP_STAGING]);
+        // Transfer the internal color target to this slot's staging memory that will be mapped after the command is executed.
+        if (!presentAov)
+            CopyImageRegionToBuffer(cmd, m_ColorTarget, readback->staging, currentScissor.extent);
+
+        // Copy the targets straight into the AOVs' mapped memory.
+        ExRenderBuffer* resolved[3] = { aovs.color, aovs.depth, aovs.primId };
+
+        if (aovs.color != nullptr)
+            CopyImageToRenderBuffer(cmd, m_ColorTarget, VK_IMAGE_ASPECT_COLOR_BIT, aovs.color, currentScissor.extent);
+
+        if (aovs.depth != nullptr)
+        {
+            VkImageMemoryBarrier depthBarrier = {};
+            depthBarrier.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            depthBarrier.srcAccessMask               = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            depthBarrier.dstAccessMask               = VK_ACCESS_TRANSFER_READ_BIT;
+            depthBarrier.oldLayout                   = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
+            depthBarrier.newLayout                   = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            depthBarrier.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+            depthBarrier.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+            depthBarrier.image                       = m_DepthTarget->GetData()->image;
+            depthBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+            depthBarrier.subresourceRange.levelCount = 1u;
+            depthBarrier.subresourceRange.layerCount = 1u;
+
+            vkCmdPipelineBarrier(cmd, 
+                                 VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 
+                                 0x0, 0u, nullptr, 0u, nullptr, 1u, &depthBarrier);
+
+            CopyImageToRenderBuffer(cmd, m_DepthTarget, VK_IMAGE_ASPECT_DEPTH_BIT, aovs.depth, currentScissor.extent);
+        }
+
+        if (aovs.primId != nullptr)
+        {
+            Image::TransferWriteToSource(cmd, m_PrimIdTarget->GetData()->image);
+
+            CopyImageToRenderBuffer(cmd, m_PrimIdTarget, VK_IMAGE_ASPECT_COLOR_BIT, aovs.primId, currentScissor.extent);
+        }
+
+        // Make the copies visible to host reads once the timeline reaches the submission.
+        {
+            VkMemoryBarrier hostBarrier = {};
+            hostBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+            vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0x0, 1u, &hostBarrier, 0u, nullptr, 0u, nullptr);
+        }
+
+        context->WriteTimestamp(cmd, drawFrame, 3u, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+        context->SubmitTimestamps(drawFrame);
 
         // Conclude internal command rendering.
         vkEndCommandBuffer(cmd);
@@ -310,70 +1585,78 @@ void ExRenderPass::_Execute(HdRenderPassStateSharedPtr const& renderPassState, T
         submitInfo.commandBufferCount   = 1u;
         submitInfo.pCommandBuffers      = &cmd;
         
+        for (ExRenderBuffer* renderBuffer : resolved)
+        {
+            if (renderBuffer != nullptr)
+                renderBuffer->BeginResolve();
+        }
+
+        // Submit the the internal command to graphics queue, its timeline value tracks its completion.
+        uint64_t timelineValue;
+        {
+            TRACE_SCOPE("Submit");
+            ExScopedTimer timer(stats, ExRenderPhase::Submit);
 
-        // Submit the the internal command to graphics queue.
-        vkQueueSubmit(device->GetGraphicsQueue(), 1u, &submitInfo, nullptr);
+            timelineValue = m_Owner->GetTimeline()->Submit(device->GetGraphicsQueue(), submitInfo);
+        }
+
+        // The AOVs converge asynchronously (and only with the last sample), nothing here waits on the copies.
+        for (ExRenderBuffer* renderBuffer : resolved)
+        {
+            if (renderBuffer != nullptr)
+                renderBuffer->EndResolve(timelineValue, IsConverged());
+        }
 
-        // Wait until the work is done.
-        vkDeviceWaitIdle(device->GetLogical());
+        context->SubmitReadbackFrame(readback, timelineValue, !presentAov);
+        context->SubmitDrawFrame(drawFrame, timelineValue);
 
-        // Currently Hydra does not really make it easy to share memory on the device-side.
-        // So we need to have a round trip copy via the CPU to the current GL backbuffer.
+        if (presentAov)
+            return;
 
-        VmaAllocationInfo allocInfo;
-        vmaGetAllocationInfo(device->GetAllocator(), s_Buffers[BufferID::COLOR_MAP_STAGING].GetData()->allocation, &allocInfo);
+        // Resolve which frame to present. With a latency of L we present the frame submitted L invocations
+        // ago, which gives the GPU L frames of slack before the CPU has to wait on it.
+        uint64_t latency = (uint64_t)std::clamp(m_Owner->GetRenderSetting<int>(ExRenderSettingsTokens->readbackLatency, 0), 0, (int)ExFrameContext::kFrameCount - 1);
 
-        auto mappedData = std::vector<uint8_t>(allocInfo.size);
-        vmaCopyAllocationToMemory(device->GetAllocator(), s_Buffers[BufferID::COLOR_MAP_STAGING].GetData()->allocation, 0u, mappedData.data(), allocInfo.size);
+        // During warm-up (or after the latency was raised) fall back to the oldest frame in flight.
+        uint64_t presentFrameID = readback->frameID >= latency ? readback->frameID - latency : 0u;
 
-    #if 0
-        // Copy the mapped data into the internal backbuffer image data. 
-        WritePNG("/Users/johnparsaie/Development/test.png", currentViewport.width, currentViewport.height, 4u, mappedData.data(), 4u);
-    #endif
+        ReadbackFrame* present = context->GetReadbackFrame(presentFrameID);
 
-        GLint currentFramebuffer;
-        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &currentFramebuffer);
+        if (present->pending && present->frameID == presentFrameID)
+        {
+            TRACE_SCOPE("Readback");
+            ExScopedTimer timer(stats, ExRenderPhase::Readback);
 
-        // Bind our internal FBO for write.
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, s_GLBackbufferObject);
+            // Wait only for the frame being presented (not the whole device, nor any later frame).
+            m_Owner->GetTimeline()->Wait(present->timelineValue);
 
-        // Copy the mapped data into the internal backbuffer image data. 
-        glBindTexture(GL_TEXTURE_2D, s_GLBackbufferImage);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, currentViewport.width, currentViewport.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, mappedData.data());
+            // Currently Hydra does not really make it easy to share memory on the device-side.
+            // So we need to have a round trip via the CPU to the current GL backbuffer.
+        #if 0
+            WritePNG("/Users/johnparsaie/Development/test.png", present->extent.width, present->extent.height, 4u, present->mapped, 4u);
+        #endif
 
-        // Blit the internal backbuffer into the host one.
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, s_GLBackbufferObject);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, currentFramebuffer);
+            context->UploadGLBackbuffer(present);
 
-        glBlitFramebuffer(0, 0, currentViewport.width, currentViewport.height, 
-                          0, 0, currentViewport.width, currentViewport.height, 
-                          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            present->pending = false;
+        }
 
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, currentFramebuffer);
+        // If nothing new was read back this frame (warm-up) the previously presented image is blitted again.
+        context->BlitGLBackbuffer();
     }
     else
     {
         // Otherwise we can copy the image memory directly to the back buffer. 
 
-        Image::TransferWriteToSource(cmd, s_Images[ImageID::COLOR].GetData()->image);
-        Image::TransferUnknownToDestination(cmd, frame->backBuffer);
-
-        VkImageCopy copyRegion = {};
-        copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        copyRegion.srcSubresource.layerCount = 1;
-        copyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        copyRegion.dstSubresource.layerCount = 1;
-        copyRegion.extent.width              = (uint32_t)currentScissor.extent.width;
-        copyRegion.extent.height             = (uint32_t)currentScissor.extent.height;
-        copyRegion.extent.depth              = 1;
-        
+        context->WriteTimestamp(cmd, drawFrame, 2u, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+
+        Image::TransferWriteToSource(cmd, m_ColorTarget->GetData()->image);
+
         // Else just copy the color target into the frame-provided backbuffer.
-        vkCmdCopyImage(cmd, 
-                    s_Images[ImageID::COLOR].GetData()->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 
-                    frame->backBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 
-                    1u, &copyRegion);
+        CopyToBackBuffer(cmd, m_ColorTarget, frame->backBuffer, currentScissor.extent);
+
+        context->WriteTimestamp(cmd, drawFrame, 3u, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
 
-        // After copying we prepare the backbuffer for swapchain present.
-        Image::TransferDestinationToPresent(cmd, frame->backBuffer);
+        context->SubmitTimestamps(drawFrame);
     }
 }
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include <ExampleDelegate/ExRenderStats.h>
+
+TF_DEFINE_PUBLIC_TOKENS(ExRenderStatsTokens, EX_RENDER_STATS_TOKENS);
+
+ExRenderStats::ExRenderStats()
+    : m_GpuRenderMilliseconds(0.0), m_GpuCopyMilliseconds(0.0), m_DrawCount(0u), m_VisibleCount(0u), m_FrameCount(0u)
+{
+    for (auto& nanoseconds : m_Nanoseconds)
+        nanoseconds.store(0u);
+}
+
+void ExRenderStats::AddTime(ExRenderPhase phase, std::chrono::steady_clock::duration duration)
+{
+    m_Nanoseconds[(size_t)phase].fetch_add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(), std::memory_order_relaxed);
+}
+
+void ExRenderStats::SetGpuTimes(double renderMilliseconds, double copyMilliseconds)
+{
+    m_GpuRenderMilliseconds.store(renderMilliseconds);
+    m_GpuCopyMilliseconds  .store(copyMilliseconds);
+}
+
+void ExRenderStats::SetDrawCounts(uint32_t drawCount, uint32_t visibleCount)
+{
+    m_DrawCount   .store(drawCount);
+    m_VisibleCount.store(visibleCount);
+}
+
+void ExRenderStats::EndFrame()
+{
+    // Taking each counter resets it for the next interval.
+    auto Milliseconds = [&](ExRenderPhase phase)
+    {
+        return (double)m_Nanoseconds[(size_t)phase].exchange(0u) * 1e-6;
+    };
+
+    VtDictionary stats;
+    stats[ExRenderStatsTokens->syncTime.GetString()]      = VtValue(Milliseconds(ExRenderPhase::Sync));
+    stats[ExRenderStatsTokens->commitTime.GetString()]    = VtValue(Milliseconds(ExRenderPhase::Commit));
+    stats[ExRenderStatsTokens->cullTime.GetString()]      = VtValue(Milliseconds(ExRenderPhase::Cull));
+    stats[ExRenderStatsTokens->recordTime.GetString()]    = VtValue(Milliseconds(ExRenderPhase::Record));
+    stats[ExRenderStatsTokens->submitTime.GetString()]    = VtValue(Milliseconds(ExRenderPhase::Submit));
+    stats[ExRenderStatsTokens->readbackTime.GetString()]  = VtValue(Milliseconds(ExRenderPhase::Readback));
+    stats[ExRenderStatsTokens->gpuRenderTime.GetString()] = VtValue(m_GpuRenderMilliseconds.load());
+    stats[ExRenderStatsTokens->gpuCopyTime.GetString()]   = VtValue(m_GpuCopyMilliseconds.load());
+    stats[ExRenderStatsTokens->drawCount.GetString()]     = VtValue((int)m_DrawCount.load());
+    stats[ExRenderStatsTokens->visibleCount.GetString()]  = VtValue((int)m_VisibleCount.load());
+    stats[ExRenderStatsTokens->frameCount.GetString()]    = VtValue((int)++m_FrameCount);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Published.swap(stats);
+}
+
+VtDictionary ExRenderStats::GetDictionary() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Published;
+}
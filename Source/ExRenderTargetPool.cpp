@@ -0,0 +1,195 @@
+#include <ExampleDelegate/ExRenderTargetPool.h>
+#include <ExampleDelegate/ExTimeline.h>
+
+#include <VulkanWrappers/Device.h>
+#include <VulkanWrappers/Image.h>
+#include <VulkanWrappers/Buffer.h>
+using namespace VulkanWrappers;
+
+#include <pxr/base/tf/hash.h>
+
+#include <algorithm>
+
+// Granularity of image size buckets, in pixels. Dragging a viewport edge stays within one bucket
+// for up to this many pixels before a new allocation is needed.
+static constexpr uint32_t kExtentBucketSize = 256u;
+
+// Granularity of buffer size buckets, in bytes.
+static constexpr VkDeviceSize kBufferBucketSize = 64u * 1024u;
+
+// Number of frames a released resource is kept before its memory is freed. Must comfortably exceed
+// the number of frames that may be in flight (so a released target is never freed while in use).
+static constexpr uint64_t kIdleFramesBeforeFree = 8u;
+
+bool ExRenderTargetPool::Key::operator==(Key const& other) const
+{
+    return width  == other.width  && height == other.height && size  == other.size &&
+           format == other.format && usage  == other.usage  && flags == other.flags;
+}
+
+size_t ExRenderTargetPool::KeyHash::operator()(Key const& key) const
+{
+    return TfHash::Combine(key.width, key.height, key.size, key.format, key.usage, key.flags);
+}
+
+ExRenderTargetPool::ExRenderTargetPool(Device* device, ExTimeline* timeline) : m_Device(device), m_Timeline(timeline), m_FrameIndex(0u)
+{
+}
+
+ExRenderTargetPool::~ExRenderTargetPool()
+{
+    m_Timeline->WaitIdle();
+
+    for (auto& entry : m_Entries)
+        _Free(entry.get());
+}
+
+VkExtent2D ExRenderTargetPool::GetBucketExtent(VkExtent2D extent)
+{
+    auto RoundUp = [](uint32_t x) { return std::max(1u, (x + kExtentBucketSize - 1u) / kExtentBucketSize) * kExtentBucketSize; };
+
+    return { RoundUp(extent.width), RoundUp(extent.height) };
+}
+
+Image* ExRenderTargetPool::AcquireImage(VkExtent2D extent, VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect)
+{
+    VkExtent2D bucket = GetBucketExtent(extent);
+
+    Key key = { bucket.width, bucket.height, 0u, (uint32_t)format, (uint32_t)usage, (uint32_t)aspect };
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    Entry* entry = _Acquire(key);
+
+    if (entry->image == nullptr)
+    {
+        entry->image = std::make_unique<Image>(bucket.width, bucket.height, format, usage, aspect);
+        m_Device->CreateImages({ entry->image.get() });
+
+        m_EntriesByResource[entry->image.get()] = entry;
+    }
+
+    return entry->image.get();
+}
+
+Buffer* ExRenderTargetPool::AcquireBuffer(VkDeviceSize size, VkBufferUsageFlags usage, uint32_t allocationFlags)
+{
+    VkDeviceSize bucket = ((size + kBufferBucketSize - 1u) / kBufferBucketSize) * kBufferBucketSize;
+
+    Key key = { 0u, 0u, bucket, 0u, (uint32_t)usage, allocationFlags };
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    Entry* entry = _Acquire(key);
+
+    if (entry->buffer == nullptr)
+    {
+        entry->buffer = std::make_unique<Buffer>(bucket, usage, (VmaAllocationCreateFlags)allocationFlags);
+        m_Device->CreateBuffers({ entry->buffer.get() });
+
+        m_EntriesByResource[entry->buffer.get()] = entry;
+    }
+
+    return entry->buffer.get();
+}
+
+void ExRenderTargetPool::Release(Image* image)
+{
+    _Release(image);
+}
+
+void ExRenderTargetPool::Release(Buffer* buffer)
+{
+    _Release(buffer);
+}
+
+void ExRenderTargetPool::Tick()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_FrameIndex++;
+
+    // Free anything that has sat unused for long enough (i.e. buckets left behind by a resize).
+    for (auto it = m_Entries.begin(); it != m_Entries.end();)
+    {
+        Entry* entry = it->get();
+
+        if (entry->inUse || m_FrameIndex - entry->lastUsedFrame < kIdleFramesBeforeFree || !m_Timeline->IsComplete(entry->releaseValue))
+        {
+            ++it;
+            continue;
+        }
+
+        auto range = m_EntriesByKey.equal_range(entry->key);
+        for (auto keyIt = range.first; keyIt != range.second; ++keyIt)
+        {
+            if (keyIt->second == entry)
+            {
+                m_EntriesByKey.erase(keyIt);
+                break;
+            }
+        }
+
+        _Free(entry);
+
+        it = m_Entries.erase(it);
+    }
+}
+
+ExRenderTargetPool::Entry* ExRenderTargetPool::_Acquire(Key const& key)
+{
+    // Prefer an idle allocation with a matching key, that the device is done with.
+    auto range = m_EntriesByKey.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (!it->second->inUse && m_Timeline->IsComplete(it->second->releaseValue))
+        {
+            it->second->inUse         = true;
+            it->second->lastUsedFrame = m_FrameIndex;
+            return it->second;
+        }
+    }
+
+    // Otherwise, create a new entry (the caller fills in the resource).
+    m_Entries.push_back(std::make_unique<Entry>());
+
+    Entry* entry = m_Entries.back().get();
+    entry->key           = key;
+    entry->inUse         = true;
+    entry->lastUsedFrame = m_FrameIndex;
+    entry->releaseValue  = 0u;
+
+    m_EntriesByKey.emplace(key, entry);
+
+    return entry;
+}
+
+void ExRenderTargetPool::_Release(void* resource)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    auto it = m_EntriesByResource.find(resource);
+
+    if (!TF_VERIFY(it != m_EntriesByResource.end()))
+        return;
+
+    // Anything submitted so far may still be using the resource.
+    it->second->inUse         = false;
+    it->second->lastUsedFrame = m_FrameIndex;
+    it->second->releaseValue  = m_Timeline->GetSubmittedValue();
+}
+
+void ExRenderTargetPool::_Free(Entry* entry)
+{
+    if (entry->image != nullptr)
+    {
+        m_EntriesByResource.erase(entry->image.get());
+        m_Device->ReleaseImages({ entry->image.get() });
+    }
+
+    if (entry->buffer != nullptr)
+    {
+        m_EntriesByResource.erase(entry->buffer.get());
+        m_Device->ReleaseBuffers({ entry->buffer.get() });
+    }
+}
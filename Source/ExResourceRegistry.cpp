@@ -0,0 +1,494 @@
+#include <ExampleDelegate/ExResourceRegistry.h>
+#include <ExampleDelegate/ExMesh.h>
+#include <ExampleDelegate/ExInstancer.h>
+#include <ExampleDelegate/ExTimeline.h>
+
+#include <VulkanWrappers/Device.h>
+using namespace VulkanWrappers;
+
+#include <pxr/base/arch/hash.h>
+#include <pxr/base/trace/trace.h>
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+// Number of staging arenas cycled between commits.
+static constexpr uint32_t kUploadFrameCount = 2u;
+
+// Number of commits a released range is held for before its heap memory is reused. Covers the
+// frames that may still be reading it on the GPU.
+static constexpr uint64_t kFramesBeforeFree = 4u;
+
+// Initial size of the device geometry heap (it grows as needed).
+static constexpr VkDeviceSize kGeometryHeapSize = 64u * 1024u * 1024u;
+
+// Alignment of every range (satisfies index buffer offsets, vertex attribute fetches, and instance
+// runs, which the draws address in whole instances).
+static constexpr VkDeviceSize kGeometryAlignment = sizeof(ExInstance);
+
+static inline VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1u) & ~(alignment - 1u);
+}
+
+ExGeometryRange::~ExGeometryRange()
+{
+    if (m_Allocation.IsValid())
+        m_Registry->_ReleaseGeometry(m_Allocation);
+}
+
+bool ExGeometryRange::_HasContents(void const* data, size_t size) const
+{
+    return m_Size == size && memcmp(m_Data, data, size) == 0;
+}
+
+ExResourceRegistry::ExResourceRegistry(Device* device, ExTimeline* timeline, bool quantizeVertices) : 
+    m_Device(device), 
+    m_Timeline(timeline), 
+    m_QuantizeVertices(quantizeVertices && device != nullptr),
+    m_GeometryHeap(nullptr),
+    m_DrawTable(device),
+    m_UploadSequence(0u),
+    m_FrameIndex(0u),
+    m_StagingSize(0u)
+{
+    // Without a device (software rendering) the registry only tracks draws, geometry stays on the meshes.
+    if (m_Device == nullptr)
+        return;
+
+    m_GeometryHeap = std::make_unique<ExGeometryHeap>(device, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, kGeometryHeapSize);
+
+    m_UploadFrames.resize(kUploadFrameCount);
+
+    TF_VERIFY(m_Timeline != nullptr);
+
+    for (auto& frame : m_UploadFrames)
+        m_Device->CreateCommandBuffer(&frame.cmd);
+}
+
+ExResourceRegistry::~ExResourceRegistry()
+{
+    for (auto& frame : m_UploadFrames)
+    {
+        m_Timeline->Wait(frame.timelineValue);
+
+        if (frame.staging != nullptr)
+        {
+            m_Device->ReleaseBuffers({ frame.staging });
+            delete frame.staging;
+        }
+    }
+}
+
+ExGeometryRangeSharedPtr ExResourceRegistry::_AddGeometry(VtValue const& source, void const* data, size_t size)
+{
+    if (size == 0u || m_Device == nullptr)
+        return nullptr;
+
+    uint64_t hash = ArchHash64((char const*)data, size, size);
+
+    ExGeometryRangeSharedPtr range;
+    {
+        // Holds the bucket lock, so two threads registering the same data can't both create a range.
+        tbb::concurrent_hash_map<uint64_t, std::weak_ptr<ExGeometryRange>>::accessor accessor;
+        m_Ranges.insert(accessor, hash);
+
+        ExGeometryRangeSharedPtr existing = accessor->second.lock();
+
+        if (existing != nullptr && existing->_HasContents(data, size))
+            return existing;
+
+        range = std::make_shared<ExGeometryRange>();
+        range->m_Registry = this;
+        range->m_Hash     = hash;
+        range->m_Size     = size;
+        range->m_Source   = source;
+        range->m_Data     = data;
+
+        // On a hash collision the live range keeps the entry, and this one just isn't shared.
+        if (existing == nullptr)
+            accessor->second = range;
+    }
+
+    m_PendingUploads.push({ range, source, data, m_UploadSequence.fetch_add(1u, std::memory_order_relaxed) });
+
+    return range;
+}
+
+ExMeshLodChainSharedPtr ExResourceRegistry::GetLodChain(VtVec3fArray const& positions, VtVec3iArray const& triangles)
+{
+    if (m_Device == nullptr || triangles.empty())
+        return nullptr;
+
+    TRACE_FUNCTION();
+
+    // The levels only hold indices, but where they collapse depends on the points they were built from.
+    uint64_t hash = ArchHash64((char const*)triangles.cdata(), triangles.size() * sizeof(GfVec3i), triangles.size());
+    hash = ArchHash64((char const*)positions.cdata(), positions.size() * sizeof(GfVec3f), hash);
+
+    {
+        // Holds the entry lock while simplifying, so meshes sharing the geometry wait for the one build.
+        tbb::concurrent_hash_map<uint64_t, LodChainEntry>::accessor accessor;
+        m_LodChains.insert(accessor, hash);
+
+        ExMeshLodChainSharedPtr chain = accessor->second.chain.lock();
+
+        if (chain == nullptr)
+        {
+            chain = std::make_shared<ExMeshLodChain const>(ExBuildLodChain(positions, triangles, kMaxDrawLods - 1u));
+            accessor->second = { chain, positions, triangles };
+
+            return chain;
+        }
+
+        if (accessor->second.positions == positions && accessor->second.triangles == triangles)
+            return chain;
+    }
+
+    // A hash collision with other live geometry, which keeps the entry. This chain isn't shared.
+    return std::make_shared<ExMeshLodChain const>(ExBuildLodChain(positions, triangles, kMaxDrawLods - 1u));
+}
+
+ExGeometryRangeSharedPtr ExResourceRegistry::_UpdateGeometry(ExGeometryRangeSharedPtr const& range, VtValue const& source, void const* data, size_t size)
+{
+    if (range == nullptr || size == 0u || m_Device == nullptr || !range->IsResident() || range->m_Size != size)
+        return _AddGeometry(source, data, size);
+
+    // Unpublish the old contents first, so that no other mesh can take a reference while we decide.
+    {
+        tbb::concurrent_hash_map<uint64_t, std::weak_ptr<ExGeometryRange>>::accessor accessor;
+
+        if (m_Ranges.find(accessor, range->m_Hash) && accessor->second.lock() == range)
+            m_Ranges.erase(accessor);
+    }
+
+    // Other meshes still draw the old contents.
+    if (range.use_count() > 1)
+        return _AddGeometry(source, data, size);
+
+    uint64_t hash = ArchHash64((char const*)data, size, size);
+    {
+        tbb::concurrent_hash_map<uint64_t, std::weak_ptr<ExGeometryRange>>::accessor accessor;
+        m_Ranges.insert(accessor, hash);
+
+        ExGeometryRangeSharedPtr existing = accessor->second.lock();
+
+        // The new contents are already in the heap, share them and let the caller drop its range.
+        if (existing != nullptr && existing->_HasContents(data, size))
+            return existing;
+
+        // Updated before the range is published, so a lookup never compares against the old contents.
+        range->m_Hash   = hash;
+        range->m_Source = source;
+        range->m_Data   = data;
+
+        // On a hash collision the live range keeps the entry, and this one is patched without being shared.
+        if (existing == nullptr)
+            accessor->second = range;
+    }
+
+    // Keeps its allocation, so commit copies the data over the old contents.
+    m_PendingUploads.push({ range, source, data, m_UploadSequence.fetch_add(1u, std::memory_order_relaxed) });
+
+    return range;
+}
+
+void ExResourceRegistry::_ReleaseGeometry(ExGeometryAllocation const& allocation)
+{
+    m_ReleasedAllocations.push(allocation);
+}
+
+void ExResourceRegistry::_ResizeStaging(UploadFrame* frame, VkDeviceSize size)
+{
+    if (frame->stagingSize >= size)
+        return;
+
+    if (frame->staging != nullptr)
+    {
+        m_Device->ReleaseBuffers({ frame->staging });
+        delete frame->staging;
+    }
+
+    // Grow geometrically so a stage that loads progressively doesn't reallocate every commit.
+    frame->stagingSize = std::max(size, frame->stagingSize * 2u);
+
+    frame->staging = new Buffer(frame->stagingSize, 
+                                VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
+                                VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+
+    m_Device->CreateBuffers({ frame->staging });
+
+    VmaAllocationInfo allocInfo;
+    vmaGetAllocationInfo(m_Device->GetAllocator(), frame->staging->GetData()->allocation, &allocInfo);
+
+    frame->stagingMapped = allocInfo.pMappedData;
+}
+
+VkDeviceSize ExResourceRegistry::_AllocateStaging(VkDeviceSize size)
+{
+    VkDeviceSize offset = m_StagingSize;
+
+    m_StagingSize = AlignUp(m_StagingSize + size, kGeometryAlignment);
+
+    return offset;
+}
+
+void ExResourceRegistry::_RecordStagingCopies(VkCommandBuffer cmd, VkBuffer staging)
+{
+    // Group by destination, in destination order.
+    std::sort(m_StagingCopies.begin(), m_StagingCopies.end(), [](StagingCopy const& a, StagingCopy const& b)
+    {
+        return a.dstBuffer != b.dstBuffer ? a.dstBuffer < b.dstBuffer : a.region.dstOffset < b.region.dstOffset;
+    });
+
+    std::vector<VkBufferCopy> regions;
+
+    for (size_t i = 0u; i < m_StagingCopies.size(); i++)
+    {
+        VkBufferCopy const& region = m_StagingCopies[i].region;
+
+        if (!regions.empty())
+        {
+            VkBufferCopy& previous = regions.back();
+
+            VkDeviceSize dstEnd = previous.dstOffset + previous.size;
+            VkDeviceSize srcEnd = previous.srcOffset + previous.size;
+
+            // Coalesce when only alignment padding separates the two, identically in the arena and the destination.
+            if (region.dstOffset >= dstEnd && region.srcOffset >= srcEnd && 
+                region.dstOffset - dstEnd < kGeometryAlignment && region.srcOffset - srcEnd == region.dstOffset - dstEnd)
+            {
+                previous.size = region.dstOffset + region.size - previous.dstOffset;
+            }
+            else
+                regions.push_back(region);
+        }
+        else
+            regions.push_back(region);
+
+        // Flush at the end of each destination.
+        if (i + 1u == m_StagingCopies.size() || m_StagingCopies[i + 1u].dstBuffer != m_StagingCopies[i].dstBuffer)
+        {
+            vkCmdCopyBuffer(cmd, staging, m_StagingCopies[i].dstBuffer, (uint32_t)regions.size(), regions.data());
+            regions.clear();
+        }
+    }
+}
+
+void ExResourceRegistry::_Commit()
+{
+    m_FrameIndex++;
+
+    m_StagingCopies.clear();
+    m_StagingSize = 0u;
+
+    // Gather uploads, skipping ranges that were dropped again before ever becoming resident. A range patched
+    // more than once since the last commit keeps only its newest contents: copies to overlapping destinations
+    // can't go in one transfer.
+    std::vector<std::pair<ExGeometryRangeSharedPtr, PendingUpload>> uploads;
+    {
+        std::unordered_map<ExGeometryRange*, size_t> uploadIndices;
+
+        PendingUpload upload;
+        while (m_PendingUploads.try_pop(upload))
+        {
+            auto range = upload.range.lock();
+
+            if (range == nullptr)
+                continue;
+
+            auto inserted = uploadIndices.emplace(range.get(), uploads.size());
+
+            if (inserted.second)
+                uploads.emplace_back(std::move(range), std::move(upload));
+            else if (upload.sequence > uploads[inserted.first->second].second.sequence)
+                uploads[inserted.first->second].second = std::move(upload);
+        }
+    }
+
+    // Sub-allocate destinations and lay out the staging arena in the same order, so that ranges
+    // that end up adjacent in the heap are also adjacent in staging and can be copied as one region.
+    // Patched ranges keep their allocation.
+    std::vector<VkDeviceSize> stagingOffsets(uploads.size());
+
+    for (size_t i = 0u; i < uploads.size(); i++)
+    {
+        ExGeometryRange* range = uploads[i].first.get();
+
+        if (!range->m_Allocation.IsValid())
+            m_GeometryHeap->Allocate(range->m_Size, kGeometryAlignment, &range->m_Allocation);
+
+        stagingOffsets[i] = _AllocateStaging(range->m_Size);
+    }
+
+    // With geometry placed, draws that changed during sync can be resolved to heap offsets.
+    m_DrawTable.Resolve(&m_DirtyDrawSlots, &m_DirtyDrawRecords);
+
+    // Slots that moved or changed shape refit the culling hierarchy.
+    m_BoundsHierarchy.Update(m_DrawTable, m_DirtyDrawSlots);
+
+    // Nothing to upload without a device.
+    if (m_Device == nullptr)
+        return;
+
+    VkDeviceSize recordStagingOffset    = _AllocateStaging(m_DirtyDrawRecords.size() * sizeof(ExDrawRecord));
+    VkDeviceSize transformStagingOffset = _AllocateStaging(m_DirtyDrawSlots.size()   * sizeof(GfMatrix4f));
+
+    if (m_StagingSize == 0u)
+        return;
+
+    UploadFrame* frame = &m_UploadFrames[m_FrameIndex % kUploadFrameCount];
+
+    // Wait until the transfer that last used this arena has completed.
+    m_Timeline->Wait(frame->timelineValue);
+
+    _ResizeStaging(frame, m_StagingSize);
+
+    uint8_t* stagingMapped = (uint8_t*)frame->stagingMapped;
+
+    // Fill the arena in parallel, the copies are independent.
+    WorkParallelForN(uploads.size(), [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+            memcpy(stagingMapped + stagingOffsets[i], uploads[i].second.data, uploads[i].first->m_Size);
+    });
+
+    VkBuffer heapBuffer      = m_GeometryHeap->GetBuffer()->Get()->GetData()->buffer;
+    VkBuffer recordBuffer    = m_DrawTable.GetRecordBuffer()->Get()->GetData()->buffer;
+    VkBuffer transformBuffer = m_DrawTable.GetTransformBuffer()->Get()->GetData()->buffer;
+
+    for (size_t i = 0u; i < uploads.size(); i++)
+    {
+        ExGeometryAllocation const& allocation = uploads[i].first->m_Allocation;
+        m_StagingCopies.push_back({ heapBuffer, { stagingOffsets[i], allocation.offset, allocation.size } });
+    }
+
+    // Transform-only changes (most of animated playback) patch a single matrix and leave the record alone.
+    for (size_t i = 0u; i < m_DirtyDrawRecords.size(); i++)
+    {
+        uint32_t     slot         = m_DirtyDrawRecords[i];
+        VkDeviceSize recordOffset = recordStagingOffset + i * sizeof(ExDrawRecord);
+
+        memcpy(stagingMapped + recordOffset, &m_DrawTable.GetRecord(slot), sizeof(ExDrawRecord));
+
+        m_StagingCopies.push_back({ recordBuffer, { recordOffset, slot * sizeof(ExDrawRecord), sizeof(ExDrawRecord) } });
+    }
+
+    for (size_t i = 0u; i < m_DirtyDrawSlots.size(); i++)
+    {
+        uint32_t     slot            = m_DirtyDrawSlots[i];
+        VkDeviceSize transformOffset = transformStagingOffset + i * sizeof(GfMatrix4f);
+
+        memcpy(stagingMapped + transformOffset, &m_DrawTable.GetTransform(slot), sizeof(GfMatrix4f));
+
+        m_StagingCopies.push_back({ transformBuffer, { transformOffset, slot * sizeof(GfMatrix4f), sizeof(GfMatrix4f) } });
+    }
+
+    vmaFlushAllocation(m_Device->GetAllocator(), frame->staging->GetData()->allocation, 0u, m_StagingSize);
+
+    vkResetCommandBuffer(frame->cmd, 0x0);
+
+    VkCommandBufferBeginInfo commandBegin = {};
+    commandBegin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    commandBegin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkBeginCommandBuffer(frame->cmd, &commandBegin);
+
+    // Earlier frames may still be reading records that are about to be overwritten (write-after-read).
+    vkCmdPipelineBarrier(frame->cmd, VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0x0, 0u, nullptr, 0u, nullptr, 0u, nullptr);
+
+    // Carry over contents of any buffer that had to grow, before patching it.
+    bool grew = false;
+    grew |= m_GeometryHeap->GetBuffer()->RecordGrowth(frame->cmd);
+    grew |= m_DrawTable.GetRecordBuffer()->RecordGrowth(frame->cmd);
+    grew |= m_DrawTable.GetTransformBuffer()->RecordGrowth(frame->cmd);
+
+    if (grew)
+    {
+        VkMemoryBarrier growthBarrier = {};
+        growthBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        growthBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        growthBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(frame->cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0x0, 1u, &growthBarrier, 0u, nullptr, 0u, nullptr);
+    }
+
+    _RecordStagingCopies(frame->cmd, frame->staging->GetData()->buffer);
+
+    // Make the copies visible to any subsequent submission that reads geometry.
+    VkMemoryBarrier memoryBarrier = {};
+    memoryBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+    vkCmdPipelineBarrier(frame->cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, 0x0, 1u, &memoryBarrier, 0u, nullptr, 0u, nullptr);
+
+    vkEndCommandBuffer(frame->cmd);
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1u;
+    submitInfo.pCommandBuffers    = &frame->cmd;
+
+    frame->timelineValue = m_Timeline->Submit(m_Device->GetGraphicsQueue(), submitInfo);
+}
+
+void ExResourceRegistry::_GarbageCollect()
+{
+    // Stamp newly released ranges with the current frame, and the last submission that may read them.
+    uint64_t timelineValue = m_Timeline != nullptr ? m_Timeline->GetSubmittedValue() : 0u;
+
+    ExGeometryAllocation allocation;
+    while (m_ReleasedAllocations.try_pop(allocation))
+        m_PendingFrees.push_back({ allocation, m_FrameIndex, timelineValue });
+
+    // Return ranges to the heap once the GPU can no longer be reading them. Frames the application submits
+    // aren't on our timeline, the frame count covers those.
+    auto it = std::remove_if(m_PendingFrees.begin(), m_PendingFrees.end(), [this](PendingFree& pendingFree)
+    {
+        if (m_FrameIndex - pendingFree.frameIndex < kFramesBeforeFree)
+            return false;
+
+        if (m_Timeline != nullptr && !m_Timeline->IsComplete(pendingFree.timelineValue))
+            return false;
+
+        m_GeometryHeap->Free(&pendingFree.allocation);
+        return true;
+    });
+
+    m_PendingFrees.erase(it, m_PendingFrees.end());
+
+    if (m_Device != nullptr)
+    {
+        m_GeometryHeap->GetBuffer()->GarbageCollect(m_FrameIndex, m_Timeline);
+        m_DrawTable.GetRecordBuffer()->GarbageCollect(m_FrameIndex, m_Timeline);
+        m_DrawTable.GetTransformBuffer()->GarbageCollect(m_FrameIndex, m_Timeline);
+    }
+
+    // Drop dedup entries whose range has been destroyed.
+    // Note: Only called outside of sync, so nothing else is touching the table.
+    std::vector<uint64_t> expired;
+
+    for (auto const& entry : m_Ranges)
+    {
+        if (entry.second.expired())
+            expired.push_back(entry.first);
+    }
+
+    for (uint64_t hash : expired)
+        m_Ranges.erase(hash);
+
+    // Same for LOD chains no mesh holds anymore.
+    expired.clear();
+
+    for (auto const& entry : m_LodChains)
+    {
+        if (entry.second.chain.expired())
+            expired.push_back(entry.first);
+    }
+
+    for (uint64_t hash : expired)
+        m_LodChains.erase(hash);
+}
@@ -0,0 +1,396 @@
+#include <ExampleDelegate/ExSoftwareRasterizer.h>
+#include <ExampleDelegate/ExDrawTable.h>
+#include <ExampleDelegate/ExMesh.h>
+#include <ExampleDelegate/ExInstancer.h>
+#include <ExampleDelegate/ExRenderBuffer.h>
+
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define EX_RASTER_SSE 1
+    #include <emmintrin.h>
+#endif
+
+// Tile edge in pixels (a multiple of the SIMD width).
+static constexpr uint32_t kTileSize = 64u;
+
+// Matches the Unlit fragment shader of the device path.
+static const GfVec3f kKeyLightDirection = GfVec3f(0.3f, 0.8f, 0.5f).GetNormalized();
+
+static inline float EvaluatePlane(GfVec3f const& plane, float x, float y)
+{
+    return plane[0] * x + plane[1] * y + plane[2];
+}
+
+static inline GfVec3f PlaneFromVertices(GfVec3f const& edgeA, GfVec3f const& edgeB, GfVec3f const& edgeC, GfVec3f const& values)
+{
+    return GfVec3f(GfDot(edgeA, values), GfDot(edgeB, values), GfDot(edgeC, values));
+}
+
+ExSoftwareRasterizer::ExSoftwareRasterizer() : m_Width(0u), m_Height(0u), m_TileCountX(0u), m_TileCountY(0u)
+{
+}
+
+void ExSoftwareRasterizer::Render(ExDrawTable const&           drawTable,
+                                  std::vector<uint32_t> const& slots,
+                                  GfMatrix4f const&            viewProjection,
+                                  ExSoftwareTarget const&      target)
+{
+    ExRenderBuffer* reference = target.color != nullptr ? target.color : target.depth;
+
+    if (reference == nullptr)
+        return;
+
+    if (target.color != nullptr && target.depth != nullptr &&
+       (target.color->GetWidth() != target.depth->GetWidth() || target.color->GetHeight() != target.depth->GetHeight()))
+    {
+        TF_CODING_ERROR("Software render targets must have matching dimensions.");
+        return;
+    }
+
+    m_Width      = reference->GetWidth();
+    m_Height     = reference->GetHeight();
+    m_TileCountX = (m_Width  + kTileSize - 1u) / kTileSize;
+    m_TileCountY = (m_Height + kTileSize - 1u) / kTileSize;
+
+    if (m_Width == 0u || m_Height == 0u)
+        return;
+
+    // Phase 1: transform, clip and set up the triangles of every mesh.
+    m_Batches.resize(slots.size());
+
+    WorkParallelForN(slots.size(), [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            Batch* batch = &m_Batches[i];
+
+            batch->triangles.clear();
+            batch->minX = batch->minY = INT32_MAX;
+            batch->maxX = batch->maxY = INT32_MIN;
+
+            if (drawTable.GetRecord(slots[i]).indexCount == 0u)
+                continue;
+
+            ExMesh const*     mesh      = drawTable.GetMesh(slots[i]);
+            GfMatrix4f const& transform = drawTable.GetTransform(slots[i]);
+
+            if (!mesh->IsInstanced())
+            {
+                _SetupMesh(mesh, transform, viewProjection, batch);
+                continue;
+            }
+
+            // Instances append to the mesh's batch, the mesh transform applies before each instance.
+            ExInstance const* instances = reinterpret_cast<ExInstance const*>(mesh->GetInstances().cdata());
+
+            for (uint32_t instance = 0u; instance < mesh->GetInstanceCount(); ++instance)
+                _SetupMesh(mesh, transform * ExDecodeInstance(instances[instance]), viewProjection, batch);
+        }
+    });
+
+    // Phase 2: bin triangles into tiles. Each row of tiles is binned by one task in batch order, so bins are deterministic.
+    m_Bins.resize(m_TileCountX * m_TileCountY);
+
+    WorkParallelForN(m_TileCountY, [&](size_t begin, size_t end)
+    {
+        for (size_t tileRow = begin; tileRow < end; ++tileRow)
+            _BinTriangles((uint32_t)tileRow);
+    });
+
+    // Phase 3: rasterize and write out every tile independently.
+    WorkParallelForN(m_TileCountX * m_TileCountY, [&](size_t begin, size_t end)
+    {
+        for (size_t tile = begin; tile < end; ++tile)
+            _RasterizeTile((uint32_t)(tile % m_TileCountX), (uint32_t)(tile / m_TileCountX), target);
+    });
+
+    if (target.color != nullptr)
+        target.color->SetConverged(true);
+
+    if (target.depth != nullptr)
+        target.depth->SetConverged(true);
+}
+
+void ExSoftwareRasterizer::_SetupMesh(ExMesh const* mesh, GfMatrix4f const& objectToWorld, GfMatrix4f const& viewProjection, Batch* batch) const
+{
+    ExMeshGeometry const& geometry = mesh->GetGeometry();
+
+    GfMatrix4f objectToClip = objectToWorld * viewProjection;
+
+    bool vertexNormals = geometry.normals.size() == geometry.positions.size();
+
+    std::vector<ClipVertex> vertices(geometry.positions.size());
+
+    for (size_t i = 0u; i < geometry.positions.size(); ++i)
+    {
+        GfVec3f const& position = geometry.positions[i];
+
+        vertices[i].position = GfVec4f(position[0], position[1], position[2], 1.0f) * objectToClip;
+        vertices[i].normal   = vertexNormals ? objectToWorld.TransformDir(geometry.normals[i]) : GfVec3f(0.0f);
+    }
+
+    for (GfVec3i const& index : geometry.indices)
+    {
+        ClipVertex v0 = vertices[index[0]], v1 = vertices[index[1]], v2 = vertices[index[2]];
+
+        // Without vertex normals, shade flat with the face normal.
+        if (!vertexNormals)
+        {
+            GfVec3f p0 = objectToWorld.Transform(geometry.positions[index[0]]);
+            GfVec3f p1 = objectToWorld.Transform(geometry.positions[index[1]]);
+            GfVec3f p2 = objectToWorld.Transform(geometry.positions[index[2]]);
+
+            v0.normal = v1.normal = v2.normal = GfCross(p1 - p0, p2 - p0);
+        }
+
+        // Clip against the near plane (z >= 0), the other planes are handled by the screen bounds and depth range.
+        ClipVertex input[3] = { v0, v1, v2 };
+        ClipVertex clipped[4];
+        int        clippedCount = 0;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            ClipVertex const& current = input[i];
+            ClipVertex const& next    = input[(i + 1) % 3];
+
+            float dCurrent = current.position[2];
+            float dNext    = next.position[2];
+
+            if (dCurrent >= 0.0f)
+                clipped[clippedCount++] = current;
+
+            if ((dCurrent >= 0.0f) != (dNext >= 0.0f))
+            {
+                float t = dCurrent / (dCurrent - dNext);
+
+                clipped[clippedCount].position = current.position + (next.position - current.position) * t;
+                clipped[clippedCount].normal   = current.normal   + (next.normal   - current.normal)   * t;
+                clippedCount++;
+            }
+        }
+
+        for (int i = 1; i + 1 < clippedCount; ++i)
+            _SetupTriangle(clipped[0], clipped[i], clipped[i + 1], batch);
+    }
+}
+
+void ExSoftwareRasterizer::_SetupTriangle(ClipVertex const& v0, ClipVertex const& v1, ClipVertex const& v2, Batch* batch) const
+{
+    ClipVertex const* v[3] = { &v0, &v1, &v2 };
+
+    GfVec3f sx, sy, sz, invW;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        GfVec4f const& position = v[i]->position;
+
+        if (position[3] <= 1e-8f)
+            return;
+
+        invW[i] = 1.0f / position[3];
+
+        // Row zero is the bottom of the image, matching the device readback.
+        sx[i] = (position[0] * invW[i] * 0.5f + 0.5f) * (float)m_Width;
+        sy[i] = (position[1] * invW[i] * 0.5f + 0.5f) * (float)m_Height;
+        sz[i] =  position[2] * invW[i];
+    }
+
+    // Edge functions, each one is the (unnormalized) barycentric weight of the opposite vertex.
+    GfVec3f edgeA(sy[1] - sy[2], sy[2] - sy[0], sy[0] - sy[1]);
+    GfVec3f edgeB(sx[2] - sx[1], sx[0] - sx[2], sx[1] - sx[0]);
+    GfVec3f edgeC(sx[1] * sy[2] - sx[2] * sy[1], sx[2] * sy[0] - sx[0] * sy[2], sx[0] * sy[1] - sx[1] * sy[0]);
+
+    float area = edgeC[0] + edgeC[1] + edgeC[2];
+
+    if (std::abs(area) < 1e-12f)
+        return;
+
+    // Clamp before converting, vertices close to the eye plane can land far outside the screen.
+    Triangle triangle;
+    triangle.minX = (int)std::floor(std::clamp(std::min({ sx[0], sx[1], sx[2] }), 0.0f, (float)m_Width));
+    triangle.minY = (int)std::floor(std::clamp(std::min({ sy[0], sy[1], sy[2] }), 0.0f, (float)m_Height));
+    triangle.maxX = (int)std::ceil (std::clamp(std::max({ sx[0], sx[1], sx[2] }), -1.0f, (float)m_Width  - 1.0f));
+    triangle.maxY = (int)std::ceil (std::clamp(std::max({ sy[0], sy[1], sy[2] }), -1.0f, (float)m_Height - 1.0f));
+
+    if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+        return;
+
+    // Normalizing by the signed area makes the weights positive inside for either winding (double-sided).
+    float invArea = 1.0f / area;
+
+    triangle.edgeA = edgeA * invArea;
+    triangle.edgeB = edgeB * invArea;
+    triangle.edgeC = edgeC * invArea;
+
+    triangle.depth = PlaneFromVertices(triangle.edgeA, triangle.edgeB, triangle.edgeC, sz);
+    triangle.invW  = PlaneFromVertices(triangle.edgeA, triangle.edgeB, triangle.edgeC, invW);
+
+    for (int c = 0; c < 3; ++c)
+    {
+        GfVec3f normalOverW(v0.normal[c] * invW[0], v1.normal[c] * invW[1], v2.normal[c] * invW[2]);
+        triangle.normal[c] = PlaneFromVertices(triangle.edgeA, triangle.edgeB, triangle.edgeC, normalOverW);
+    }
+
+    batch->minX = std::min(batch->minX, triangle.minX);
+    batch->minY = std::min(batch->minY, triangle.minY);
+    batch->maxX = std::max(batch->maxX, triangle.maxX);
+    batch->maxY = std::max(batch->maxY, triangle.maxY);
+
+    batch->triangles.push_back(triangle);
+}
+
+void ExSoftwareRasterizer::_BinTriangles(uint32_t tileRow)
+{
+    for (uint32_t tileX = 0u; tileX < m_TileCountX; ++tileX)
+        m_Bins[tileRow * m_TileCountX + tileX].clear();
+
+    int rowMinY = (int)(tileRow * kTileSize);
+    int rowMaxY = std::min(rowMinY + (int)kTileSize, (int)m_Height) - 1;
+
+    for (Batch const& batch : m_Batches)
+    {
+        if (batch.triangles.empty() || batch.maxY < rowMinY || batch.minY > rowMaxY)
+            continue;
+
+        for (Triangle const& triangle : batch.triangles)
+        {
+            if (triangle.maxY < rowMinY || triangle.minY > rowMaxY)
+                continue;
+
+            for (int tileX = triangle.minX / (int)kTileSize; tileX <= triangle.maxX / (int)kTileSize; ++tileX)
+                m_Bins[tileRow * m_TileCountX + tileX].push_back(&triangle);
+        }
+    }
+}
+
+void ExSoftwareRasterizer::_RasterizeTile(uint32_t tileX, uint32_t tileY, ExSoftwareTarget const& target) const
+{
+    const int tileMinX = (int)(tileX * kTileSize);
+    const int tileMinY = (int)(tileY * kTileSize);
+    const int tileMaxX = std::min(tileMinX + (int)kTileSize, (int)m_Width)  - 1;
+    const int tileMaxY = std::min(tileMinY + (int)kTileSize, (int)m_Height) - 1;
+
+    std::vector<float> depth(kTileSize * kTileSize, target.clearDepth);
+    std::vector<float> color(kTileSize * kTileSize * 4u);
+
+    for (uint32_t i = 0u; i < kTileSize * kTileSize; ++i)
+        std::copy(target.clearColor.data(), target.clearColor.data() + 4, &color[i * 4u]);
+
+    // Perspective-correct normal, then the same two-sided key light as the device shader.
+    auto Shade = [&](Triangle const& triangle, int x, int y)
+    {
+        float px = (float)x + 0.5f;
+        float py = (float)y + 0.5f;
+
+        float w = 1.0f / EvaluatePlane(triangle.invW, px, py);
+
+        GfVec3f normal(EvaluatePlane(triangle.normal[0], px, py) * w,
+                       EvaluatePlane(triangle.normal[1], px, py) * w,
+                       EvaluatePlane(triangle.normal[2], px, py) * w);
+
+        float light = std::abs(GfDot(normal.GetNormalized(), kKeyLightDirection));
+
+        float* texel = &color[((y - tileMinY) * kTileSize + (x - tileMinX)) * 4u];
+        texel[0] = texel[1] = texel[2] = 0.18f + 0.72f * light;
+        texel[3] = 1.0f;
+    };
+
+    for (Triangle const* triangle : m_Bins[tileY * m_TileCountX + tileX])
+    {
+        int minX = std::max(triangle->minX, tileMinX);
+        int minY = std::max(triangle->minY, tileMinY);
+        int maxX = std::min(triangle->maxX, tileMaxX);
+        int maxY = std::min(triangle->maxY, tileMaxY);
+
+        for (int y = minY; y <= maxY; ++y)
+        {
+            float py = (float)y + 0.5f;
+
+            // Per-row constant part of each plane.
+            float row0     = triangle->edgeB[0] * py + triangle->edgeC[0];
+            float row1     = triangle->edgeB[1] * py + triangle->edgeC[1];
+            float row2     = triangle->edgeB[2] * py + triangle->edgeC[2];
+            float rowDepth = triangle->depth[1] * py + triangle->depth[2];
+
+            float* depthRow = &depth[(y - tileMinY) * kTileSize];
+
+#if EX_RASTER_SSE
+            const __m128 laneOffsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+            const __m128 zero        = _mm_setzero_ps();
+            const __m128 one         = _mm_set1_ps(1.0f);
+            const __m128 spanMin     = _mm_set1_ps((float)minX);
+            const __m128 spanMax     = _mm_set1_ps((float)maxX);
+
+            // Start at the SIMD-aligned column of the tile (the tile row is always a whole number of lanes).
+            for (int x = tileMinX + ((minX - tileMinX) & ~3); x <= maxX; x += 4)
+            {
+                __m128 column = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+                __m128 px     = _mm_add_ps(column, _mm_set1_ps(0.5f));
+
+                __m128 w0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle->edgeA[0]), px), _mm_set1_ps(row0));
+                __m128 w1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle->edgeA[1]), px), _mm_set1_ps(row1));
+                __m128 w2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle->edgeA[2]), px), _mm_set1_ps(row2));
+                __m128 z  = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle->depth[0]), px), _mm_set1_ps(rowDepth));
+
+                __m128 mask = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(w0, zero), _mm_cmpge_ps(w1, zero)), _mm_cmpge_ps(w2, zero));
+                mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(column, spanMin), _mm_cmple_ps(column, spanMax)));
+                mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(z, zero), _mm_cmple_ps(z, one)));
+
+                float* depthTexels = depthRow + (x - tileMinX);
+
+                __m128 previous = _mm_loadu_ps(depthTexels);
+                mask = _mm_and_ps(mask, _mm_cmple_ps(z, previous));
+
+                int lanes = _mm_movemask_ps(mask);
+
+                if (lanes == 0)
+                    continue;
+
+                _mm_storeu_ps(depthTexels, _mm_or_ps(_mm_and_ps(mask, z), _mm_andnot_ps(mask, previous)));
+
+                for (int lane = 0; lane < 4; ++lane)
+                {
+                    if (lanes & (1 << lane))
+                        Shade(*triangle, x + lane, y);
+                }
+            }
+#else
+            for (int x = minX; x <= maxX; ++x)
+            {
+                float px = (float)x + 0.5f;
+
+                if (triangle->edgeA[0] * px + row0 < 0.0f || triangle->edgeA[1] * px + row1 < 0.0f || triangle->edgeA[2] * px + row2 < 0.0f)
+                    continue;
+
+                float z = triangle->depth[0] * px + rowDepth;
+
+                if (z < 0.0f || z > 1.0f || z > depthRow[x - tileMinX])
+                    continue;
+
+                depthRow[x - tileMinX] = z;
+
+                Shade(*triangle, x, y);
+            }
+#endif
+        }
+    }
+
+    // Write the finished tile out, row by row.
+    unsigned int width = (unsigned int)(tileMaxX - tileMinX + 1);
+
+    for (int y = tileMinY; y <= tileMaxY; ++y)
+    {
+        uint32_t row = (uint32_t)(y - tileMinY) * kTileSize;
+
+        if (target.color != nullptr)
+            target.color->WriteRow((unsigned int)tileMinX, (unsigned int)y, width, 4u, &color[row * 4u]);
+
+        if (target.depth != nullptr)
+            target.depth->WriteRow((unsigned int)tileMinX, (unsigned int)y, width, 1u, &depth[row]);
+    }
+}
@@ -0,0 +1,147 @@
+#include <ExampleDelegate/ExTimeline.h>
+
+#include <VulkanWrappers/Device.h>
+using namespace VulkanWrappers;
+
+#include <pxr/base/tf/diagnostic.h>
+#include <pxr/base/trace/trace.h>
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+
+VkResult ExQueueSubmit(VkQueue queue, uint32_t submitCount, VkSubmitInfo const* submits, VkFence fence)
+{
+    // One lock per queue, so delegates on different queues never wait on each other.
+    static std::mutex                                               s_QueueMutexesLock;
+    static std::unordered_map<VkQueue, std::unique_ptr<std::mutex>> s_QueueMutexes;
+
+    std::mutex* queueMutex;
+    {
+        std::lock_guard<std::mutex> lock(s_QueueMutexesLock);
+
+        auto& entry = s_QueueMutexes[queue];
+
+        if (entry == nullptr)
+            entry = std::make_unique<std::mutex>();
+
+        queueMutex = entry.get();
+    }
+
+    std::lock_guard<std::mutex> lock(*queueMutex);
+
+    return vkQueueSubmit(queue, submitCount, submits, fence);
+}
+
+ExTimeline::ExTimeline(Device* device) : m_Device(device), m_Semaphore(VK_NULL_HANDLE), m_SubmittedValue(0u), m_CompletedValue(0u)
+{
+    VkSemaphoreTypeCreateInfo typeInfo = {};
+    typeInfo.sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue  = 0u;
+
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+
+    TF_VERIFY(vkCreateSemaphore(m_Device->GetLogical(), &semaphoreInfo, nullptr, &m_Semaphore) == VK_SUCCESS);
+}
+
+bool ExTimeline::IsSupported(Device* device, VkPhysicalDeviceFeatures2 const* enabledFeatures)
+{
+    // Enabling the feature takes one of these structures in the creation chain.
+    if (enabledFeatures != nullptr)
+    {
+        for (auto next = reinterpret_cast<VkBaseInStructure const*>(enabledFeatures->pNext); next != nullptr; next = next->pNext)
+        {
+            if (next->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES)
+                return reinterpret_cast<VkPhysicalDeviceVulkan12Features const*>(next)->timelineSemaphore == VK_TRUE;
+
+            if (next->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES)
+                return reinterpret_cast<VkPhysicalDeviceTimelineSemaphoreFeatures const*>(next)->timelineSemaphore == VK_TRUE;
+        }
+
+        return false;
+    }
+
+    VmaAllocatorInfo allocatorInfo;
+    vmaGetAllocatorInfo(device->GetAllocator(), &allocatorInfo);
+
+    VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+    vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+    VkPhysicalDeviceFeatures2 features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &vulkan12Features;
+
+    vkGetPhysicalDeviceFeatures2(allocatorInfo.physicalDevice, &features);
+
+    return vulkan12Features.timelineSemaphore == VK_TRUE;
+}
+
+ExTimeline::~ExTimeline()
+{
+    // Everything of ours has to be done before the semaphore can go.
+    WaitIdle();
+
+    vkDestroySemaphore(m_Device->GetLogical(), m_Semaphore, nullptr);
+}
+
+uint64_t ExTimeline::Submit(VkQueue queue, VkSubmitInfo const& submitInfo)
+{
+    TF_VERIFY(submitInfo.signalSemaphoreCount == 0u);
+
+    std::lock_guard<std::mutex> lock(m_SubmitMutex);
+
+    uint64_t value = m_SubmittedValue.load() + 1u;
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+    timelineInfo.sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.pNext                     = submitInfo.pNext;
+    timelineInfo.signalSemaphoreValueCount = 1u;
+    timelineInfo.pSignalSemaphoreValues    = &value;
+
+    // Wait semaphores (if any) must be binary, their values are ignored.
+    VkSubmitInfo timelineSubmit = submitInfo;
+    timelineSubmit.pNext                = &timelineInfo;
+    timelineSubmit.signalSemaphoreCount = 1u;
+    timelineSubmit.pSignalSemaphores    = &m_Semaphore;
+
+    if (!TF_VERIFY(ExQueueSubmit(queue, 1u, &timelineSubmit, VK_NULL_HANDLE) == VK_SUCCESS))
+        return m_SubmittedValue.load();
+
+    m_SubmittedValue.store(value);
+
+    return value;
+}
+
+uint64_t ExTimeline::GetCompletedValue() const
+{
+    uint64_t value = 0u;
+    vkGetSemaphoreCounterValue(m_Device->GetLogical(), m_Semaphore, &value);
+
+    // Values only ever increase, keep the latest one seen.
+    uint64_t completed = m_CompletedValue.load();
+    while (completed < value && !m_CompletedValue.compare_exchange_weak(completed, value)) {}
+
+    return std::max(completed, value);
+}
+
+void ExTimeline::Wait(uint64_t value) const
+{
+    if (value <= m_CompletedValue.load())
+        return;
+
+    TRACE_FUNCTION();
+
+    VkSemaphoreWaitInfo waitInfo = {};
+    waitInfo.sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1u;
+    waitInfo.pSemaphores    = &m_Semaphore;
+    waitInfo.pValues        = &value;
+
+    vkWaitSemaphores(m_Device->GetLogical(), &waitInfo, UINT64_MAX);
+
+    uint64_t completed = m_CompletedValue.load();
+    while (completed < value && !m_CompletedValue.compare_exchange_weak(completed, value)) {}
+}
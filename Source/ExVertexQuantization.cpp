@@ -0,0 +1,221 @@
+#include <ExampleDelegate/ExVertexQuantization.h>
+
+#include <pxr/base/gf/half.h>
+#include <pxr/base/trace/trace.h>
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define EX_QUANTIZE_SSE 1
+    #include <emmintrin.h>
+#endif
+
+#if defined(__F16C__) || defined(__AVX2__)
+    #define EX_QUANTIZE_F16C 1
+    #include <immintrin.h>
+#endif
+
+// Vertices encoded at a time, through a buffer on the stack. A multiple of four, so that every batch of a packed
+// stream starts on a word and the SIMD lanes see the same components in every batch.
+static constexpr size_t kVerticesPerBatch = 256u;
+
+// Bounds minimum and size ahead of quantized positions (see Mesh.vert).
+static constexpr size_t kPositionHeaderWords = 6u;
+
+static size_t BatchCount(size_t vertexCount)
+{
+    return (vertexCount + kVerticesPerBatch - 1u) / kVerticesPerBatch;
+}
+
+// Words of a stream of 16-bit triples, packed two components per word.
+static size_t PackedWordCount(size_t vertexCount)
+{
+    return (3u * vertexCount + 1u) / 2u;
+}
+
+// Kernels
+// ---------------------
+
+// Quantize count floats of xyz triples to 16-bit unorm, component c as (value - minimum[c]) * scale[c].
+static void QuantizeUnorm16(float const* values, size_t count, GfVec3f const& minimum, GfVec3f const& scale, uint16_t* out)
+{
+    size_t i = 0u;
+
+#if EX_QUANTIZE_SSE
+    // Components repeat every twelve floats (four triples, three registers), so each register has fixed lane constants.
+    __m128 minimums[3], scales[3];
+
+    for (uint32_t k = 0u; k < 3u; ++k)
+    {
+        minimums[k] = _mm_setr_ps(minimum[(4u * k) % 3u], minimum[(4u * k + 1u) % 3u], minimum[(4u * k + 2u) % 3u], minimum[(4u * k + 3u) % 3u]);
+        scales[k]   = _mm_setr_ps(scale  [(4u * k) % 3u], scale  [(4u * k + 1u) % 3u], scale  [(4u * k + 2u) % 3u], scale  [(4u * k + 3u) % 3u]);
+    }
+
+    const __m128  zero    = _mm_setzero_ps();
+    const __m128  maximum = _mm_set1_ps(65535.0f);
+    const __m128i bias    = _mm_set1_epi32(32768);
+    const __m128i flip    = _mm_set1_epi16((short)0x8000);
+
+    for (; i + 12u <= count; i += 12u)
+    {
+        __m128i quantized[3];
+
+        for (uint32_t k = 0u; k < 3u; ++k)
+        {
+            __m128 value = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(values + i + 4u * k), minimums[k]), scales[k]);
+            value = _mm_min_ps(_mm_max_ps(value, zero), maximum);
+
+            quantized[k] = _mm_sub_epi32(_mm_cvtps_epi32(value), bias);
+        }
+
+        // SSE2 only packs with signed saturation: biased by -32768 every value is in range, and flipping the
+        // sign bit of the packed result takes the bias back out.
+        __m128i packed01 = _mm_xor_si128(_mm_packs_epi32(quantized[0], quantized[1]), flip);
+        __m128i packed2  = _mm_xor_si128(_mm_packs_epi32(quantized[2], quantized[2]), flip);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed01);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i + 8u), packed2);
+    }
+#endif
+
+    for (; i < count; ++i)
+        out[i] = (uint16_t)std::nearbyint(std::clamp((values[i] - minimum[i % 3u]) * scale[i % 3u], 0.0f, 65535.0f));
+}
+
+static void ConvertHalf(float const* values, size_t count, uint16_t* out)
+{
+    size_t i = 0u;
+
+#if EX_QUANTIZE_F16C
+    for (; i + 4u <= count; i += 4u)
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_cvtps_ph(_mm_loadu_ps(values + i), _MM_FROUND_TO_NEAREST_INT));
+#endif
+
+    for (; i < count; ++i)
+        out[i] = GfHalf(values[i]).bits();
+}
+
+// Project onto the octahedron |x| + |y| + |z| = 1 and fold its lower half over the upper one, which maps the
+// sphere onto the [-1, 1] square with close to uniform precision. Branch-free, so the loop around it vectorizes.
+static inline uint32_t EncodeOctahedral(GfVec3f const& n)
+{
+    float length = std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]);
+
+    // A zero vector lands in the center, which decodes to +Z.
+    float inverse = length > 0.0f ? 1.0f / length : 0.0f;
+
+    float x = n[0] * inverse;
+    float y = n[1] * inverse;
+
+    float foldedX = (1.0f - std::abs(y)) * std::copysign(1.0f, x);
+    float foldedY = (1.0f - std::abs(x)) * std::copysign(1.0f, y);
+
+    bool lower = n[2] < 0.0f;
+
+    x = std::clamp(lower ? foldedX : x, -1.0f, 1.0f) * 32767.0f;
+    y = std::clamp(lower ? foldedY : y, -1.0f, 1.0f) * 32767.0f;
+
+    int16_t qx = (int16_t)(x + (x >= 0.0f ? 0.5f : -0.5f));
+    int16_t qy = (int16_t)(y + (y >= 0.0f ? 0.5f : -0.5f));
+
+    return (uint32_t)(uint16_t)qx | ((uint32_t)(uint16_t)qy << 16u);
+}
+
+// Streams
+// ---------------------
+
+VtUIntArray ExQuantizePositions(VtVec3fArray const& positions, GfRange3f const& bounds)
+{
+    TRACE_FUNCTION();
+
+    const size_t vertexCount = positions.size();
+
+    if (vertexCount == 0u)
+        return VtUIntArray();
+
+    GfVec3f minimum = bounds.IsEmpty() ? GfVec3f(0.0f) : bounds.GetMin();
+    GfVec3f size    = bounds.IsEmpty() ? GfVec3f(0.0f) : bounds.GetSize();
+
+    // An axis without extent quantizes to zero.
+    GfVec3f scale;
+
+    for (uint32_t axis = 0u; axis < 3u; ++axis)
+        scale[axis] = size[axis] > 0.0f ? 65535.0f / size[axis] : 0.0f;
+
+    VtUIntArray   encoded(kPositionHeaderWords + PackedWordCount(vertexCount));
+    unsigned int* words = encoded.data();
+
+    memcpy(words,      minimum.data(), sizeof(GfVec3f));
+    memcpy(words + 3u, size.data(),    sizeof(GfVec3f));
+
+    float const* values = positions.cdata()->data();
+    char*        packed = reinterpret_cast<char*>(words + kPositionHeaderWords);
+
+    WorkParallelForN(BatchCount(vertexCount), [&](size_t begin, size_t end)
+    {
+        uint16_t batch[3u * kVerticesPerBatch];
+
+        for (size_t b = begin; b < end; ++b)
+        {
+            size_t first = b * kVerticesPerBatch;
+            size_t count = std::min(kVerticesPerBatch, vertexCount - first);
+
+            QuantizeUnorm16(values + 3u * first, 3u * count, minimum, scale, batch);
+            memcpy(packed + 6u * first, batch, 6u * count);
+        }
+    });
+
+    return encoded;
+}
+
+VtUIntArray ExEncodeNormals(VtVec3fArray const& normals)
+{
+    TRACE_FUNCTION();
+
+    VtUIntArray    encoded(normals.size());
+    unsigned int*  words  = encoded.data();
+    GfVec3f const* source = normals.cdata();
+
+    WorkParallelForN(normals.size(), [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            words[i] = EncodeOctahedral(source[i]);
+    });
+
+    return encoded;
+}
+
+VtUIntArray ExEncodeHalf3(VtVec3fArray const& values)
+{
+    TRACE_FUNCTION();
+
+    const size_t vertexCount = values.size();
+
+    if (vertexCount == 0u)
+        return VtUIntArray();
+
+    VtUIntArray encoded(PackedWordCount(vertexCount));
+
+    float const* source = values.cdata()->data();
+    char*        packed = reinterpret_cast<char*>(encoded.data());
+
+    WorkParallelForN(BatchCount(vertexCount), [&](size_t begin, size_t end)
+    {
+        uint16_t batch[3u * kVerticesPerBatch];
+
+        for (size_t b = begin; b < end; ++b)
+        {
+            size_t first = b * kVerticesPerBatch;
+            size_t count = std::min(kVerticesPerBatch, vertexCount - first);
+
+            ConvertHalf(source + 3u * first, 3u * count, batch);
+            memcpy(packed + 6u * first, batch, 6u * count);
+        }
+    });
+
+    return encoded;
+}
@@ -0,0 +1,96 @@
+#ifndef BOUNDS_HIERARCHY
+#define BOUNDS_HIERARCHY
+
+#include "PxrUsage.h"
+
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+class ExDrawTable;
+
+/// \struct ExFrustum
+///
+/// Six clip planes in world space, with the inside on the positive side.
+///
+struct ExFrustum
+{
+    enum Containment
+    {
+        Outside,
+        Intersecting,
+        Inside
+    };
+
+    /// Extract the planes from a (row-vector) world-to-clip matrix with [0, 1] clip depth.
+    static ExFrustum FromViewProjection(GfMatrix4f const& viewProjection);
+
+    /// Classify a world-space box against the planes.
+    Containment Classify(GfRange3f const& bounds) const;
+
+    GfVec4f planes[6];
+};
+
+/// \class ExBoundsHierarchy
+///
+/// Bounding volume hierarchy over the world-space bounds of every draw table slot. It is built with
+/// median splits and refit in place as slots change, and only rebuilt when slots are added or the
+/// refits have touched enough of the tree that its quality has likely degraded.
+///
+/// Note: Updated at commit time and read-only during render, so traversal is thread-safe.
+///
+class ExBoundsHierarchy
+{
+public:
+    ExBoundsHierarchy();
+
+    /// Bring the hierarchy up to date with the draw table.
+    ///   \param dirtySlots Slots whose bounds changed since the last update.
+    void Update(ExDrawTable const& drawTable, std::vector<uint32_t> const& dirtySlots);
+
+    /// Collect the slots whose bounds intersect the frustum, traversing subtrees in parallel.
+    ///   \param visible Receives the surviving slots in ascending order.
+    void Cull(ExFrustum const& frustum, std::vector<uint32_t>* visible) const;
+
+    inline uint32_t GetSlotCount() const { return m_SlotCount; }
+
+private:
+
+    struct Node
+    {
+        GfRange3f bounds;
+
+        // Leaf: first item in m_Items. Internal: left child (the right child is always first + 1).
+        uint32_t first;
+
+        // Number of items in a leaf, zero for internal nodes.
+        uint32_t count;
+    };
+
+    void _Build(ExDrawTable const& drawTable);
+
+    uint32_t _BuildRecursive(uint32_t parent, uint32_t begin, uint32_t end, std::vector<GfVec3f> const& centroids);
+
+    void _Refit(ExDrawTable const& drawTable, std::vector<uint32_t> const& dirtySlots);
+
+    void _CullSubtree(ExFrustum const& frustum, uint32_t nodeIndex, bool inside, std::vector<uint32_t>* visible) const;
+
+    void _CollectSubtree(uint32_t nodeIndex, std::vector<uint32_t>* visible) const;
+
+    std::vector<Node>     m_Nodes;
+    std::vector<uint32_t> m_Parents;
+
+    // Slot per leaf item, and the leaf holding each slot.
+    std::vector<uint32_t> m_Items;
+    std::vector<uint32_t> m_LeafOfSlot;
+
+    // Bounds of each slot at the last update (the leaf items only store the slot).
+    std::vector<GfRange3f> m_SlotBounds;
+
+    uint32_t m_SlotCount;
+
+    // Slots refit since the last build.
+    uint32_t m_RefitCount;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef CAMERA
+#define CAMERA
+
+#include "PxrUsage.h"
+
+#include <pxr/imaging/hd/camera.h>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+/// \class ExCamera
+///
+/// Camera sprim. Caches its view and (unconformed) projection matrices at sync, and counts its
+/// changes so that render passes only rebuild their view when something actually moved.
+///
+class ExCamera final : public HdCamera
+{
+public:
+    ExCamera(SdfPath const& id);
+    ~ExCamera() override = default;
+
+    /// Sync the camera parameters and refresh the cached matrices if any of them changed.
+    void Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam, HdDirtyBits* dirtyBits) override;
+
+    inline GfMatrix4d const& GetWorldToView() const { return m_WorldToView; }
+
+    inline GfMatrix4d const& GetProjection() const { return m_Projection; }
+
+    /// Incremented whenever the camera changes.
+    inline uint64_t GetVersion() const { return m_Version; }
+
+private:
+    GfMatrix4d m_WorldToView;
+    GfMatrix4d m_Projection;
+    uint64_t   m_Version;
+};
+
+/// Subpixel offset of a jitter sample, in pixels within [-0.5, 0.5). Follows the Halton (2, 3) sequence,
+/// which covers the pixel evenly for any number of leading samples.
+GfVec2f ExComputeJitter(uint32_t sampleIndex);
+
+/// Offset a (row-vector) projection by a subpixel amount on a target of the provided size.
+GfMatrix4d ExApplyJitter(GfMatrix4d const& projection, GfVec2f const& jitter, uint32_t width, uint32_t height);
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef CULLER
+#define CULLER
+
+#include "PxrUsage.h"
+#include "ExBoundsHierarchy.h"
+
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+class ExDrawTable;
+class ExMesh;
+
+/// \class ExCuller
+///
+/// Per-pass visibility stage that runs ahead of command recording. Slots are first culled against
+/// the view frustum through the bounds hierarchy, then (optionally) against a coarse depth buffer
+/// that the largest on-screen meshes are rasterized into on the CPU.
+///
+class ExCuller
+{
+public:
+    ExCuller();
+
+    /// Compute the slots that need drawing for a view.
+    ///   \param occlusion Also reject slots hidden behind the largest occluders.
+    ///   \param visible Receives the surviving slots in ascending order.
+    void Cull(ExBoundsHierarchy const& hierarchy,
+              ExDrawTable const&       drawTable,
+              GfMatrix4f const&        viewProjection,
+              float                    aspectRatio,
+              bool                     occlusion,
+              std::vector<uint32_t>*   visible);
+
+private:
+
+    // Screen-space rectangle (in depth buffer pixels) and nearest depth of a projected box.
+    struct ScreenBounds
+    {
+        float minX, minY, maxX, maxY;
+        float minDepth;
+
+        // The box crosses the near plane, so it can't be projected (treat as covering the screen).
+        bool clipped;
+    };
+
+    ScreenBounds _ProjectBounds(GfRange3f const& bounds, GfMatrix4f const& viewProjection) const;
+
+    void _RasterizeOccluder(ExMesh const* mesh, GfMatrix4f const& objectToClip);
+
+    bool _IsOccluded(ScreenBounds const& screenBounds) const;
+
+    uint32_t m_Width;
+    uint32_t m_Height;
+
+    // Coarse depth buffer with [0, 1] clip depth, cleared to the far plane.
+    std::vector<float> m_Depth;
+
+    std::vector<uint32_t>     m_FrustumVisible;
+    std::vector<ScreenBounds> m_ScreenBounds;
+};
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef DRAW_TABLE
+#define DRAW_TABLE
+
+#include "PxrUsage.h"
+#include "ExGrowableBuffer.h"
+
+#include <tbb/concurrent_queue.h>
+
+#include <mutex>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+class ExMesh;
+
+/// \struct ExDrawRecord
+///
+/// Per-draw record, mirrored 1:1 in a GPU buffer (std430) and indexed in the vertex shader by the
+/// draw slot of the instance being drawn. Offsets are in elements into the geometry heap.
+///
+struct ExDrawRecord
+{
+    uint32_t positionOffset;
+    uint32_t normalOffset;
+    uint32_t colorOffset;
+    uint32_t firstIndex;
+
+    // Zero if the slot is empty, invisible or not yet resident.
+    uint32_t indexCount;
+
+    // Hydra prim id written to the primId AOV (-1 for an empty slot).
+    int32_t primId;
+
+    // Run of the draw's instances in the heap, in instances (see ExInstance).
+    uint32_t firstInstance;
+    uint32_t instanceCount;
+};
+
+static_assert(sizeof(ExDrawRecord) == 32u, "Draw record must match the shader layout.");
+
+/// Sentinel for a stream that the mesh doesn't have.
+static constexpr uint32_t kInvalidDrawOffset = UINT32_MAX;
+
+/// Features the mesh shaders are specialized for, one bit each. Bit N is specialization constant N of
+/// Mesh.vert / Unlit.frag, so every combination is its own pipeline without any per-vertex or per-pixel
+/// branch on the feature.
+static constexpr uint32_t kMeshFeatureNormals      = 1u << 0;
+static constexpr uint32_t kMeshFeatureVertexColors = 1u << 1;
+static constexpr uint32_t kMeshFeatureInstanced    = 1u << 2;
+static constexpr uint32_t kMeshFeatureQuantized    = 1u << 3;
+
+static constexpr uint32_t kMeshFeatureCount = 4u;
+
+/// Number of mesh shader variants, indexed by feature mask.
+static constexpr uint32_t kMeshVariantCount = 1u << kMeshFeatureCount;
+
+/// Levels of detail a draw can have, the full-detail mesh included.
+static constexpr uint32_t kMaxDrawLods = 4u;
+
+/// \struct ExDrawLods
+///
+/// Index ranges of a draw's levels of detail, level 0 being the record's own. Levels share the draw's
+/// vertex streams, so picking one only changes the indirect command (host-only, nothing on the GPU).
+///
+struct ExDrawLods
+{
+    uint32_t firstIndex[kMaxDrawLods];
+    uint32_t indexCount[kMaxDrawLods];
+
+    // Object-space error each level introduces (zero for level 0).
+    float error[kMaxDrawLods];
+
+    // Resident levels, zero if the draw has nothing to draw.
+    uint32_t count;
+};
+
+/// \class ExDrawTable
+///
+/// Table of every drawable rprim in the delegate. Each mesh owns a slot for its lifetime, and the
+/// slot index is what the GPU uses to find the mesh's geometry and transform. Slots are only
+/// resolved (and uploaded) at commit time for meshes that flagged a change during sync.
+///
+class ExDrawTable
+{
+public:
+    /// Create a table, a null device keeps it host-only (no GPU buffers).
+    ExDrawTable(VulkanWrappers::Device* device);
+
+    /// Reserve a slot for a mesh. Thread-safe.
+    uint32_t AcquireSlot(ExMesh* mesh);
+
+    /// Return a slot, the draw is removed on the next commit. Thread-safe.
+    void ReleaseSlot(uint32_t slot);
+
+    /// Flag a slot for re-resolve on the next commit. Thread-safe (lock-free).
+    void MarkDirty(uint32_t slot);
+
+    /// Flag a slot whose transform alone changed, only its transform and bounds are updated. Thread-safe (lock-free).
+    void MarkTransformDirty(uint32_t slot);
+
+    /// Re-resolve dirty slots from their meshes.
+    ///   \param dirtySlots Receives the (sorted, unique) resolved slots, whose transforms (and bounds) changed.
+    ///   \param dirtyRecords Receives the (sorted, unique) subset whose records changed as well.
+    void Resolve(std::vector<uint32_t>* dirtySlots, std::vector<uint32_t>* dirtyRecords);
+
+    inline uint32_t GetSlotCount() const { return (uint32_t)m_Meshes.size(); }
+
+    inline ExMesh* GetMesh(uint32_t slot) const { return m_Meshes[slot]; }
+
+    inline ExDrawRecord const& GetRecord(uint32_t slot) const { return m_Records[slot]; }
+
+    /// Levels of detail of the slot.
+    inline ExDrawLods const& GetLods(uint32_t slot) const { return m_Lods[slot]; }
+
+    /// Feature mask (see kMeshFeatureNormals) of the shader variant the slot is drawn with.
+    inline uint32_t GetFeatures(uint32_t slot) const { return m_Features[slot]; }
+
+    inline GfMatrix4f const& GetTransform(uint32_t slot) const { return m_Transforms[slot]; }
+
+    /// World-space bounds of the slot, empty if there is nothing to draw.
+    inline GfRange3f const& GetBounds(uint32_t slot) const { return m_Bounds[slot]; }
+
+    inline ExGrowableBuffer* GetRecordBuffer()    { return &m_RecordBuffer;    }
+    inline ExGrowableBuffer* GetTransformBuffer() { return &m_TransformBuffer; }
+
+private:
+
+    // Fill a record from the mesh's resident heap ranges.
+    void _ResolveDeviceRecord(ExMesh const* mesh, ExDrawRecord* record) const;
+
+    // Fill the levels of detail from the record and the mesh's resident LOD ranges.
+    void _ResolveLods(ExMesh const* mesh, ExDrawRecord const& record, ExDrawLods* lods) const;
+
+    // Features of a resolved record, i.e. which of its streams the shaders have to read.
+    static uint32_t _ResolveFeatures(ExMesh const* mesh, ExDrawRecord const& record);
+
+    // Fill a record for a mesh drawn from its CPU geometry (no device).
+    void _ResolveHostRecord(ExMesh const* mesh, ExDrawRecord* record) const;
+
+    // World-space bounds of a drawable slot from its mesh and transform.
+    void _ResolveBounds(uint32_t slot, ExMesh const* mesh);
+
+    std::mutex m_SlotMutex;
+
+    // CPU mirrors, indexed by slot.
+    std::vector<ExMesh*>      m_Meshes;
+    std::vector<ExDrawRecord> m_Records;
+    std::vector<uint32_t>     m_Features;
+    std::vector<ExDrawLods>   m_Lods;
+    std::vector<GfMatrix4f>   m_Transforms;
+    std::vector<GfRange3f>    m_Bounds;
+    std::vector<uint32_t>     m_FreeSlots;
+
+    tbb::concurrent_queue<uint32_t> m_DirtySlots;
+    tbb::concurrent_queue<uint32_t> m_DirtyTransforms;
+
+    // Per-resolve scratch.
+    std::vector<uint32_t> m_TransformScratch;
+
+    ExGrowableBuffer m_RecordBuffer;
+    ExGrowableBuffer m_TransformBuffer;
+
+    // Without a device the table is only used for culling and software rasterization.
+    bool m_HostOnly;
+};
+
+#endif
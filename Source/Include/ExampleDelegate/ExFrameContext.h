@@ -0,0 +1,300 @@
+#ifndef FRAME_CONTEXT
+#define FRAME_CONTEXT
+
+#include "PxrUsage.h"
+#include "ExDrawTable.h"
+
+#include <vulkan/vulkan.h>
+
+#include <tbb/enumerable_thread_specific.h>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace VulkanWrappers
+{
+    class Device;
+    class Buffer;
+}
+
+class ExRenderTargetPool;
+class ExRenderStats;
+class ExTimeline;
+class ExPipelineCache;
+
+/// \class ExFrameContext
+///
+/// Device state shared by the render passes of one delegate: the pipelines (compiled through the delegate's
+/// pipeline cache), and the resources of every
+/// frame in flight (command buffers, readback staging, indirect draws, timestamp queries,
+/// per-thread recording pools, and the GL interop objects).
+///
+/// Every delegate owns its own context, so several delegates (two viewports, or a background render
+/// next to an interactive one) never share mutable state. Passes of one delegate hold the context lock
+/// for the duration of an execute.
+///
+class ExFrameContext
+{
+public:
+    /// Frames that may be in flight. Allows up to (N - 1) frames of readback latency on the manual-submit path,
+    /// so the copy-out of frame N can overlap the rendering of frame N + 1. On the application-submit path the
+    /// application has to have completed frame N - kFrameCount by the time it hands over frame N.
+    static constexpr uint32_t kFrameCount = 3u;
+
+    /// Host frame index of the manual-submit path, where our own timeline tracks completion instead.
+    static constexpr uint64_t kNoHostFrame = UINT64_MAX;
+
+    /// Timestamps written by each frame: rendering begin / end, copy-out begin / end.
+    static constexpr uint32_t kTimestampsPerFrame = 4u;
+
+    /// Pixel-unpack buffers that stream readback memory into the GL backbuffer. Cycling through several
+    /// lets the driver DMA frame N into the texture while we fill the buffer for frame N + 1.
+    static constexpr uint32_t kPixelUnpackRingSize = 3u;
+
+    static constexpr VkFormat kDepthFormat        = VK_FORMAT_D32_SFLOAT;
+    static constexpr VkFormat kPrimIdFormat       = VK_FORMAT_R32_SINT;
+
+    /// Running average of jittered samples. Kept in half floats: 8-bit color would band long before the
+    /// average converges, and the format blends and blits everywhere.
+    static constexpr VkFormat kAccumulationFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+    /// Command buffer and readback staging of a frame on the manual-submit path.
+    struct ReadbackFrame
+    {
+        VkCommandBuffer         cmd     = VK_NULL_HANDLE;
+        VulkanWrappers::Buffer* staging = nullptr;
+        VkExtent2D              extent  = { 0u, 0u };
+        uint64_t                frameID = 0u;
+
+        // Timeline value signaled by the frame's submission (zero before the first one).
+        uint64_t timelineValue = 0u;
+
+        // Persistent host mapping of the staging memory (valid for the lifetime of the buffer).
+        void* mapped = nullptr;
+
+        // Submitted to the queue but not yet read back / presented.
+        bool pending = false;
+    };
+
+    /// Per-frame draw resources. The indirect commands are rebuilt every frame, so each frame in flight
+    /// needs its own copy.
+    struct DrawFrame
+    {
+        VulkanWrappers::Buffer* indirect         = nullptr;
+        VkDeviceSize            indirectCapacity = 0u;
+        void*                   mapped           = nullptr;
+
+        VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+        VkDescriptorSet  descriptorSet  = VK_NULL_HANDLE;
+
+        // Null when the graphics queue doesn't support timestamps.
+        VkQueryPool timestampPool     = VK_NULL_HANDLE;
+        bool        timestampsWritten = false;
+
+        // Position in the pool (selects the per-thread recording pools), and a unique ID per use.
+        uint32_t slot    = 0u;
+        uint64_t frameID = UINT64_MAX;
+
+        // What the last use was submitted under: our timeline value, or the application's frame index.
+        uint64_t timelineValue = 0u;
+        uint64_t hostFrame     = kNoHostFrame;
+
+        // Versions of the bound buffers, the set is rewritten when any of them is reallocated.
+        uint64_t heapVersion      = UINT64_MAX;
+        uint64_t instanceVersion  = UINT64_MAX;
+        uint64_t recordVersion    = UINT64_MAX;
+        uint64_t transformVersion = UINT64_MAX;
+    };
+
+    /// Meshes are drawn with vertex pulling from the geometry heap, which needs a descriptor set and push constants.
+    /// Neither is exposed through the wrapper's shader objects, so this path owns regular graphics pipelines, one
+    /// per shader variant. Variants share the layout, so switching between them keeps every binding.
+    struct MeshPipeline
+    {
+        VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+        VkPipelineLayout      pipelineLayout      = VK_NULL_HANDLE;
+
+        // Indexed by feature mask (see kMeshFeatureNormals).
+        VkPipeline variants[kMeshVariantCount] = {};
+
+        // Attachment format the pipeline (and any secondary command buffers) render to.
+        VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+
+        // Whether every draw can be issued with one indirect command (the feature is enabled on the device).
+        bool     multiDrawIndirect    = false;
+        uint32_t maxDrawIndirectCount = 1u;
+    };
+
+    /// A fullscreen pass reads the new sample and blends it into the accumulation target with the blend
+    /// constants as weights, i.e. average = sample * (1 / n) + average * (1 - 1 / n).
+    struct AccumulationPipeline
+    {
+        VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+        VkPipelineLayout      pipelineLayout      = VK_NULL_HANDLE;
+        VkPipeline            pipeline            = VK_NULL_HANDLE;
+        VkSampler             sampler             = VK_NULL_HANDLE;
+    };
+
+    /// Starts compiling the pipelines in the background.
+    ///   \param multiDrawIndirect Whether the device was created with the multiDrawIndirect feature enabled.
+    ExFrameContext(VulkanWrappers::Device* device, ExRenderTargetPool* pool, ExTimeline* timeline, ExPipelineCache* pipelineCache, bool multiDrawIndirect);
+
+    /// Waits for the delegate's submissions only. On the application-submit path the application has to
+    /// have retired the frames it was handed before the delegate is destroyed.
+    ~ExFrameContext();
+
+    /// Held by a pass for as long as it uses the context.
+    inline std::mutex& GetMutex() { return m_Mutex; }
+
+    /// Blocks until the background compilation is done, on first use only.
+    MeshPipeline const& GetMeshPipeline();
+
+    AccumulationPipeline const& GetAccumulationPipeline();
+
+    // Frames
+    // ---------------------
+
+    /// Take a draw frame no submission uses anymore, adding one when every frame is still in flight.
+    ///   \param hostFrame Index of the application's frame on the application-submit path (the application
+    ///                    must have completed frame hostFrame - kFrameCount), kNoHostFrame otherwise.
+    DrawFrame* AcquireDrawFrame(uint64_t hostFrame);
+
+    /// Mark a draw frame as submitted (manual-submit path only).
+    ///   \param timelineValue Value signaled by the frame's submission.
+    void SubmitDrawFrame(DrawFrame* drawFrame, uint64_t timelineValue);
+
+    /// ID the next submitted readback frame will get.
+    inline uint64_t GetReadbackFrameCount() const { return m_ReadbackFrameCount; }
+
+    inline ReadbackFrame* GetReadbackFrame(uint64_t frameID) { return &m_ReadbackRing[frameID % kFrameCount]; }
+
+    /// Take the slot of the next readback frame, once the submission that last used it has completed.
+    ReadbackFrame* AcquireReadbackFrame();
+
+    /// Mark a readback frame as submitted.
+    ///   \param timelineValue Value signaled by the frame's submission.
+    ///   \param pending       Whether it still has to be read back and presented.
+    void SubmitReadbackFrame(ReadbackFrame* readback, uint64_t timelineValue, bool pending);
+
+    /// Destroy a descriptor pool once no frame in flight can reference it anymore.
+    void RetireDescriptorPool(VkDescriptorPool descriptorPool);
+
+    /// Ensure the frame's staging memory can hold a frame of the provided extent.
+    void ResizeReadbackStaging(ReadbackFrame* readback, VkExtent2D extent);
+
+    /// Secondary command buffer for the calling thread, recycled once the draw frame is acquired again.
+    VkCommandBuffer AcquireSecondaryCommandBuffer(DrawFrame const* drawFrame);
+
+    // GPU Timing
+    // ---------------------
+
+    /// Reset the frame's queries (outside of any rendering scope).
+    void ResetTimestamps(VkCommandBuffer cmd, DrawFrame* drawFrame);
+
+    /// Record one of the frame's timestamps, once the preceding work has completed.
+    void WriteTimestamp(VkCommandBuffer cmd, DrawFrame const* drawFrame, uint32_t index, VkPipelineStageFlagBits stage);
+
+    /// Mark the frame's timestamps as written by a submission.
+    void SubmitTimestamps(DrawFrame* drawFrame);
+
+    /// Publish the GPU times of the last submission that used the frame, if they are available.
+    void ReadTimestamps(DrawFrame* drawFrame, ExRenderStats* stats);
+
+    // GL Interop
+    // ---------------------
+
+    /// Create the GL objects on first use, with the application's GL context current.
+    void CreateGLObjects();
+
+    /// Stream a completed readback into the GL backbuffer.
+    void UploadGLBackbuffer(ReadbackFrame* readback);
+
+    /// Present the most recent readback still in flight, dropping any older ones.
+    void PresentLatestReadback();
+
+    /// Blit the GL backbuffer into the host's framebuffer.
+    void BlitGLBackbuffer();
+
+private:
+
+    // Per-thread command pools, one per draw frame (pools can't be used from more than one thread).
+    struct ThreadRecorder
+    {
+        struct FramePool
+        {
+            VkCommandPool                pool      = VK_NULL_HANDLE;
+            std::vector<VkCommandBuffer> buffers;
+            uint32_t                     usedCount = 0u;
+            uint64_t                     frameID   = UINT64_MAX;
+        };
+
+        // Indexed by draw frame slot, grown as frames are added.
+        std::vector<FramePool> framePools;
+    };
+
+    void _CreateMeshPipeline(VkFormat colorFormat, bool multiDrawIndirect);
+    void _CreateAccumulationPipeline();
+    void _CompileMeshPipeline(VkFormat colorFormat, uint32_t features);
+    void _CompileAccumulationPipeline();
+    void _WaitForPipelines();
+    DrawFrame* _CreateDrawFrame();
+    bool _IsDrawFrameIdle(DrawFrame const& drawFrame) const;
+    void _ResizeGLObjects(VkExtent2D extent);
+    void _DestroyRetiredDescriptorPools(bool all);
+
+    // A descriptor pool waiting for the frames that may use it to complete.
+    struct RetiredDescriptorPool
+    {
+        VkDescriptorPool descriptorPool;
+        uint64_t         timelineValue;
+        uint64_t         hostFrame;
+    };
+
+    VulkanWrappers::Device* m_Device;
+    ExRenderTargetPool*     m_Pool;
+    ExTimeline*             m_Timeline;
+    ExPipelineCache*        m_PipelineCache;
+
+    std::mutex m_Mutex;
+
+    MeshPipeline         m_MeshPipeline;
+    AccumulationPipeline m_AccumulationPipeline;
+
+    // Set once the background compilation of the pipelines has been waited on.
+    std::atomic<bool> m_PipelinesReady;
+
+    // Queue family the recording pools allocate for. The wrapper doesn't expose it, so take the first graphics family (as the wrapper does).
+    uint32_t m_GraphicsQueueFamily;
+
+    ReadbackFrame m_ReadbackRing[kFrameCount];
+    uint64_t      m_ReadbackFrameCount;
+
+    // Pointers to the frames stay valid as the pool grows.
+    std::deque<DrawFrame> m_DrawFrames;
+    uint64_t              m_DrawFrameCount;
+
+    // Latest frame index the application handed over (kNoHostFrame on the manual-submit path).
+    uint64_t m_HostFrame;
+
+    std::vector<RetiredDescriptorPool> m_RetiredDescriptorPools;
+
+    tbb::enumerable_thread_specific<ThreadRecorder> m_ThreadRecorders;
+
+    // Nanoseconds per timestamp tick, zero when the graphics queue doesn't support timestamps.
+    double m_TimestampPeriod;
+
+    // GL backbuffer the readbacks are uploaded into, and the unpack buffers streaming them.
+    bool         m_GLCreated;
+    unsigned int m_GLBackbufferImage;
+    unsigned int m_GLBackbufferObject;
+    VkExtent2D   m_GLBackbufferExtent;
+    unsigned int m_GLPixelUnpackBuffers[kPixelUnpackRingSize];
+    uint32_t     m_GLPixelUnpackIndex;
+    VkExtent2D   m_GLStorageExtent;
+};
+
+#endif
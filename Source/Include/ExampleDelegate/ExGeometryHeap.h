@@ -0,0 +1,53 @@
+#ifndef GEOMETRY_HEAP
+#define GEOMETRY_HEAP
+
+#include "ExGrowableBuffer.h"
+
+#include <map>
+
+/// \struct ExGeometryAllocation
+///
+/// A sub-allocated range of the geometry heap.
+///
+struct ExGeometryAllocation
+{
+    VkDeviceSize offset = UINT64_MAX;
+    VkDeviceSize size   = 0u;
+
+    inline bool IsValid() const { return offset != UINT64_MAX; }
+};
+
+/// \class ExGeometryHeap
+///
+/// A single large device buffer that every geometry stream (vertex and index data alike) is
+/// sub-allocated from, so that drawing never has to rebind buffers between meshes. The heap
+/// grows by reallocation when it runs out of space, offsets of existing ranges are unaffected.
+///
+/// Note: Not thread-safe, allocation only happens during resource commit.
+///
+class ExGeometryHeap
+{
+public:
+    ExGeometryHeap(VulkanWrappers::Device* device, VkBufferUsageFlags usage, VkDeviceSize initialSize);
+
+    /// Sub-allocate a range (first fit), growing the heap if no free range fits it.
+    void Allocate(VkDeviceSize size, VkDeviceSize alignment, ExGeometryAllocation* allocation);
+
+    /// Return a range to the heap.
+    void Free(ExGeometryAllocation* allocation);
+
+    /// Accessor for the backing buffer.
+    inline ExGrowableBuffer* GetBuffer() { return &m_Buffer; }
+
+private:
+
+    // Insert a free range, merging it with its neighbours.
+    void _InsertFreeRange(VkDeviceSize offset, VkDeviceSize size);
+
+    ExGrowableBuffer m_Buffer;
+
+    // Offset -> size of each free range.
+    std::map<VkDeviceSize, VkDeviceSize> m_FreeRanges;
+};
+
+#endif
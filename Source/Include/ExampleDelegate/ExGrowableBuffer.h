@@ -0,0 +1,70 @@
+#ifndef GROWABLE_BUFFER
+#define GROWABLE_BUFFER
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+namespace VulkanWrappers
+{
+    class Device;
+    class Buffer;
+}
+
+class ExTimeline;
+
+/// \class ExGrowableBuffer
+///
+/// A device-local buffer that grows by reallocation. When it grows, the previous contents are
+/// carried over with a GPU copy and the old buffer is retired until the GPU is done with it.
+///
+/// Note: Not thread-safe, only used during resource commit.
+///
+class ExGrowableBuffer
+{
+public:
+    ExGrowableBuffer(VulkanWrappers::Device* device, VkBufferUsageFlags usage);
+    ~ExGrowableBuffer();
+
+    /// Ensure the buffer holds at least the given size (grows geometrically).
+    void Reserve(VkDeviceSize size);
+
+    /// Record the copy of the previous contents into a reallocated buffer, if a Reserve() grew it.
+    ///   \return True if a copy was recorded.
+    bool RecordGrowth(VkCommandBuffer cmd);
+
+    /// Free buffers retired by growth once the GPU can no longer be using them.
+    ///   \param timeline Timeline of the submissions that may reference the buffers.
+    void GarbageCollect(uint64_t frameIndex, ExTimeline const* timeline);
+
+    inline VulkanWrappers::Buffer* Get() const { return m_Buffer; }
+
+    inline VkDeviceSize GetSize() const { return m_Size; }
+
+    /// Incremented every time the underlying buffer changes (i.e. descriptors must be rewritten).
+    inline uint64_t GetVersion() const { return m_Version; }
+
+private:
+
+    struct RetiredBuffer
+    {
+        VulkanWrappers::Buffer* buffer;
+        uint64_t                frameIndex;
+        uint64_t                timelineValue;
+    };
+
+    VulkanWrappers::Device* m_Device;
+    VkBufferUsageFlags      m_Usage;
+
+    VulkanWrappers::Buffer* m_Buffer;
+    VkDeviceSize            m_Size;
+    uint64_t                m_Version;
+
+    // Previous buffer whose contents still need to be copied into the current one.
+    VulkanWrappers::Buffer* m_GrowthSource;
+    VkDeviceSize            m_GrowthSourceSize;
+
+    std::vector<RetiredBuffer> m_Retired;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef INSTANCER
+#define INSTANCER
+
+#include "PxrUsage.h"
+
+#include <pxr/imaging/hd/instancer.h>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+/// \struct ExInstance
+///
+/// Quantized per-instance transform, mirrored 1:1 in the geometry heap (std430) and indexed in the
+/// vertex shader by the instance index. Every draw's instances are one contiguous run in the heap, so
+/// the draw's firstInstance is simply the run's offset in instances.
+///
+struct ExInstance
+{
+    float translation[3];
+
+    // Draw slot the instance belongs to, which is how the shader finds the draw record.
+    uint32_t drawSlot;
+
+    // Rotation quaternion (x, y, z, w), snorm16.
+    uint32_t rotation[2];
+
+    // Scale (x, y, z), half floats. The fourth half is unused.
+    uint32_t scale[2];
+};
+
+static_assert(sizeof(ExInstance) == 32u, "Instance must match the shader layout.");
+
+/// Instances are registered with the heap as raw words.
+static constexpr size_t kInstanceWords = sizeof(ExInstance) / sizeof(uint32_t);
+
+/// Quantize a (row-vector) transform into translation, rotation and scale. Shear can't be represented and is dropped.
+ExInstance ExEncodeInstance(GfMatrix4d const& transform, uint32_t drawSlot);
+
+/// Expand a quantized instance back into a (row-vector) transform.
+GfMatrix4f ExDecodeInstance(ExInstance const& instance);
+
+/// \class ExInstancer
+///
+/// Hydra instancer (e.g. a USD PointInstancer). Stores the per-instance primvars of its own level,
+/// and flattens them with those of any parent instancers when a prototype asks for its instances.
+///
+class ExInstancer final : public HdInstancer
+{
+public:
+    ExInstancer(HdSceneDelegate* delegate, SdfPath const& id);
+    ~ExInstancer() override = default;
+
+    /// Pull the instancer transform and the dirty per-instance primvars.
+    void Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam, HdDirtyBits* dirtyBits) override;
+
+    /// Quantized, flattened instances of a prototype (nested instancers multiply out), ready for the heap.
+    /// Thread-safe once synced, prototypes of the same instancer compute theirs in parallel.
+    ///   \param drawSlot Draw slot of the prototype, stored in every instance.
+    ///   \return kInstanceWords words per instance.
+    VtUIntArray ComputeInstances(SdfPath const& prototypeId, uint32_t drawSlot) const;
+
+    /// Flattened (row-vector) transforms of a prototype's instances, including those of parent instancers.
+    VtMatrix4dArray ComputeInstanceTransforms(SdfPath const& prototypeId) const;
+
+private:
+    // Transform of one instance of this level (instance primvars, then the instancer transform).
+    GfMatrix4d _ComputeLocalTransform(int index) const;
+
+    // Flattened transforms of this instancer itself, an identity if it has no parent.
+    VtMatrix4dArray _ComputeParentTransforms() const;
+
+    GfMatrix4d m_Transform;
+
+    // Per-instance primvars, empty if not authored.
+    VtVec3fArray    m_Translations;
+    VtQuatfArray    m_Rotations;
+    VtVec3fArray    m_Scales;
+    VtMatrix4dArray m_Transforms;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef EX_LOG
+#define EX_LOG
+
+#include "PxrUsage.h"
+
+#include <pxr/base/tf/debug.h>
+#include <pxr/base/tf/stringUtils.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+// Log categories, enabled at runtime with TF_DEBUG (e.g. TF_DEBUG="EX_DEBUG_SYNC EX_DEBUG_PRIM_LIFECYCLE").
+TF_DEBUG_CODES(
+    EX_DEBUG_DELEGATE,
+    EX_DEBUG_PRIM_LIFECYCLE,
+    EX_DEBUG_SYNC
+);
+
+/// \class ExLog
+///
+/// Buffered logging for the delegate's hot paths.
+///
+/// Every thread appends to its own buffer, so concurrent Sync() calls never contend with each other
+/// (only, briefly, with the drain thread swapping the buffer out). A background thread writes the
+/// buffers to stdout, so callers never wait on I/O.
+///
+class ExLog
+{
+public:
+    static ExLog& GetInstance();
+
+    ~ExLog();
+
+    /// Append a line to the calling thread's buffer.
+    void Write(std::string const& message);
+
+    /// Write out everything logged so far, blocking until it has been written.
+    void Flush();
+
+private:
+    ExLog();
+
+    struct ThreadBuffer
+    {
+        std::mutex  mutex;
+        std::string text;
+    };
+
+    ThreadBuffer* _GetThreadBuffer();
+
+    // Swap out and write every thread's buffer.
+    void _Drain();
+
+    void _Run();
+
+    // Buffers live as long as the log, since their threads may outlive any one delegate.
+    std::mutex                                 m_BuffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> m_Buffers;
+
+    // Serializes drains between the background thread and Flush().
+    std::mutex m_DrainMutex;
+
+    std::mutex              m_WakeMutex;
+    std::condition_variable m_Wake;
+    bool                    m_Stop;
+
+    std::thread m_Thread;
+};
+
+// Logging is compiled out unless EX_ENABLE_LOGGING is defined (debug builds), the arguments are then never evaluated.
+#ifdef EX_ENABLE_LOGGING
+    #define EX_LOG(code, ...)                                           \
+        do {                                                            \
+            if (TfDebug::IsEnabled(code))                               \
+                ExLog::GetInstance().Write(TfStringPrintf(__VA_ARGS__)); \
+        } while (false)
+#else
+    #define EX_LOG(code, ...) do { } while (false)
+#endif
+
+#endif
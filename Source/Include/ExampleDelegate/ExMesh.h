@@ -2,9 +2,39 @@
 #define MESH
 
 #include "PxrUsage.h"
+#include "ExResourceRegistry.h"
+#include "ExInstancer.h"
+#include "ExMeshSimplifier.h"
+#include "ExMeshClusters.h"
 
 PXR_NAMESPACE_USING_DIRECTIVE
 
+/// \struct ExMeshGeometry
+///
+/// CPU-side cache of a synced mesh, stored as a structure of arrays so that each
+/// stream is tightly packed and can be copied to a GPU buffer as-is.
+///
+/// The arrays are copy-on-write VtArrays, so unchanged streams (and streams shared
+/// with the scene delegate) cost nothing to hold onto.
+///
+struct ExMeshGeometry
+{
+    /// Vertex positions (object space).
+    VtVec3fArray positions;
+
+    /// Per-vertex normals, authored or computed smooth normals if none are provided.
+    VtVec3fArray normals;
+
+    /// Per-vertex display colors, empty unless authored with vertex (or varying) interpolation.
+    VtVec3fArray colors;
+
+    /// Triangulated index buffer (three indices per triangle).
+    VtVec3iArray indices;
+
+    /// Coarse face index of each triangle (for picking / face-uniform primvars).
+    VtIntArray primitiveParams;
+};
+
 /// \class Mesh
 ///
 /// This class is an example of a Hydra Rprim, or renderable object, and it
@@ -68,6 +98,55 @@ public:
         HdDirtyBits*     dirtyBits,
         TfToken const    &reprToken) override;
 
+    /// Release the mesh's draw slot.
+    ///   \param renderParam State.
+    void Finalize(HdRenderParam *renderParam) override;
+
+    /// Accessor for the synced geometry.
+    ///   \return The structure-of-arrays geometry cache.
+    inline ExMeshGeometry const& GetGeometry() const { return m_Geometry; }
+
+    /// Accessor for the synced object-to-world transform.
+    inline GfMatrix4f const& GetTransform() const { return m_Transform; }
+
+    /// Accessor for the object-space bounds of the synced points (empty if there are none).
+    inline GfRange3f const& GetLocalBounds() const { return m_LocalBounds; }
+
+    /// Index of this mesh in the delegate draw table.
+    inline uint32_t GetDrawSlot() const { return m_DrawSlot; }
+
+    /// Whether the mesh is a prototype of an instancer.
+    inline bool IsInstanced() const { return !GetInstancerId().IsEmpty(); }
+
+    /// Accessor for the quantized instances (see ExInstance), a single identity instance if the mesh isn't instanced.
+    inline VtUIntArray const& GetInstances() const { return m_Instances; }
+
+    inline uint32_t GetInstanceCount() const { return (uint32_t)(m_Instances.size() / kInstanceWords); }
+
+    /// World-space bounds of every instance (only maintained for instanced meshes).
+    inline GfRange3f const& GetInstanceBounds() const { return m_InstanceBounds; }
+
+    /// Accessors for the device copies of the geometry streams (shared with identical meshes).
+    inline ExGeometryRangeSharedPtr const& GetPositionRange() const { return m_PositionRange; }
+    inline ExGeometryRangeSharedPtr const& GetNormalRange()   const { return m_NormalRange;   }
+    inline ExGeometryRangeSharedPtr const& GetColorRange()    const { return m_ColorRange;    }
+    inline ExGeometryRangeSharedPtr const& GetIndexRange()    const { return m_IndexRange;    }
+    inline ExGeometryRangeSharedPtr const& GetInstanceRange() const { return m_InstanceRange; }
+
+    /// Accessors for the simplified levels of the mesh (null without a device) and their device index ranges.
+    inline ExMeshLodChainSharedPtr               const& GetLodChain()        const { return m_LodChain;        }
+    inline std::vector<ExGeometryRangeSharedPtr> const& GetLodIndexRanges()  const { return m_LodIndexRanges;  }
+
+    /// Clusters of the full-detail index buffer, empty for small meshes and without a device.
+    inline std::vector<ExMeshCluster> const& GetClusters() const { return m_Clusters; }
+
+    /// Synced cull style opinion of the mesh (HdCullStyleDontCare defers to the render pass), and sidedness.
+    inline HdCullStyle GetSyncedCullStyle() const { return m_CullStyle;   }
+    inline bool        IsDoubleSided()      const { return m_DoubleSided; }
+
+    /// Whether the device vertex streams are in the compact formats of ExVertexQuantization.
+    inline bool HasQuantizedVertices() const { return m_QuantizedVertices; }
+
 protected:
     // Initialize the given representation of this Rprim.
     // This is called prior to syncing the prim, the first time the repr
@@ -94,6 +173,62 @@ protected:
     //
     // See HdRprim::PropagateRprimDirtyBits()
     HdDirtyBits _PropagateDirtyBits(HdDirtyBits bits) const override;
+
+private:
+    // Pull the authored topology.
+    void _SyncTopology(HdSceneDelegate* sceneDelegate);
+
+    // Triangulate the synced topology into the geometry cache.
+    void _TriangulateTopology();
+
+    // Pull normals if authored with per-vertex interpolation, otherwise compute smooth ones.
+    void _SyncNormals(HdSceneDelegate* sceneDelegate, bool normalsDirty);
+
+    // Pull display colors if authored with per-vertex interpolation, none otherwise.
+    void _SyncColors(HdSceneDelegate* sceneDelegate);
+
+    // Flatten the instancer's instances for this prototype (or a single identity instance without one).
+    void _SyncInstances(HdSceneDelegate* sceneDelegate);
+
+    // Union of the mesh bounds under every instance transform.
+    void _UpdateInstanceBounds();
+
+    // Note: Only ever touched from this mesh's Sync(), so no synchronization is needed across meshes.
+    HdMeshTopology     m_Topology;
+    Hd_VertexAdjacency m_Adjacency;
+    ExMeshGeometry     m_Geometry;
+    GfMatrix4f         m_Transform;
+    GfRange3f          m_LocalBounds;
+    VtUIntArray        m_Instances;
+    GfRange3f          m_InstanceBounds;
+
+    ExGeometryRangeSharedPtr m_PositionRange;
+    ExGeometryRangeSharedPtr m_NormalRange;
+    ExGeometryRangeSharedPtr m_ColorRange;
+    ExGeometryRangeSharedPtr m_IndexRange;
+    ExGeometryRangeSharedPtr m_InstanceRange;
+
+    // Simplified levels, one index range each.
+    ExMeshLodChainSharedPtr               m_LodChain;
+    std::vector<ExGeometryRangeSharedPtr> m_LodIndexRanges;
+
+    // Clusters of m_Geometry.indices, whose triangles are stored cluster by cluster.
+    std::vector<ExMeshCluster> m_Clusters;
+
+    HdCullStyle m_CullStyle;
+    bool        m_DoubleSided;
+
+    // Fixed by the registry at the first sync.
+    bool m_QuantizedVertices;
+
+    ExDrawTable* m_DrawTable;
+    uint32_t     m_DrawSlot;
+
+    // Whether the current normals were authored (vs. computed from the points).
+    bool m_AuthoredNormals;
+
+    // Whether the triangulated indices are in the geometry cache, i.e. the points cover the topology.
+    bool m_IndicesPublished;
 };
 
 #endif
\ No newline at end of file
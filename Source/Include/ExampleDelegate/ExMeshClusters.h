@@ -0,0 +1,52 @@
+#ifndef MESH_CLUSTERS
+#define MESH_CLUSTERS
+
+#include "PxrUsage.h"
+
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+/// Size limits of a cluster, which keep its bounds tight (and match what mesh shading hardware favours).
+static constexpr uint32_t kMaxClusterVertices  = 64u;
+static constexpr uint32_t kMaxClusterTriangles = 124u;
+
+/// Quantized cone cutoff of a cluster whose normals spread too far for its back faces to ever be all that is seen.
+static constexpr int8_t kNoNormalCone = 127;
+
+/// \struct ExMeshCluster
+///
+/// A cluster (meshlet) of neighbouring triangles, stored contiguously in the mesh's index buffer so that any
+/// run of clusters is one draw. Clusters are culled on their own: against the frustum by their bounding
+/// sphere, and as back-facing by their normal cone.
+///
+struct ExMeshCluster
+{
+    /// Bounding sphere (object space).
+    GfVec3f center;
+    float   radius;
+
+    /// First index of the cluster and its index count, relative to the mesh's index buffer.
+    uint32_t firstIndex;
+    uint32_t indexCount;
+
+    /// Normal cone as snorm8: every triangle of the cluster faces away from any eye e for which
+    /// dot(center - e, axis) >= cutoff * |center - e| + radius.
+    int8_t coneAxis[3];
+    int8_t coneCutoff;
+};
+
+static_assert(sizeof(ExMeshCluster) == 28u, "Clusters are kept packed for culling.");
+
+/// Split a triangle list into clusters of up to kMaxClusterVertices vertices and kMaxClusterTriangles
+/// triangles, grown greedily over shared vertices. The triangles are reordered cluster by cluster (and the
+/// face index of each triangle with them), so any vertex stream stays valid.
+///   \param primitiveParams Per-triangle values reordered along with the triangles, may be empty.
+///   \return The clusters, none (and the triangles left alone) for a mesh small enough to be culled whole.
+std::vector<ExMeshCluster> ExBuildClusters(VtVec3fArray const& positions, VtVec3iArray* triangles, VtIntArray* primitiveParams);
+
+/// Refit the bounding spheres and normal cones of clusters to new positions (i.e. a deforming mesh), the
+/// triangles of each cluster being unchanged.
+void ExUpdateClusterBounds(VtVec3fArray const& positions, VtVec3iArray const& triangles, std::vector<ExMeshCluster>* clusters);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef MESH_SIMPLIFIER
+#define MESH_SIMPLIFIER
+
+#include "PxrUsage.h"
+
+#include <memory>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+/// \struct ExMeshLod
+///
+/// One simplified level of a mesh. Levels index the vertex streams of the full-detail mesh, so a
+/// level is nothing more than an index buffer.
+///
+struct ExMeshLod
+{
+    VtVec3iArray indices;
+
+    /// Largest (object space) distance from the original surface that the level introduces.
+    float error;
+};
+
+/// Simplified levels of a mesh, coarsest last. The full-detail mesh itself is not part of the chain.
+using ExMeshLodChain          = std::vector<ExMeshLod>;
+using ExMeshLodChainSharedPtr = std::shared_ptr<ExMeshLodChain const>;
+
+/// Reduce a triangle list towards a target triangle count by quadric error edge collapse.
+///
+/// Each collapse folds a vertex into one of its neighbours, so no vertex is moved or created and the
+/// result indexes the original streams (normals, colors) as-is. Vertices on open or non-manifold edges
+/// are never removed, which keeps silhouettes and attribute seams (split vertices) intact, and collapses
+/// that would flip a triangle are rejected. May stop short of the target when nothing else can go.
+///   \param error Receives the largest distance from the original surface (object space).
+///   \return The simplified triangles.
+VtVec3iArray ExSimplifyTriangles(VtVec3fArray const& positions, VtVec3iArray const& triangles, size_t targetTriangleCount, float* error);
+
+/// Build a chain of successively halved levels, stopping early once simplification stalls.
+///   \param maxLevels Levels to build at most, not counting the full-detail mesh.
+ExMeshLodChain ExBuildLodChain(VtVec3fArray const& positions, VtVec3iArray const& triangles, uint32_t maxLevels);
+
+#endif
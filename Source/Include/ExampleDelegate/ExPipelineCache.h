@@ -0,0 +1,89 @@
+#ifndef PIPELINE_CACHE
+#define PIPELINE_CACHE
+
+#include "PxrUsage.h"
+
+#include <vulkan/vulkan.h>
+
+#include <pxr/base/work/dispatcher.h>
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace VulkanWrappers
+{
+    class Device;
+}
+
+/// \class ExPipelineCache
+///
+/// Delegate-owned cache of shader modules and graphics pipelines, backed by a VkPipelineCache that is
+/// persisted to disk.
+///
+/// Shader modules are keyed by the hash of their SPIR-V, and pipelines by the hash of their shaders, their
+/// layout and a caller-provided key of the remaining render state, so every pass (and every variant) of the
+/// delegate compiles a given pipeline once. The cache blob of the previous session is loaded in the
+/// background as soon as the delegate has a device, so the driver can skip most of the compilation, and
+/// known variants can be compiled in the background too rather than on the first frame.
+///
+class ExPipelineCache
+{
+public:
+    /// Start loading the cache blob.
+    ///   \param path File the blob is loaded from and saved to, no persistence if empty.
+    ExPipelineCache(VulkanWrappers::Device* device, std::string const& path);
+
+    /// Saves the blob, and destroys every module and pipeline.
+    ~ExPipelineCache();
+
+    /// Shader module of a SPIR-V binary shipped as a plugin resource (i.e. "shaders/MeshVert.spv").
+    /// Thread-safe, each binary is only read and created once.
+    VkShaderModule GetShaderModule(std::string const& resource);
+
+    /// Fetch a graphics pipeline, or create it on first use. Thread-safe.
+    ///   \param pipelineInfo Create info, with every stage module obtained from GetShaderModule().
+    ///   \param stateKey     Hash of the state in pipelineInfo that is not implied by the shaders and the layout.
+    VkPipeline GetGraphicsPipeline(VkGraphicsPipelineCreateInfo const& pipelineInfo, uint64_t stateKey);
+
+    /// Run a task in the background, i.e. to create pipelines ahead of the first frame that needs them.
+    void Precompile(std::function<void()> const& task);
+
+    /// Wait for the background tasks to complete.
+    void Wait();
+
+    /// Write the current contents of the cache to disk.
+    void Save();
+
+private:
+
+    // The pipeline cache, once the blob has been loaded (blocks until then).
+    VkPipelineCache _GetPipelineCache();
+
+    void _Load();
+
+    // Is the blob one this device can use (driver validation aside, a foreign blob is simply discarded)?
+    bool _IsCompatible(std::vector<char> const& data) const;
+
+    VulkanWrappers::Device* m_Device;
+    std::string             m_Path;
+
+    std::once_flag  m_LoadOnce;
+    VkPipelineCache m_PipelineCache;
+
+    std::mutex                                    m_ShaderMutex;
+    std::unordered_map<std::string, VkShaderModule> m_ShadersByResource;
+    std::unordered_map<uint64_t, VkShaderModule>    m_ShadersByHash;
+    std::unordered_map<VkShaderModule, uint64_t>    m_ShaderHashes;
+
+    std::mutex                               m_PipelineMutex;
+    std::unordered_map<uint64_t, VkPipeline> m_Pipelines;
+
+    WorkDispatcher m_Dispatcher;
+};
+
+#endif
@@ -3,14 +3,42 @@
 
 #include "PxrUsage.h"
 
-PXR_NAMESPACE_USING_DIRECTIVE
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
 
-class VkImage;
-class VkImageView;
+PXR_NAMESPACE_USING_DIRECTIVE
 
+namespace VulkanWrappers
+{
+    class Device;
+    class Buffer;
+}
+
+class ExRenderTargetPool;
+class ExTimeline;
+
+/// \class ExRenderBuffer
+///
+/// Render target (AOV) that the application reads back through Map().
+///
+/// Without a device the pixels live in host memory and the software rasterizer writes them
+/// directly. With a device they live in persistently mapped, host-visible memory that render
+/// passes copy their targets into, so Map() hands out the copy destination itself. Each copy is
+/// tracked by the value of its submission on the delegate's timeline: the buffer is converged once
+/// the GPU has finished writing the final image.
+///
 class ExRenderBuffer final : public HdRenderBuffer
 {
 public:
+    /// Create a render buffer.
+    ///   \param device Device to back the buffer with, or null for a host memory buffer.
+    ///   \param pool     Pool the device memory is acquired from (required with a device).
+    ///   \param timeline Timeline the copies are submitted on (required with a device).
+    ExRenderBuffer(SdfPath const& id, VulkanWrappers::Device* device = nullptr, ExRenderTargetPool* pool = nullptr, ExTimeline* timeline = nullptr);
+    ~ExRenderBuffer() override;
 
     /// Get allocation information from the scene delegate.
     /// Note: Embree overrides this only to stop the render thread before
@@ -85,10 +113,70 @@ public:
     /// Resolve the sample buffer into final values.
     void Resolve() override;
 
+    /// Write a row of pixels, converting from float to the buffer format.
+    ///   \param x, y          First pixel to write.
+    ///   \param count         Number of pixels in the row.
+    ///   \param numComponents Components per pixel in the source data.
+    ///   \param values        count * numComponents floats.
+    void WriteRow(unsigned int x, unsigned int y, unsigned int count, size_t numComponents, float const* values);
+
+    /// Fill the whole buffer with a single value.
+    ///   \param numComponents Components in the value.
+    ///   \param value         The value (as float).
+    void Clear(size_t numComponents, float const* value);
+
+    /// Device memory render passes copy into, null for host memory buffers.
+    inline VulkanWrappers::Buffer* GetDeviceBuffer() const { return m_DeviceBuffer; }
+
+    /// Mark the start of a device copy into the buffer. Waits for the previous copy if it is still in flight.
+    void BeginResolve();
+
+    /// Mark the end of a device copy, after the commands writing the buffer have been submitted.
+    /// The buffer converges when the timeline reaches the submission, unless more samples are still to come.
+    ///   \param timelineValue Value signaled by the submission that copies into the buffer.
+    ///   \param final         False if the copied image is an intermediate result of progressive rendering.
+    void EndResolve(uint64_t timelineValue, bool final = true);
+
 private:
 
     // Release any allocated resources.
     void _Deallocate() override;
+
+    // Convert and store one pixel.
+    void _WritePixel(uint8_t* dst, size_t numComponents, float const* value) const;
+
+    // Block until an in-flight device copy completes. Expects m_ResolveMutex to be held.
+    void _WaitForResolve() const;
+
+    // Make a completed device copy visible to the host. Expects m_ResolveMutex to be held.
+    void _CompleteResolve() const;
+
+    unsigned int m_Width;
+    unsigned int m_Height;
+    HdFormat     m_Format;
+
+    // Host memory storage (no device).
+    std::vector<uint8_t> m_Buffer;
+
+    VulkanWrappers::Device* m_Device;
+    ExRenderTargetPool*     m_Pool;
+    ExTimeline*             m_Timeline;
+    VulkanWrappers::Buffer* m_DeviceBuffer;
+
+    // Start of the pixels, in whichever storage backs the buffer.
+    uint8_t* m_Data;
+
+    // Reached once the last device copy into the buffer has completed.
+    uint64_t m_ResolveValue;
+
+    mutable std::mutex m_ResolveMutex;
+    mutable bool       m_ResolvePending;
+
+    // Whether the copy in flight is the final image (converges the buffer once it lands).
+    bool m_ResolveFinal;
+
+    std::atomic<int>          m_Mappers;
+    mutable std::atomic<bool> m_Converged;
 };
 
 #endif
\ No newline at end of file
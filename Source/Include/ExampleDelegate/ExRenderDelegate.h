@@ -2,14 +2,51 @@
 #define RENDERER_DELEGATE
 
 #include "PxrUsage.h"
+#include "ExRenderStats.h"
 
 PXR_NAMESPACE_USING_DIRECTIVE
 
+// Render settings understood by the delegate.
+// ReadbackLatency: Number of frames (0-2) the manual-submit readback may lag behind rendering.
+// ParallelRecording: Record large draw lists on worker threads into secondary command buffers.
+// FrustumCulling: Skip draws whose bounds are outside the view frustum.
+// OcclusionCulling: Also skip draws hidden behind large occluders (CPU, coarse).
+// ClusterCulling: Split dense meshes into clusters that are culled on their own, against the frustum and (where back faces are culled) by their normals.
+// SoftwareRendering: Rasterize on the CPU into the AOV render buffers, no Vulkan device is created.
+// TraceOutputPath: When set, trace scopes are collected and written as Chrome trace JSON to this path once it is cleared.
+// ProjectionJitter: Offset the projection by a different subpixel amount every frame.
+// ProgressiveSamples: With jitter, number of samples averaged while the view and scene are still before the image converges.
+// PipelineCachePath: File the compiled pipelines are persisted to across sessions (defaults to one in the temp directory).
+// LodPixelError: Largest simplification error (in pixels) a mesh level of detail may show on screen, zero always draws full detail.
+// QuantizeVertices: Upload mesh positions, normals and colors in compact 16-bit formats (read when the delegate is created).
+#define EX_RENDER_SETTINGS_TOKENS \
+    ((readbackLatency,    "ReadbackLatency"))    \
+    ((parallelRecording,  "ParallelRecording"))  \
+    ((frustumCulling,     "FrustumCulling"))     \
+    ((occlusionCulling,   "OcclusionCulling"))   \
+    ((clusterCulling,     "ClusterCulling"))     \
+    ((softwareRendering,  "SoftwareRendering"))  \
+    ((traceOutputPath,    "TraceOutputPath"))    \
+    ((projectionJitter,   "ProjectionJitter"))   \
+    ((progressiveSamples, "ProgressiveSamples")) \
+    ((pipelineCachePath,  "PipelineCachePath"))  \
+    ((lodPixelError,      "LodPixelError"))      \
+    ((quantizeVertices,   "QuantizeVertices"))
+
+TF_DECLARE_PUBLIC_TOKENS(ExRenderSettingsTokens, EX_RENDER_SETTINGS_TOKENS);
+
 namespace VulkanWrappers
 {
     class Device;
 }
 
+class ExRenderTargetPool;
+class ExFrameContext;
+class ExTimeline;
+class ExPipelineCache;
+class ExResourceRegistry;
+class ExRenderParam;
+
 class ExRenderDelegate final : public HdRenderDelegate
 {
 public:
@@ -26,6 +63,12 @@ public:
     /// Render delegate destructor.
     virtual ~ExRenderDelegate();
 
+    /// Drivers understood by the delegate:
+    ///   CustomVulkanDevice (VulkanWrappers::Device*): Render on the application's device, which submits our work.
+    ///   CustomVulkanDeviceFeatures (VkPhysicalDeviceFeatures2 const*): The feature chain that device was created
+    ///   with. Optional features (i.e. multiDrawIndirect) are only used when they are listed as enabled here.
+    ///   CustomSoftwareRasterizer: Rasterize on the CPU, no device is used.
+    /// A device without the timelineSemaphore feature is an error, the delegate then rasterizes on the CPU.
     void SetDrivers(HdDriverVector const& drivers) override;
 
     /// Supported types
@@ -57,14 +100,35 @@ public:
 
     HdRenderParam *GetRenderParam() const override;
 
+    HdRenderSettingDescriptorList GetRenderSettingDescriptors() const override;
+
+    /// Timings and counters of the last frame (see ExRenderStatsTokens).
+    VtDictionary GetRenderStats() const override;
+
+    HdAovDescriptor GetDefaultAovDescriptor(TfToken const& name) const override;
+
     // Utility
     // ---------------------------
 
     inline VulkanWrappers::Device* GetGraphicsDevice() { return m_GraphicsDevice; }
 
-    // If the delegate owns the graphics device, we will need to submit commands ourselves. 
+    inline ExRenderTargetPool* GetRenderTargetPool() { return m_RenderTargetPool.get(); }
+
+    inline ExFrameContext* GetFrameContext() { return m_FrameContext.get(); }
+
+    inline ExTimeline* GetTimeline() { return m_Timeline.get(); }
+
+    inline ExResourceRegistry* GetExResourceRegistry() { return _resourceRegistry.get(); }
+
+    inline ExRenderStats* GetExRenderStats() { return &m_RenderStats; }
+
+    // If the delegate owns the graphics device, we will need to submit commands ourselves. Otherwise the application
+    // provides the "CurrentFrame" and its "CurrentFrameIndex" render settings (see ExFrameContext::kFrameCount).
     inline bool RequiresManualQueueSubmit() { return m_DefaultGraphicsDevice.get() != nullptr; }
 
+    // Without a device, passes rasterize on the CPU into the bound render buffers.
+    inline bool IsSoftwareRendering() const { return m_SoftwareRendering; }
+
 private:
 
     static const TfTokenVector SUPPORTED_RPRIM_TYPES;
@@ -73,12 +137,37 @@ private:
 
     void _Initialize();
 
+    // Start or stop trace collection when the output path setting changes, writing out the finished trace.
+    void _UpdateTracing(std::string const& tracePath);
+
+    HdRenderSettingDescriptorList m_SettingDescriptors;
+
     // Default delegate-managed device resource that is created if the application doesn't provide one.
     std::unique_ptr<VulkanWrappers::Device> m_DefaultGraphicsDevice;
 
     VulkanWrappers::Device* m_GraphicsDevice;
 
-    HdResourceRegistrySharedPtr _resourceRegistry;
+    bool m_SoftwareRendering;
+
+    // Progress of this delegate's submissions, everything waits on it rather than on the device (released last).
+    std::unique_ptr<ExTimeline> m_Timeline;
+
+    // Viewport-sized resources shared by all render passes of this delegate (released before the device).
+    std::unique_ptr<ExRenderTargetPool> m_RenderTargetPool;
+
+    // Shader modules and pipelines, loaded from and saved to disk (released after the frame context).
+    std::unique_ptr<ExPipelineCache> m_PipelineCache;
+
+    // Pipelines and frames in flight of this delegate's passes, so that several delegates can render at once (released before the pool).
+    std::unique_ptr<ExFrameContext> m_FrameContext;
+
+    std::shared_ptr<ExResourceRegistry> _resourceRegistry;
+
+    ExRenderStats                  m_RenderStats;
+    std::unique_ptr<ExRenderParam> m_RenderParam;
+
+    // Chrome trace destination while tracing is active.
+    std::string m_TracePath;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef RENDER_PARAM
+#define RENDER_PARAM
+
+#include "PxrUsage.h"
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+class ExRenderStats;
+
+/// \class ExRenderParam
+///
+/// Delegate-global state handed to every prim's Sync() and Finalize().
+///
+class ExRenderParam final : public HdRenderParam
+{
+public:
+    ExRenderParam(ExRenderStats* renderStats) : m_RenderStats(renderStats) {}
+
+    inline ExRenderStats* GetRenderStats() const { return m_RenderStats; }
+
+private:
+    ExRenderStats* m_RenderStats;
+};
+
+#endif
@@ -3,9 +3,27 @@
 
 #include "PxrUsage.h"
 
+#include <pxr/base/gf/matrix4f.h>
+#include <pxr/base/gf/vec4f.h>
+#include <pxr/imaging/cameraUtil/framing.h>
+#include <pxr/imaging/hd/aov.h>
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <vector>
+
 PXR_NAMESPACE_USING_DIRECTIVE
 
 class ExRenderDelegate;
+class ExCuller;
+class ExSoftwareRasterizer;
+class HdCamera;
+
+namespace VulkanWrappers
+{
+    class Image;
+}
 
 /// \class RenderPass
 ///
@@ -24,6 +42,9 @@ public:
     /// Renderpass destructor.
     virtual ~ExRenderPass();
 
+    /// Whether the last image was final: no progressive samples are left to accumulate for the current view.
+    bool IsConverged() const override;
+
 protected:
 
     /// Draw the scene with the bound renderpass state.
@@ -33,7 +54,86 @@ protected:
     void _Execute(HdRenderPassStateSharedPtr const& renderPassState, TfTokenVector const &renderTags) override;
 
 private:
+    // Rasterize on the CPU into the bound AOVs (no device).
+    void _ExecuteSoftware(HdRenderPassStateSharedPtr const& renderPassState);
+
+    // Acquire pool targets that fit the viewport (a no-op if the size bucket is unchanged).
+    void _UpdateRenderTargets(VkExtent2D extent);
+
+    // Compare what the view is built from against the cached key, returns true (and restarts the jitter sequence) if it changed.
+    bool _UpdateViewKey(HdRenderPassStateSharedPtr const& renderPassState, VkExtent2D extent);
+
+    // View-projection of the pass camera for a target of the given size, rebuilt only when the camera,
+    // framing or size changed, or when jittering (a new subpixel offset every execute).
+    GfMatrix4f const& _UpdateViewProjection(HdRenderPassStateSharedPtr const& renderPassState, VkExtent2D extent);
+
+    // Hash of the values of the render settings the pass reads that change the image (the view key covers jitter).
+    size_t _ComputeSettingsHash() const;
+
+    // Returns true if the image has to be rendered again: the scene, view, settings or AOV bindings changed since
+    // the last one, or it still needs progressive samples. Restarts accumulation on any change.
+    bool _UpdateProgress(HdRenderPassStateSharedPtr const& renderPassState, VkExtent2D extent);
+
+    // Blend the color target into the running average and replace it with the result.
+    void _RecordAccumulation(VkCommandBuffer cmd, VkRect2D const& scissor, VkViewport const& viewport);
+
     ExRenderDelegate* m_Owner;
+
+    // What the cached view-projection was built from. The matrices are compared by value, as without a camera
+    // (matrices set directly on the state) there is no version to go by.
+    struct ViewKey
+    {
+        HdCamera const*   camera;
+        uint64_t          cameraVersion;
+        GfMatrix4d        worldToView;
+        GfMatrix4d        projection;
+        CameraUtilFraming framing;
+        GfVec4f           viewport;
+        VkExtent2D        extent;
+        bool              jitter;
+    };
+
+    ViewKey    m_ViewKey;
+    bool       m_ViewDirty;
+    GfMatrix4f m_ViewProjection;
+
+    // Index into the jitter sequence, restarts whenever the view changes.
+    uint32_t m_JitterIndex;
+
+    // Change tracker versions, settings and bindings the current image was rendered with. Settings are hashed
+    // by value: the application updates some of them (i.e. CurrentFrame) every frame, so their version always changes.
+    unsigned int                 m_SceneStateVersion;
+    unsigned int                 m_CollectionVersion;
+    unsigned int                 m_RenderTagVersion;
+    size_t                       m_SettingsHash;
+    HdRenderPassAovBindingVector m_AovBindings;
+
+    // Samples in the current image (zero when it has to be redrawn), and how many it takes to converge.
+    uint32_t m_SampleCount;
+    uint32_t m_TargetSampleCount;
+
+    // Float running average of the jittered samples, created on first use.
+    struct Accumulation;
+    std::unique_ptr<Accumulation> m_Accumulation;
+
+    // Per-pass viewport-sized targets, borrowed from the delegate render target pool.
+    VulkanWrappers::Image* m_ColorTarget;
+    VulkanWrappers::Image* m_DepthTarget;
+    VulkanWrappers::Image* m_PrimIdTarget;
+    VkExtent2D             m_TargetExtent;
+
+    // Visibility for this pass's view, rebuilt every execute.
+    std::unique_ptr<ExCuller> m_Culler;
+    std::vector<uint32_t>     m_VisibleSlots;
+
+    // Scratch for grouping the visible slots by shader variant.
+    std::vector<uint32_t> m_SortScratch;
+
+    // First indirect command of each visible slot (see ComputeCommandOffsets), and the total last.
+    std::vector<uint32_t> m_CommandOffsets;
+
+    // Only created when the delegate renders in software.
+    std::unique_ptr<ExSoftwareRasterizer> m_SoftwareRasterizer;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,111 @@
+#ifndef RENDER_STATS
+#define RENDER_STATS
+
+#include "PxrUsage.h"
+
+#include <pxr/base/vt/dictionary.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+// Keys of the dictionary returned by GetRenderStats(). Times are in milliseconds, summed over one
+// frame interval (from one CommitResources to the next). Sync time is summed over every mesh, so
+// with parallel sync it can exceed the wall-clock time of the interval.
+#define EX_RENDER_STATS_TOKENS \
+    ((syncTime,       "cpuSyncMs"))       \
+    ((commitTime,     "cpuCommitMs"))     \
+    ((cullTime,       "cpuCullMs"))       \
+    ((recordTime,     "cpuRecordMs"))     \
+    ((submitTime,     "cpuSubmitMs"))     \
+    ((readbackTime,   "cpuReadbackMs"))   \
+    ((gpuRenderTime,  "gpuRenderMs"))     \
+    ((gpuCopyTime,    "gpuCopyMs"))       \
+    ((drawCount,      "drawCount"))       \
+    ((visibleCount,   "visibleDrawCount")) \
+    ((frameCount,     "frameCount"))
+
+TF_DECLARE_PUBLIC_TOKENS(ExRenderStatsTokens, EX_RENDER_STATS_TOKENS);
+
+/// \enum ExRenderPhase
+///
+/// CPU phases of a frame that are timed.
+///
+enum class ExRenderPhase
+{
+    Sync,
+    Commit,
+    Cull,
+    Record,
+    Submit,
+    Readback,
+    Count
+};
+
+/// \class ExRenderStats
+///
+/// Per-delegate frame timings and counters, published to the application through GetRenderStats().
+///
+/// Phase times are accumulated lock-free (sync runs on many threads at once) and published as a
+/// snapshot at every frame boundary, so a reader always sees one consistent interval.
+///
+class ExRenderStats
+{
+public:
+    ExRenderStats();
+
+    /// Add time spent in a phase during the current interval.
+    void AddTime(ExRenderPhase phase, std::chrono::steady_clock::duration duration);
+
+    /// Set the GPU times of the most recent frame whose timestamps are available.
+    void SetGpuTimes(double renderMilliseconds, double copyMilliseconds);
+
+    /// Set the draw counts of the current interval.
+    void SetDrawCounts(uint32_t drawCount, uint32_t visibleCount);
+
+    /// Close the current interval and publish it.
+    void EndFrame();
+
+    /// The last published interval.
+    VtDictionary GetDictionary() const;
+
+private:
+
+    std::atomic<uint64_t> m_Nanoseconds[(size_t)ExRenderPhase::Count];
+
+    std::atomic<double>   m_GpuRenderMilliseconds;
+    std::atomic<double>   m_GpuCopyMilliseconds;
+    std::atomic<uint32_t> m_DrawCount;
+    std::atomic<uint32_t> m_VisibleCount;
+
+    uint64_t m_FrameCount;
+
+    mutable std::mutex m_Mutex;
+    VtDictionary       m_Published;
+};
+
+/// \class ExScopedTimer
+///
+/// Adds the lifetime of the scope to a phase. A null stats object makes it a no-op.
+///
+class ExScopedTimer
+{
+public:
+    ExScopedTimer(ExRenderStats* stats, ExRenderPhase phase)
+        : m_Stats(stats), m_Phase(phase), m_Start(std::chrono::steady_clock::now()) {}
+
+    ~ExScopedTimer()
+    {
+        if (m_Stats != nullptr)
+            m_Stats->AddTime(m_Phase, std::chrono::steady_clock::now() - m_Start);
+    }
+
+private:
+    ExRenderStats*                        m_Stats;
+    ExRenderPhase                         m_Phase;
+    std::chrono::steady_clock::time_point m_Start;
+};
+
+#endif
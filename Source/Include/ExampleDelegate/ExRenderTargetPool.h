@@ -0,0 +1,104 @@
+#ifndef RENDER_TARGET_POOL
+#define RENDER_TARGET_POOL
+
+#include "PxrUsage.h"
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace VulkanWrappers
+{
+    class Device;
+    class Image;
+    class Buffer;
+}
+
+class ExTimeline;
+
+/// \class ExRenderTargetPool
+///
+/// Delegate-owned pool of viewport-sized resources (color/depth targets and readback staging).
+///
+/// Allocations are made in coarse size buckets, so an interactive resize usually hands back the
+/// same allocation and the caller simply renders into a sub-rectangle of it. Released resources
+/// are kept around for a number of frames before the memory is actually freed. A release is stamped
+/// with the delegate's last submission, and the resource is neither reused nor freed before the
+/// device has passed it, so it is safe to release a target that is still referenced by frames in flight.
+///
+class ExRenderTargetPool
+{
+public:
+    ExRenderTargetPool(VulkanWrappers::Device* device, ExTimeline* timeline);
+    ~ExRenderTargetPool();
+
+    /// Round an extent up to the size bucket the pool allocates for it.
+    static VkExtent2D GetBucketExtent(VkExtent2D extent);
+
+    /// Acquire an image that can hold at least the requested extent.
+    VulkanWrappers::Image* AcquireImage(VkExtent2D extent, VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect);
+
+    /// Acquire a buffer of at least the requested size.
+    ///   \param allocationFlags VmaAllocationCreateFlags for the buffer memory.
+    VulkanWrappers::Buffer* AcquireBuffer(VkDeviceSize size, VkBufferUsageFlags usage, uint32_t allocationFlags);
+
+    /// Return a resource to the pool. The memory stays alive until it has been idle for a while.
+    void Release(VulkanWrappers::Image* image);
+    void Release(VulkanWrappers::Buffer* buffer);
+
+    /// Advance the pool by one frame and free resources that have been idle for too long.
+    void Tick();
+
+private:
+
+    struct Key
+    {
+        uint32_t     width, height;
+        VkDeviceSize size;
+        uint32_t     format;
+        uint32_t     usage;
+        uint32_t     flags;
+
+        bool operator==(Key const& other) const;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(Key const& key) const;
+    };
+
+    struct Entry
+    {
+        std::unique_ptr<VulkanWrappers::Image>  image;
+        std::unique_ptr<VulkanWrappers::Buffer> buffer;
+
+        Key      key;
+        bool     inUse;
+        uint64_t lastUsedFrame;
+
+        // Timeline value the device has to pass before the resource can be handed out again.
+        uint64_t releaseValue;
+    };
+
+    Entry* _Acquire(Key const& key);
+    void   _Release(void* resource);
+    void   _Free(Entry* entry);
+
+    VulkanWrappers::Device* m_Device;
+    ExTimeline*             m_Timeline;
+
+    std::mutex m_Mutex;
+    uint64_t   m_FrameIndex;
+
+    // Entries are owned here, and indexed by key (for acquire) and by resource address (for release).
+    std::vector<std::unique_ptr<Entry>>                 m_Entries;
+    std::unordered_multimap<Key, Entry*, KeyHash>       m_EntriesByKey;
+    std::unordered_map<void*, Entry*>                   m_EntriesByResource;
+};
+
+#endif
@@ -0,0 +1,222 @@
+#ifndef RESOURCE_REGISTRY
+#define RESOURCE_REGISTRY
+
+#include "PxrUsage.h"
+#include "ExGeometryHeap.h"
+#include "ExDrawTable.h"
+#include "ExBoundsHierarchy.h"
+#include "ExMeshSimplifier.h"
+
+#include <tbb/concurrent_hash_map.h>
+#include <tbb/concurrent_queue.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+class ExResourceRegistry;
+class ExTimeline;
+
+/// \class ExGeometryRange
+///
+/// A reference-counted, content-addressed range of geometry data in the registry heap. Meshes
+/// that register identical data (instanced or duplicated assets) share the same range, and the
+/// heap memory is returned once the last reference is dropped.
+///
+class ExGeometryRange
+{
+public:
+    ~ExGeometryRange();
+
+    /// Whether the data has been uploaded (i.e. a commit has happened since registration).
+    inline bool IsResident() const { return m_Allocation.IsValid(); }
+
+    /// Location of the data in the registry heap. Only valid once resident.
+    inline ExGeometryAllocation const& GetAllocation() const { return m_Allocation; }
+
+    /// Size of the data in bytes.
+    inline VkDeviceSize GetSize() const { return m_Size; }
+
+private:
+    friend class ExResourceRegistry;
+
+    // Whether the range holds exactly these bytes, a matching hash alone doesn't make data identical.
+    bool _HasContents(void const* data, size_t size) const;
+
+    ExResourceRegistry*  m_Registry;
+    uint64_t             m_Hash;
+    VkDeviceSize         m_Size;
+    ExGeometryAllocation m_Allocation;
+
+    // The data the range currently holds, kept to compare against when other data hashes the same.
+    VtValue     m_Source;
+    void const* m_Data;
+};
+
+using ExGeometryRangeSharedPtr = std::shared_ptr<ExGeometryRange>;
+
+/// \class ExResourceRegistry
+///
+/// Collects geometry registered by rprims during sync, deduplicates it by content, and flushes
+/// everything to the device in one batched staging copy per commit.
+///
+class ExResourceRegistry final : public HdResourceRegistry
+{
+public:
+    /// Create a registry.
+    ///   \param device   Device to upload to, or null for a host-only registry.
+    ///   \param timeline Timeline the uploads are submitted on (required with a device).
+    ///   \param quantizeVertices Whether meshes upload their vertex streams in the compact formats of
+    ///                           ExVertexQuantization (ignored for a host-only registry).
+    ExResourceRegistry(VulkanWrappers::Device* device, ExTimeline* timeline = nullptr, bool quantizeVertices = false);
+    ~ExResourceRegistry() override;
+
+    /// Queue a geometry stream for upload. Identical data resolves to the same shared range.
+    /// Thread-safe, this is called from rprim Sync() on worker threads.
+    ///   \return A range that becomes resident after the next commit, or null for empty data.
+    template <typename T>
+    ExGeometryRangeSharedPtr AddGeometry(VtArray<T> const& data)
+    {
+        return _AddGeometry(VtValue(data), data.cdata(), data.size() * sizeof(T));
+    }
+
+    /// Replace the contents of a range. A resident range that only the caller holds and that keeps its size
+    /// is patched in place, otherwise this falls back to AddGeometry() (copy-on-write). Thread-safe.
+    ///   \return The range now holding the data, which may be a different one than was passed in.
+    template <typename T>
+    ExGeometryRangeSharedPtr UpdateGeometry(ExGeometryRangeSharedPtr const& range, VtArray<T> const& data)
+    {
+        return _UpdateGeometry(range, VtValue(data), data.cdata(), data.size() * sizeof(T));
+    }
+
+    /// Fetch the LOD chain of a triangulated mesh, simplifying it on first use. Identical geometry (i.e. the
+    /// same asset referenced many times) shares one chain, which is built once. Thread-safe, this is called
+    /// from rprim Sync() on worker threads.
+    ///   \return The chain, null for a host-only registry (software rendering draws full detail).
+    ExMeshLodChainSharedPtr GetLodChain(VtVec3fArray const& positions, VtVec3iArray const& triangles);
+
+    /// Whether the registry was created without a device (software rendering).
+    inline bool IsHostOnly() const { return m_Device == nullptr; }
+
+    /// Whether meshes upload quantized vertex streams (see kMeshFeatureQuantized).
+    inline bool QuantizesVertices() const { return m_QuantizeVertices; }
+
+    /// Accessor for the device heap that holds all resident geometry.
+    inline ExGeometryHeap* GetGeometryHeap() { return m_GeometryHeap.get(); }
+
+    /// Accessor for the table of per-draw records and transforms.
+    inline ExDrawTable* GetDrawTable() { return &m_DrawTable; }
+
+    /// Accessor for the hierarchy over the draw table bounds (current as of the last commit).
+    inline ExBoundsHierarchy const& GetBoundsHierarchy() const { return m_BoundsHierarchy; }
+
+protected:
+
+    // Upload all pending geometry in one transfer.
+    void _Commit() override;
+
+    // Release heap memory that is no longer referenced (and no longer in use by the GPU).
+    void _GarbageCollect() override;
+
+private:
+    friend class ExGeometryRange;
+
+    struct PendingUpload
+    {
+        std::weak_ptr<ExGeometryRange> range;
+
+        // Keeps the source array alive (and its memory unchanged) until it is copied to staging.
+        VtValue     source;
+        void const* data;
+
+        // Order of the upload, a range patched again before the commit only uploads its newest contents.
+        uint64_t sequence;
+    };
+
+    // A LOD chain along with the geometry it was built from, to compare against when other geometry hashes the same.
+    struct LodChainEntry
+    {
+        std::weak_ptr<ExMeshLodChain const> chain;
+
+        VtVec3fArray positions;
+        VtVec3iArray triangles;
+    };
+
+    struct PendingFree
+    {
+        ExGeometryAllocation allocation;
+        uint64_t             frameIndex;
+        uint64_t             timelineValue;
+    };
+
+    // A copy from the staging arena into a device buffer.
+    struct StagingCopy
+    {
+        VkBuffer     dstBuffer;
+        VkBufferCopy region;
+    };
+
+    // A staging arena + the command buffer that copies out of it. Several are cycled so that
+    // a commit never has to wait on the transfer of the previous one.
+    struct UploadFrame
+    {
+        VulkanWrappers::Buffer* staging       = nullptr;
+        VkDeviceSize            stagingSize   = 0u;
+        void*                   stagingMapped = nullptr;
+        VkCommandBuffer         cmd           = VK_NULL_HANDLE;
+        uint64_t                timelineValue = 0u;
+    };
+
+    ExGeometryRangeSharedPtr _AddGeometry(VtValue const& source, void const* data, size_t size);
+
+    ExGeometryRangeSharedPtr _UpdateGeometry(ExGeometryRangeSharedPtr const& range, VtValue const& source, void const* data, size_t size);
+
+    // Called from the range destructor (any thread).
+    void _ReleaseGeometry(ExGeometryAllocation const& allocation);
+
+    void _ResizeStaging(UploadFrame* frame, VkDeviceSize size);
+
+    // Reserve space in this commit's staging layout.
+    VkDeviceSize _AllocateStaging(VkDeviceSize size);
+
+    // Record the copies, merging those that are contiguous in both the arena and the destination.
+    void _RecordStagingCopies(VkCommandBuffer cmd, VkBuffer staging);
+
+    VulkanWrappers::Device* m_Device;
+    ExTimeline*             m_Timeline;
+    bool                    m_QuantizeVertices;
+
+    // Null for a host-only registry (no device).
+    std::unique_ptr<ExGeometryHeap> m_GeometryHeap;
+
+    ExDrawTable m_DrawTable;
+
+    ExBoundsHierarchy m_BoundsHierarchy;
+
+    // Content hash -> live range, for deduplication.
+    tbb::concurrent_hash_map<uint64_t, std::weak_ptr<ExGeometryRange>> m_Ranges;
+
+    // Geometry hash -> live LOD chain.
+    tbb::concurrent_hash_map<uint64_t, LodChainEntry> m_LodChains;
+
+    tbb::concurrent_queue<PendingUpload>        m_PendingUploads;
+    std::atomic<uint64_t>                       m_UploadSequence;
+    tbb::concurrent_queue<ExGeometryAllocation> m_ReleasedAllocations;
+
+    std::vector<PendingFree> m_PendingFrees;
+
+    std::vector<UploadFrame> m_UploadFrames;
+    uint64_t                 m_FrameIndex;
+
+    // Per-commit scratch.
+    std::vector<StagingCopy> m_StagingCopies;
+    std::vector<uint32_t>    m_DirtyDrawSlots;
+    std::vector<uint32_t>    m_DirtyDrawRecords;
+    VkDeviceSize             m_StagingSize;
+};
+
+using ExResourceRegistrySharedPtr = std::shared_ptr<ExResourceRegistry>;
+
+#endif
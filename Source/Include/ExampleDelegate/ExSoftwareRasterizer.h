@@ -0,0 +1,99 @@
+#ifndef SOFTWARE_RASTERIZER
+#define SOFTWARE_RASTERIZER
+
+#include "PxrUsage.h"
+
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+class ExDrawTable;
+class ExMesh;
+class ExRenderBuffer;
+
+/// \struct ExSoftwareTarget
+///
+/// Render buffers (either may be null) and clear values for a software render.
+///
+struct ExSoftwareTarget
+{
+    ExRenderBuffer* color = nullptr;
+    ExRenderBuffer* depth = nullptr;
+
+    GfVec4f clearColor = GfVec4f(0.0f, 0.0f, 0.0f, 1.0f);
+    float   clearDepth = 1.0f;
+};
+
+/// \class ExSoftwareRasterizer
+///
+/// CPU triangle rasterizer for rendering without a GPU. Meshes are drawn straight from their
+/// mesh cache with the same shading as the device path. Work is split in two parallel phases:
+/// triangles are set up per mesh, then binned into screen tiles that are rasterized independently
+/// (four pixels at a time with SSE where available).
+///
+/// The output only depends on the scene and view: every tile draws its triangles in slot order,
+/// whatever the thread count.
+///
+class ExSoftwareRasterizer
+{
+public:
+    ExSoftwareRasterizer();
+
+    /// Rasterize the given draw slots into the target buffers (which must be the same size).
+    ///   \param slots Slots to draw, in ascending order.
+    void Render(ExDrawTable const&           drawTable,
+                std::vector<uint32_t> const& slots,
+                GfMatrix4f const&            viewProjection,
+                ExSoftwareTarget const&      target);
+
+private:
+
+    // Screen-space triangle with every attribute stored as a plane: value(x, y) = a * x + b * y + c.
+    struct Triangle
+    {
+        // Barycentric weight of each vertex.
+        GfVec3f edgeA, edgeB, edgeC;
+
+        // Clip depth, 1 / w and normal / w (for perspective-correct interpolation).
+        GfVec3f depth;
+        GfVec3f invW;
+        GfVec3f normal[3];
+
+        int minX, minY, maxX, maxY;
+    };
+
+    // Triangles of one mesh.
+    struct Batch
+    {
+        std::vector<Triangle> triangles;
+
+        int minX, minY, maxX, maxY;
+    };
+
+    struct ClipVertex
+    {
+        GfVec4f position;
+        GfVec3f normal;
+    };
+
+    // Transform, clip and set up the mesh's triangles, appending them to the batch.
+    void _SetupMesh(ExMesh const* mesh, GfMatrix4f const& objectToWorld, GfMatrix4f const& viewProjection, Batch* batch) const;
+
+    void _SetupTriangle(ClipVertex const& v0, ClipVertex const& v1, ClipVertex const& v2, Batch* batch) const;
+
+    void _BinTriangles(uint32_t tileRow);
+
+    void _RasterizeTile(uint32_t tileX, uint32_t tileY, ExSoftwareTarget const& target) const;
+
+    uint32_t m_Width;
+    uint32_t m_Height;
+    uint32_t m_TileCountX;
+    uint32_t m_TileCountY;
+
+    std::vector<Batch> m_Batches;
+
+    // Triangles overlapping each tile, in draw order.
+    std::vector<std::vector<Triangle const*>> m_Bins;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef TIMELINE
+#define TIMELINE
+
+#include "PxrUsage.h"
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <mutex>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace VulkanWrappers
+{
+    class Device;
+}
+
+/// Submit to a queue. Queues require external synchronization, and delegates sharing a device share
+/// its queues, so every submission of the delegate goes through here.
+VkResult ExQueueSubmit(VkQueue queue, uint32_t submitCount, VkSubmitInfo const* submits, VkFence fence);
+
+/// \class ExTimeline
+///
+/// Delegate-owned timeline semaphore that tracks the progress of the delegate's own submissions.
+///
+/// Every submission signals the next value of the timeline, so waiting for one piece of work (a readback,
+/// a resolve, an upload) never waits on anything submitted after it, and never on the work of the host
+/// application sharing the device. Resources that may still be in use are released against the value of
+/// the last submission, and recycled once the timeline has passed it.
+///
+/// Requires the device to enable the (Vulkan 1.2 core) timelineSemaphore feature, see IsSupported().
+///
+class ExTimeline
+{
+public:
+    ExTimeline(VulkanWrappers::Device* device);
+    ~ExTimeline();
+
+    /// Whether the device has the timelineSemaphore feature enabled.
+    ///   \param enabledFeatures Feature chain the device was created with, if the application provided it. Otherwise
+    ///                          only the physical device's support can be checked.
+    static bool IsSupported(VulkanWrappers::Device* device, VkPhysicalDeviceFeatures2 const* enabledFeatures);
+
+    /// Submit a batch that signals the next value of the timeline once it completes.
+    ///   \param submitInfo A batch without signal semaphores of its own.
+    ///   \return The value signaled by the batch.
+    uint64_t Submit(VkQueue queue, VkSubmitInfo const& submitInfo);
+
+    /// Value signaled by the most recent submission, i.e. the point by which everything submitted so far has completed.
+    inline uint64_t GetSubmittedValue() const { return m_SubmittedValue.load(); }
+
+    /// Latest value the device has signaled.
+    uint64_t GetCompletedValue() const;
+
+    /// Has the device passed the provided value?
+    inline bool IsComplete(uint64_t value) const { return value <= m_CompletedValue.load() || value <= GetCompletedValue(); }
+
+    /// Block until the device has passed the provided value. Value zero is always complete.
+    void Wait(uint64_t value) const;
+
+    /// Block until every submission made so far has completed.
+    inline void WaitIdle() const { Wait(GetSubmittedValue()); }
+
+private:
+
+    VulkanWrappers::Device* m_Device;
+    VkSemaphore             m_Semaphore;
+
+    // Held across value assignment and submission, signal operations have to reach the queue in increasing order.
+    std::mutex m_SubmitMutex;
+
+    std::atomic<uint64_t> m_SubmittedValue;
+
+    // Last value observed as signaled, saves a query for values that are long complete.
+    mutable std::atomic<uint64_t> m_CompletedValue;
+};
+
+#endif
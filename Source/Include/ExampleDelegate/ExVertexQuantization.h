@@ -0,0 +1,25 @@
+#ifndef VERTEX_QUANTIZATION
+#define VERTEX_QUANTIZATION
+
+#include "PxrUsage.h"
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+// Compact device formats of the vertex streams, decoded in Mesh.vert (kIsQuantized). Every format is stored as
+// 32-bit words, so that it lives in the geometry heap next to the full-precision streams.
+
+/// Quantize positions to 16-bit unorm relative to their bounds: a header of six floats (the bounds minimum and
+/// size), then the xyz triples packed tightly, two components per word. 6 bytes a position instead of 12, with
+/// a precision of 1 / 65535 of the bounds along each axis.
+///   \return The encoded stream, empty without positions.
+VtUIntArray ExQuantizePositions(VtVec3fArray const& positions, GfRange3f const& bounds);
+
+/// Octahedral-encode unit vectors as 2x16-bit snorm, one word (4 bytes instead of 12) each.
+///   \return The encoded stream, empty without vectors.
+VtUIntArray ExEncodeNormals(VtVec3fArray const& normals);
+
+/// Convert triples (i.e. colors) to half floats, packed tightly two components per word. 6 bytes a triple instead of 12.
+///   \return The encoded stream, empty without values.
+VtUIntArray ExEncodeHalf3(VtVec3fArray const& values);
+
+#endif
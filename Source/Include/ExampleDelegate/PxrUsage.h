@@ -9,6 +9,12 @@
 #include <pxr/pxr.h>
 #include <pxr/base/tf/staticTokens.h>
 
+// Math
+#include <pxr/base/gf/bbox3d.h>
+#include <pxr/base/gf/half.h>
+#include <pxr/base/gf/range3f.h>
+#include <pxr/base/gf/vec4f.h>
+
 // Imaging (Hydra)
 #include <pxr/imaging/hd/rendererPlugin.h>
 #include <pxr/imaging/hd/rendererPluginRegistry.h>
@@ -19,5 +25,9 @@
 #include <pxr/imaging/hd/renderBuffer.h>
 #include <pxr/imaging/hd/task.h>
 #include <pxr/imaging/hd/mesh.h>
+#include <pxr/imaging/hd/meshUtil.h>
+#include <pxr/imaging/hd/meshTopology.h>
+#include <pxr/imaging/hd/vertexAdjacency.h>
+#include <pxr/imaging/hd/smoothNormals.h>
 
 #endif
\ No newline at end of file
@@ -0,0 +1,13 @@
+#version 450
+
+// Emit the new sample as-is. The running average is formed by blending with the accumulation target,
+// weighted by the blend constants (1 / sample count).
+
+layout (set = 0, binding = 0) uniform sampler2D sampleColor;
+
+layout (location = 0) out vec4 outColor;
+
+void main()
+{
+    outColor = texelFetch(sampleColor, ivec2(gl_FragCoord.xy), 0);
+}
@@ -0,0 +1,149 @@
+#version 450
+
+// Vertex-pulling mesh shader. Every mesh and its instances live in one geometry heap. The instance
+// index selects an instance in the heap, the instance names its draw slot, and the slot's draw
+// record says where the mesh streams are.
+
+struct DrawRecord
+{
+    uint positionOffset;
+    uint normalOffset;
+    uint colorOffset;
+    uint firstIndex;
+    uint indexCount;
+    int  primId;
+    uint firstInstance;
+    uint instanceCount;
+};
+
+// Quantized transform, see ExInstance.
+struct Instance
+{
+    float translationX, translationY, translationZ;
+    uint  drawSlot;
+    uint  rotation[2];
+    uint  scale[2];
+};
+
+layout (std430, set = 0, binding = 0) readonly buffer GeometryHeap { float geometry[];   };
+layout (std430, set = 0, binding = 1) readonly buffer DrawRecords  { DrawRecord records[]; };
+layout (std430, set = 0, binding = 2) readonly buffer Transforms   { mat4 transforms[];    };
+layout (std430, set = 0, binding = 3) readonly buffer Instances    { Instance instances[]; };
+
+// Variant features (see kMeshFeatureNormals), resolved when the pipeline is compiled.
+layout (constant_id = 0) const bool kHasNormals      = true;
+layout (constant_id = 1) const bool kHasVertexColors = false;
+layout (constant_id = 2) const bool kIsInstanced     = true;
+layout (constant_id = 3) const bool kIsQuantized     = false;
+
+// Words ahead of quantized positions: the bounds minimum and size they are relative to (see ExQuantizePositions).
+const uint kPositionHeaderWords = 6u;
+
+layout (push_constant) uniform PushConstants
+{
+    mat4 viewProjection;
+};
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) flat out int outPrimId;
+layout (location = 2) out vec3 outColor;
+
+vec3 LoadVec3(uint offset, uint index)
+{
+    uint i = offset + 3u * index;
+    return vec3(geometry[i + 0u], geometry[i + 1u], geometry[i + 2u]);
+}
+
+// Element of a stream of 16-bit triples packed two components per word: an even element starts on a word, an
+// odd one half way into one.
+uvec2 LoadPackedWords(uint offset, uint index)
+{
+    uint word = offset + ((3u * index) >> 1u);
+    return uvec2(floatBitsToUint(geometry[word]), floatBitsToUint(geometry[word + 1u]));
+}
+
+vec3 LoadUnorm16x3(uint offset, uint index)
+{
+    uvec2 words = LoadPackedWords(offset, index);
+    vec2  a     = unpackUnorm2x16(words.x);
+    vec2  b     = unpackUnorm2x16(words.y);
+
+    return (index & 1u) == 0u ? vec3(a, b.x) : vec3(a.y, b);
+}
+
+vec3 LoadHalf3(uint offset, uint index)
+{
+    uvec2 words = LoadPackedWords(offset, index);
+    vec2  a     = unpackHalf2x16(words.x);
+    vec2  b     = unpackHalf2x16(words.y);
+
+    return (index & 1u) == 0u ? vec3(a, b.x) : vec3(a.y, b);
+}
+
+vec3 DecodeOctahedral(vec2 e)
+{
+    // Unfold the lower half of the octahedron.
+    vec3  n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+
+    return normalize(n);
+}
+
+vec3 LoadPosition(uint offset, uint index)
+{
+    if (!kIsQuantized)
+        return LoadVec3(offset, index);
+
+    return LoadVec3(offset, 0u) + LoadVec3(offset, 1u) * LoadUnorm16x3(offset + kPositionHeaderWords, index);
+}
+
+vec3 LoadNormal(uint offset, uint index)
+{
+    return kIsQuantized ? DecodeOctahedral(unpackSnorm2x16(floatBitsToUint(geometry[offset + index]))) : LoadVec3(offset, index);
+}
+
+vec3 LoadColor(uint offset, uint index)
+{
+    return kIsQuantized ? LoadHalf3(offset, index) : LoadVec3(offset, index);
+}
+
+vec3 RotateByQuat(vec4 q, vec3 v)
+{
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main()
+{
+    uint drawSlot = instances[gl_InstanceIndex].drawSlot;
+
+    DrawRecord record = records[drawSlot];
+    mat4       model  = transforms[drawSlot];
+
+    // Indices are stored unbiased, so the vertex index addresses the mesh's own streams directly.
+    vec3 position = LoadPosition(record.positionOffset, gl_VertexIndex);
+    vec3 normal   = kHasNormals ? LoadNormal(record.normalOffset, gl_VertexIndex) : vec3(0.0, 0.0, 1.0);
+
+    vec3 worldPosition = (model * vec4(position, 1.0)).xyz;
+    vec3 worldNormal   = mat3(model) * normal;
+
+    // The mesh transform applies first, then the instance (a lone identity instance otherwise).
+    if (kIsInstanced)
+    {
+        Instance instance = instances[gl_InstanceIndex];
+
+        vec4 rotation    = normalize(vec4(unpackSnorm2x16(instance.rotation[0]), unpackSnorm2x16(instance.rotation[1])));
+        vec3 scale       = vec3(unpackHalf2x16(instance.scale[0]), unpackHalf2x16(instance.scale[1]).x);
+        vec3 translation = vec3(instance.translationX, instance.translationY, instance.translationZ);
+
+        worldPosition = RotateByQuat(rotation, scale * worldPosition) + translation;
+        worldNormal   = RotateByQuat(rotation, worldNormal / scale);
+    }
+
+    gl_Position = viewProjection * vec4(worldPosition, 1.0);
+    outNormal   = worldNormal;
+    outPrimId   = record.primId;
+    outColor    = kHasVertexColors ? LoadColor(record.colorOffset, gl_VertexIndex) : vec3(1.0);
+}
@@ -0,0 +1,23 @@
+#version 450
+
+layout (location = 0) in  vec3 inNormal;
+layout (location = 1) flat in int inPrimId;
+layout (location = 2) in  vec3 inColor;
+
+layout (location = 0) out vec4 outColor;
+layout (location = 1) out int  outPrimId;
+
+// Variant features, see Mesh.vert.
+layout (constant_id = 0) const bool kHasNormals      = true;
+layout (constant_id = 1) const bool kHasVertexColors = false;
+
+void main()
+{
+    // Simple two-sided key light so shapes read without any lights in the scene (unshaded without normals).
+    float L = kHasNormals ? abs(dot(normalize(inNormal), normalize(vec3(0.3, 0.8, 0.5)))) : 1.0;
+
+    vec3 albedo = kHasVertexColors ? inColor : vec3(1.0);
+
+    outColor  = vec4(albedo * (0.18 + 0.72 * L), 1.0);
+    outPrimId = inPrimId;
+}
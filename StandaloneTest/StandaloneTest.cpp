@@ -117,6 +117,9 @@ int main(int argc, char **argv, char **envp)
     // Handle to current frame to write commands to. 
     Frame frame;
 
+    // The delegate reuses what it recorded into frame N once it is handed frame N + 3, so no more than 3 frames may be in flight.
+    uint64_t frameIndex = 0u;
+
     while (window.NextFrame(&device, &frame))
     {
         // Forward the current backbuffer and commandbuffer to the delegate. 
@@ -124,6 +127,7 @@ int main(int argc, char **argv, char **envp)
         // There might be a simpler way to manage this by writing my own HdTask, but
         // it would require sacrificing the simplicity that HdxTaskController offers.
         renderDelegate->SetRenderSetting(TfToken("CurrentFrame"), VtValue(&frame));
+        renderDelegate->SetRenderSetting(TfToken("CurrentFrameIndex"), VtValue(frameIndex++));
 
         // Invoke Hydra!
         auto renderTasks = taskController.GetRenderingTasks();